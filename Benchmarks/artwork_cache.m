@@ -0,0 +1,213 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Times artwork cache lookups and checks the cache against a stub provider:
+// misses reach the provider once, hits in memory and on disk do not, tracks
+// without artwork are cached too, tracks the provider cannot resolve are not,
+// and a newer modification date invalidates the artwork, also after the
+// cache is reopened from its directory.
+
+#import "../SIArtworkCache.h"
+#import "../SIClock.h"
+
+static const NSUInteger SIBenchmarkIterations = 1000000;
+
+// Serves whatever artwork and modification date it was last given, counting
+// requests, unless told the track no longer resolves.
+@interface SIStubArtworkProvider : NSObject <SIArtworkProvider> {
+    NSData *data;
+    NSDate *modificationDate;
+    BOOL unresolved;
+    unsigned long long requestCount;
+}
+
+@property (nonatomic, retain) NSData *data;
+@property (nonatomic, retain) NSDate *modificationDate;
+@property (nonatomic, assign) BOOL unresolved;
+
+@end
+
+@implementation SIStubArtworkProvider
+
+@synthesize data;
+@synthesize modificationDate;
+@synthesize unresolved;
+
+- (void)dealloc {
+    [data release];
+    [modificationDate release];
+
+    [super dealloc];
+}
+
+- (BOOL)getArtworkData:(NSData **)someData
+      modificationDate:(NSDate **)aModificationDate
+       appleEventCount:(unsigned long long *)appleEventCount
+       forPersistentID:(NSString *)persistentID {
+    requestCount++;
+
+    if (appleEventCount) {
+        *appleEventCount = 1;
+    }
+
+    if (unresolved) {
+        return NO;
+    }
+
+    if (aModificationDate) {
+        *aModificationDate = modificationDate;
+    }
+
+    *someData = data;
+
+    return YES;
+}
+
+- (unsigned long long)appleEventCount {
+    return requestCount;
+}
+
+@end
+
+static BOOL SIBenchmarkFailed;
+
+static void SIBenchmarkCheck(BOOL condition, const char *description) {
+    if (!condition) {
+        fprintf(stderr, "artwork cache: %s\n", description);
+        SIBenchmarkFailed = YES;
+    }
+}
+
+static NSData *SIBenchmarkArtwork(unsigned char fill) {
+    NSMutableData *data = [NSMutableData dataWithLength:16 * 1024];
+    memset([data mutableBytes], fill, [data length]);
+
+    return data;
+}
+
+static SIArtworkCache *SIBenchmarkOpenCache(SIStubArtworkProvider *provider, NSString *directory) {
+    return [[[SIArtworkCache alloc] initWithProvider:provider directory:directory capacity:2] autorelease];
+}
+
+int main(int argc, char *argv[]) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent:@"itunesnotify-artwork-cache"];
+    SIStubArtworkProvider *provider = [[[SIStubArtworkProvider alloc] init] autorelease];
+    NSData *firstArtwork = SIBenchmarkArtwork(1);
+    NSData *secondArtwork = SIBenchmarkArtwork(2);
+    NSDate *earlier = [NSDate dateWithTimeIntervalSinceReferenceDate:1000];
+    NSDate *modified = [NSDate dateWithTimeIntervalSinceReferenceDate:2000];
+    NSDate *later = [NSDate dateWithTimeIntervalSinceReferenceDate:3000];
+    NSData *data = nil;
+
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:NULL];
+
+    SIArtworkCache *cache = SIBenchmarkOpenCache(provider, directory);
+    [provider setData:firstArtwork];
+    [provider setModificationDate:earlier];
+
+    SIBenchmarkCheck(![cache getCachedArtworkData:&data forPersistentID:@"1" modificationDate:nil],
+                     "an empty cache hit");
+    SIBenchmarkCheck([[cache artworkDataForPersistentID:@"1" modificationDate:nil] isEqualToData:firstArtwork]
+                     && [provider appleEventCount] == 1,
+                     "a miss did not fetch the artwork once");
+    SIBenchmarkCheck([[cache artworkDataForPersistentID:@"1" modificationDate:earlier] isEqualToData:firstArtwork]
+                     && [provider appleEventCount] == 1,
+                     "a hit with the same modification date reached the provider");
+
+    [provider setData:secondArtwork];
+    [provider setModificationDate:modified];
+
+    SIBenchmarkCheck([cache getCachedArtworkData:&data forPersistentID:@"1" modificationDate:nil]
+                     && [data isEqualToData:firstArtwork],
+                     "a lookup without a modification date missed");
+    SIBenchmarkCheck([[cache artworkDataForPersistentID:@"1" modificationDate:modified] isEqualToData:secondArtwork]
+                     && [provider appleEventCount] == 2,
+                     "a newer modification date did not fetch the artwork again");
+    SIBenchmarkCheck([cache getCachedArtworkData:&data forPersistentID:@"1" modificationDate:earlier]
+                     && [data isEqualToData:secondArtwork],
+                     "an older modification date invalidated the artwork");
+
+    [provider setData:nil];
+    SIBenchmarkCheck(![cache artworkDataForPersistentID:@"2" modificationDate:nil]
+                     && [cache getCachedArtworkData:&data forPersistentID:@"2" modificationDate:nil] && !data
+                     && [provider appleEventCount] == 3,
+                     "a track without artwork was not cached");
+
+    // A third track pushes the first out of memory; it is still on disk.
+    [provider setData:firstArtwork];
+    [cache artworkDataForPersistentID:@"3" modificationDate:nil];
+    NSUInteger diskHits = [cache diskHits];
+    SIBenchmarkCheck([cache getCachedArtworkData:&data forPersistentID:@"1" modificationDate:modified]
+                     && [data isEqualToData:secondArtwork]
+                     && [cache diskHits] == diskHits + 1,
+                     "an evicted track was not found on disk");
+
+    [cache removeArtworkForPersistentID:@"3"];
+    SIBenchmarkCheck(![cache getCachedArtworkData:&data forPersistentID:@"3" modificationDate:nil],
+                     "a removed track hit");
+
+    [provider setUnresolved:YES];
+    SIBenchmarkCheck(![cache artworkDataForPersistentID:@"4" modificationDate:nil]
+                     && ![cache getCachedArtworkData:&data forPersistentID:@"4" modificationDate:nil],
+                     "a track the provider could not resolve was cached");
+    [provider setUnresolved:NO];
+
+    uint64_t start = SIMonotonicNanoseconds();
+    for (NSUInteger i = 0; i < SIBenchmarkIterations; i++) {
+        NSAutoreleasePool *iterationPool = [[NSAutoreleasePool alloc] init];
+        [cache getCachedArtworkData:&data forPersistentID:@"1" modificationDate:modified];
+        [iterationPool drain];
+    }
+    printf("artwork cache memory hit %8.1f ns/lookup\n", (double)(SIMonotonicNanoseconds() - start) / SIBenchmarkIterations);
+
+    // Once reopening replays the index log, and once more reads the index it
+    // was folded into.
+    for (NSUInteger reopenCount = 0; reopenCount < 2; reopenCount++) {
+        cache = SIBenchmarkOpenCache(provider, directory);
+
+        SIBenchmarkCheck([cache getCachedArtworkData:&data forPersistentID:@"1" modificationDate:modified]
+                         && [data isEqualToData:secondArtwork],
+                         "a reopened cache lost the artwork");
+        SIBenchmarkCheck([cache getCachedArtworkData:&data forPersistentID:@"2" modificationDate:nil] && !data,
+                         "a reopened cache lost a track without artwork");
+        SIBenchmarkCheck(![cache getCachedArtworkData:&data forPersistentID:@"3" modificationDate:nil],
+                         "a reopened cache brought back a removed track");
+        SIBenchmarkCheck(![cache getCachedArtworkData:&data forPersistentID:@"1" modificationDate:later],
+                         "a reopened cache ignored a newer modification date");
+    }
+
+    [cache removeAllArtwork];
+    cache = SIBenchmarkOpenCache(provider, directory);
+    SIBenchmarkCheck(![cache getCachedArtworkData:&data forPersistentID:@"1" modificationDate:nil]
+                     && ![cache getCachedArtworkData:&data forPersistentID:@"2" modificationDate:nil],
+                     "removing all artwork did not survive reopening");
+
+    printf("artwork cache: %lu memory hits, %lu disk hits, %lu misses, %llu provider requests\n",
+           (unsigned long)[cache memoryHits], (unsigned long)[cache diskHits], (unsigned long)[cache misses],
+           [provider appleEventCount]);
+
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:NULL];
+    [pool drain];
+
+    return SIBenchmarkFailed ? 1 : 0;
+}
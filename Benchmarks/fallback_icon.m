@@ -0,0 +1,91 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Compares rendering the player icon on every event, as the notifier used to,
+// with the icon SIFallbackIcon renders once.
+
+#import "../SIClock.h"
+#import "../SIFallbackIcon.h"
+#import "../SIProcessMemory.h"
+
+#ifdef __APPLE__
+#import "../SIITunesMetadataProvider.h"
+#else
+#import "../SIFileMetadataProvider.h"
+#endif
+
+static const NSUInteger SIBenchmarkIterations = 200;
+
+static void SIBenchmarkReport(NSString *name, uint64_t elapsed, unsigned long long bytes, size_t residentBefore) {
+    size_t residentAfter = SIResidentMemoryBytes();
+
+    printf("fallback icon %-10s %10.3f ms/event %10llu bytes/event  rss %+8.1f MB\n",
+           [name UTF8String],
+           elapsed / 1e6 / SIBenchmarkIterations,
+           bytes / SIBenchmarkIterations,
+           ((double)residentAfter - (double)residentBefore) / (1024 * 1024));
+}
+
+int main(int argc, char *argv[]) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+#ifdef __APPLE__
+    id<SIMetadataProvider> metadataProvider = [[[SIITunesMetadataProvider alloc] init] autorelease];
+#else
+    NSString *library = [NSTemporaryDirectory() stringByAppendingPathComponent:@"itunesnotify-fallback-icon"];
+    [SIFileMetadataProvider writeSyntheticLibraryToDirectory:library trackCount:1 albumTrackCount:1 artworkLength:0 error:NULL];
+    [[NSMutableData dataWithLength:1024 * 1024] writeToFile:[library stringByAppendingPathComponent:@"Icon.png"] atomically:YES];
+    id<SIMetadataProvider> metadataProvider = [[[SIFileMetadataProvider alloc] initWithDirectory:library error:NULL] autorelease];
+#endif
+
+    SIArtworkNormalizer *normalizer = [[[SIArtworkNormalizer alloc] initWithIconSize:128 byteBudget:32768] autorelease];
+    SIFallbackIcon *fallbackIcon = [[[SIFallbackIcon alloc] initWithMetadataProvider:metadataProvider
+                                                                          normalizer:normalizer] autorelease];
+    unsigned long long bytes = 0;
+    size_t residentBefore = SIResidentMemoryBytes();
+    uint64_t start = SIMonotonicNanoseconds();
+
+    for (NSUInteger i = 0; i < SIBenchmarkIterations; i++) {
+        NSAutoreleasePool *iterationPool = [[NSAutoreleasePool alloc] init];
+        bytes += [[metadataProvider playerIconData] length];
+        [iterationPool drain];
+    }
+
+    SIBenchmarkReport(@"per-event", SIMonotonicNanoseconds() - start, bytes, residentBefore);
+
+    bytes = 0;
+    residentBefore = SIResidentMemoryBytes();
+    start = SIMonotonicNanoseconds();
+
+    for (NSUInteger i = 0; i < SIBenchmarkIterations; i++) {
+        NSAutoreleasePool *iterationPool = [[NSAutoreleasePool alloc] init];
+        bytes += [[fallbackIcon iconData] length];
+        [iterationPool drain];
+    }
+
+    SIBenchmarkReport(@"cached", SIMonotonicNanoseconds() - start, bytes, residentBefore);
+    printf("fallback icon renders: %lu\n", (unsigned long)[fallbackIcon renderCount]);
+
+    [pool drain];
+
+    return 0;
+}
@@ -0,0 +1,100 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Checks the text SINotificationFormatter renders for a few templates, then
+// times the default title and body rendered into strings, as the pipeline
+// renders them for every notification, and fails if the formatters' buffers
+// grow once they have warmed up.
+
+#import "../SIClock.h"
+#import "../SINotificationFormatter.h"
+
+static const NSUInteger SIBenchmarkIterations = 1000000;
+
+static BOOL SIBenchmarkFailed;
+
+static void SIBenchmarkCheckRendering(NSString *templateString, NSDictionary *userInfo, NSString *expected) {
+    SINotificationFormatter *formatter = [SINotificationFormatter formatterWithTemplate:templateString];
+    NSString *rendered = [formatter stringForUserInfo:userInfo];
+    NSUInteger length = [formatter renderUserInfo:userInfo];
+
+    if (![rendered isEqualToString:expected]
+        || ![[NSString stringWithCharacters:[formatter characters] length:length] isEqualToString:expected]) {
+        fprintf(stderr, "format: \"%s\" rendered \"%s\", expected \"%s\"\n",
+                [templateString UTF8String], [rendered UTF8String], [expected UTF8String]);
+        SIBenchmarkFailed = YES;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSDictionary *userInfo = @{
+        @"Name"         : @"Everything In Its Right Place",
+        @"Artist"       : @"Radiohead",
+        @"Album"        : @"Kid A",
+        @"Year"         : @2000,
+        @"Stream Title" : @"Idioteque",
+        @"Player State" : @"Playing"
+    };
+
+    SIBenchmarkCheckRendering(@"{name}", userInfo, @"Everything In Its Right Place");
+    SIBenchmarkCheckRendering(@"{artist}\n{album}", userInfo, @"Radiohead\nKid A");
+    SIBenchmarkCheckRendering(@"{artist} — {album} ({year})", userInfo, @"Radiohead — Kid A (2000)");
+    SIBenchmarkCheckRendering(@"{stream}", userInfo, @"Idioteque");
+    SIBenchmarkCheckRendering(@"{Player State}: {title}", userInfo, @"Playing: Everything In Its Right Place");
+    SIBenchmarkCheckRendering(@"{{{name}}}", userInfo, @"{Everything In Its Right Place}");
+    SIBenchmarkCheckRendering(@"{{name}} }}{{", userInfo, @"{name} }{");
+    SIBenchmarkCheckRendering(@"{name}{Kind}!", userInfo, @"Everything In Its Right Place!");
+    SIBenchmarkCheckRendering(@"{composer}", userInfo, @"");
+    SIBenchmarkCheckRendering(@"{name", userInfo, @"{name");
+    SIBenchmarkCheckRendering(@"", userInfo, @"");
+
+    SINotificationFormatter *titleFormatter = [SINotificationFormatter formatterWithTemplate:@"{name}"];
+    SINotificationFormatter *bodyFormatter = [SINotificationFormatter formatterWithTemplate:@"{artist}\n{album}"];
+    NSUInteger length = [[titleFormatter stringForUserInfo:userInfo] length] + [[bodyFormatter stringForUserInfo:userInfo] length];
+    NSUInteger allocationCount = [titleFormatter allocationCount] + [bodyFormatter allocationCount];
+    NSUInteger totalLength = 0;
+    uint64_t start = SIMonotonicNanoseconds();
+
+    for (NSUInteger i = 0; i < SIBenchmarkIterations; i++) {
+        NSAutoreleasePool *iterationPool = [[NSAutoreleasePool alloc] init];
+        totalLength += [[titleFormatter stringForUserInfo:userInfo] length];
+        totalLength += [[bodyFormatter stringForUserInfo:userInfo] length];
+        [iterationPool drain];
+    }
+
+    uint64_t elapsed = SIMonotonicNanoseconds() - start;
+    NSUInteger steadyStateAllocations = [titleFormatter allocationCount] + [bodyFormatter allocationCount] - allocationCount;
+
+    printf("format title and body %8.1f ns/event %lu buffer allocations/event\n",
+           (double)elapsed / SIBenchmarkIterations,
+           (unsigned long)(steadyStateAllocations / SIBenchmarkIterations));
+
+    [pool drain];
+
+    if (steadyStateAllocations || totalLength != length * SIBenchmarkIterations) {
+        fprintf(stderr, "format: %lu buffer allocations in steady state\n", (unsigned long)steadyStateAllocations);
+        return 1;
+    }
+
+    return SIBenchmarkFailed ? 1 : 0;
+}
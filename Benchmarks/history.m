@@ -0,0 +1,245 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Feeds a stream of track changes through the play history, as the pipeline
+// does on every event, and scrobbles the plays to a stand-in HTTP endpoint
+// on the loopback interface. Reports what observing an event costs while
+// the journal is written and scrobbled in the background, and fails unless
+// every play reaches the endpoint in full batches, survives reopening the
+// journal and is compacted away once exported.
+
+#import <arpa/inet.h>
+#import <netinet/in.h>
+#import <pthread.h>
+#import <stdatomic.h>
+#import <sys/socket.h>
+#import <unistd.h>
+#import "../SIClock.h"
+#import "../SILatencyHistogram.h"
+#import "../SIPlayHistory.h"
+
+static const NSUInteger SIBenchmarkPlayCount = 20000;
+static const NSUInteger SIBenchmarkAlbumTrackCount = 12;
+static const NSUInteger SIBenchmarkScrobbleBatchSize = 50;
+static const uint64_t SIBenchmarkMaximumObserveLatency = 100000;
+
+static atomic_ulong SIStandInPlayCount;
+static atomic_ulong SIStandInRequestCount;
+
+// Reads one request, counts the plays in its body and answers 200.
+static void SIStandInHandleClient(int clientSocket) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSMutableData *request = [NSMutableData data];
+    NSData *separator = [NSData dataWithBytes:"\r\n\r\n" length:4];
+    NSRange headerEnd = NSMakeRange(NSNotFound, 0);
+    NSUInteger contentLength = 0;
+    char buffer[16384];
+
+    for (;;) {
+        ssize_t readLength = read(clientSocket, buffer, sizeof(buffer));
+
+        if (readLength <= 0) {
+            break;
+        }
+
+        [request appendBytes:buffer length:(NSUInteger)readLength];
+
+        if (headerEnd.location == NSNotFound) {
+            headerEnd = [request rangeOfData:separator options:0 range:NSMakeRange(0, [request length])];
+
+            if (headerEnd.location != NSNotFound) {
+                NSString *header = [[[NSString alloc] initWithData:[request subdataWithRange:NSMakeRange(0, headerEnd.location)]
+                                                          encoding:NSISOLatin1StringEncoding] autorelease];
+
+                for (NSString *line in [header componentsSeparatedByString:@"\r\n"]) {
+                    if ([[line lowercaseString] hasPrefix:@"content-length:"]) {
+                        contentLength = (NSUInteger)[[line substringFromIndex:15] integerValue];
+                    }
+                }
+            }
+        }
+
+        if (headerEnd.location != NSNotFound && [request length] >= NSMaxRange(headerEnd) + contentLength) {
+            break;
+        }
+    }
+
+    if (headerEnd.location != NSNotFound) {
+        NSData *body = [request subdataWithRange:NSMakeRange(NSMaxRange(headerEnd), [request length] - NSMaxRange(headerEnd))];
+        NSDictionary *scrobble = [NSJSONSerialization JSONObjectWithData:body options:0 error:NULL];
+
+        atomic_fetch_add(&SIStandInPlayCount, [[scrobble objectForKey:@"plays"] count]);
+        atomic_fetch_add(&SIStandInRequestCount, 1);
+    }
+
+    const char *response = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+    write(clientSocket, response, strlen(response));
+    close(clientSocket);
+    [pool drain];
+}
+
+static void *SIStandInServe(void *argument) {
+    int listeningSocket = (int)(intptr_t)argument;
+
+    for (;;) {
+        int clientSocket = accept(listeningSocket, NULL, NULL);
+
+        if (clientSocket >= 0) {
+            SIStandInHandleClient(clientSocket);
+        }
+    }
+
+    return NULL;
+}
+
+// Listens on an ephemeral loopback port and returns it, or zero.
+static unsigned short SIStandInStart(void) {
+    int listeningSocket = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address;
+    socklen_t addressLength = sizeof(address);
+    pthread_t thread;
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (listeningSocket < 0
+        || bind(listeningSocket, (struct sockaddr *)&address, sizeof(address)) != 0
+        || listen(listeningSocket, 16) != 0
+        || getsockname(listeningSocket, (struct sockaddr *)&address, &addressLength) != 0
+        || pthread_create(&thread, NULL, SIStandInServe, (void *)(intptr_t)listeningSocket) != 0) {
+        return 0;
+    }
+
+    return ntohs(address.sin_port);
+}
+
+int main(int argc, char *argv[]) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSString *directory = [NSTemporaryDirectory() stringByAppendingPathComponent:@"itunesnotify-history"];
+    NSError *error = nil;
+
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:NULL];
+
+    unsigned short port = SIStandInStart();
+    if (!port) {
+        perror("history: cannot start the stand-in endpoint");
+        return 1;
+    }
+
+    SIPlayJournal *journal = [[[SIPlayJournal alloc] initWithDirectory:directory error:&error] autorelease];
+    if (!journal) {
+        fprintf(stderr, "history: cannot open %s: %s\n", [directory UTF8String], [[error description] UTF8String]);
+        return 1;
+    }
+
+    NSURL *URL = [NSURL URLWithString:[NSString stringWithFormat:@"http://127.0.0.1:%u/scrobble", port]];
+    SIScrobbleQueue *scrobbleQueue = [[[SIScrobbleQueue alloc] initWithJournal:journal
+                                                                           URL:URL
+                                                                    cursorPath:[directory stringByAppendingPathComponent:@"Scrobble.cursor"]] autorelease];
+    [scrobbleQueue setBatchSize:SIBenchmarkScrobbleBatchSize];
+
+    SIPlayHistory *history = [[[SIPlayHistory alloc] initWithJournal:journal] autorelease];
+    [history setScrobbleQueue:scrobbleQueue];
+
+    SILatencyHistogram *latency = calloc(1, sizeof(SILatencyHistogram));
+    uint64_t start = SIMonotonicNanoseconds();
+
+    for (NSUInteger i = 0; i < SIBenchmarkPlayCount; i++) {
+        NSAutoreleasePool *trackPool = [[NSAutoreleasePool alloc] init];
+        NSUInteger album = i / SIBenchmarkAlbumTrackCount;
+        SITrack *track = [SITrack trackWithUserInfo:@{
+            @"PersistentID" : @(i + 1),
+            @"Name"         : [NSString stringWithFormat:@"Track %lu", (unsigned long)i],
+            @"Artist"       : [NSString stringWithFormat:@"Artist %lu", (unsigned long)(album / 4)],
+            @"Album"        : [NSString stringWithFormat:@"Album %lu", (unsigned long)album],
+            @"Player State" : @"Playing"
+        }];
+
+        uint64_t observeStart = SIMonotonicNanoseconds();
+        [history observeTrack:track];
+        SILatencyHistogramRecord(latency, SIMonotonicNanoseconds() - observeStart);
+        [trackPool drain];
+    }
+
+    uint64_t elapsed = SIMonotonicNanoseconds() - start;
+
+    [history stop];
+    [scrobbleQueue flush];
+    [scrobbleQueue waitUntilIdle];
+
+    unsigned long postedPlays = atomic_load(&SIStandInPlayCount);
+    unsigned long requests = atomic_load(&SIStandInRequestCount);
+    unsigned long expectedRequests = (SIBenchmarkPlayCount + SIBenchmarkScrobbleBatchSize - 1) / SIBenchmarkScrobbleBatchSize;
+
+    printf("history %lu plays: %10.0f events/s  observe p50 %.2f us  p99 %.2f us  max %.2f us\n",
+           (unsigned long)SIBenchmarkPlayCount,
+           SIBenchmarkPlayCount / (elapsed / 1e9),
+           SILatencyHistogramPercentile(latency, 50) / 1e3,
+           SILatencyHistogramPercentile(latency, 99) / 1e3,
+           SILatencyHistogramMaximum(latency) / 1e3);
+    printf("history %s\n", [[history statisticsSummary] UTF8String]);
+    printf("history %s; stand-in received %lu plays in %lu requests\n",
+           [[scrobbleQueue statisticsSummary] UTF8String], postedPlays, requests);
+
+    BOOL failed = NO;
+    uint64_t observeLatency = SILatencyHistogramPercentile(latency, 99);
+    free(latency);
+
+    if (observeLatency > SIBenchmarkMaximumObserveLatency) {
+        fprintf(stderr, "history: observing an event took %.2f us at p99, expected at most %.2f\n",
+                observeLatency / 1e3, SIBenchmarkMaximumObserveLatency / 1e3);
+        failed = YES;
+    }
+
+    if (postedPlays != SIBenchmarkPlayCount || requests != expectedRequests) {
+        fprintf(stderr, "history: expected %lu plays in %lu requests\n", (unsigned long)SIBenchmarkPlayCount, expectedRequests);
+        failed = YES;
+    }
+
+    SIPlayJournal *reopened = [[[SIPlayJournal alloc] initWithDirectory:directory error:&error] autorelease];
+    NSArray *lastPlays = [reopened playsAfterSequence:SIBenchmarkPlayCount - 1 limit:1];
+
+    if ([reopened playCount] != SIBenchmarkPlayCount
+        || ![[[lastPlays lastObject] objectForKey:@"name"] isEqual:[NSString stringWithFormat:@"Track %lu", (unsigned long)SIBenchmarkPlayCount - 1]]) {
+        fprintf(stderr, "history: reopened journal holds %lu plays\n", (unsigned long)[reopened playCount]);
+        failed = YES;
+    }
+
+    uint64_t future = (uint64_t)(([[NSDate date] timeIntervalSince1970] + 1) * 1000);
+    [reopened compactRemovingPlaysBefore:future keepingPlaysAfterSequence:[scrobbleQueue exportedSequence] error:NULL];
+    reopened = [[[SIPlayJournal alloc] initWithDirectory:directory error:&error] autorelease];
+
+    printf("history compacted: %lu plays, %lu strings, next sequence %llu\n",
+           (unsigned long)[reopened playCount], (unsigned long)[reopened stringCount],
+           (unsigned long long)[reopened lastSequence] + 1);
+
+    if ([reopened playCount] || [reopened stringCount] || [reopened lastSequence] != SIBenchmarkPlayCount) {
+        fprintf(stderr, "history: compaction kept exported plays or lost the sequence\n");
+        failed = YES;
+    }
+
+    [[NSFileManager defaultManager] removeItemAtPath:directory error:NULL];
+    [pool drain];
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,136 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Times a pipeline stage with metrics off, on and tracing, against the same
+// loop without instrumentation, and fails if turning metrics off does not
+// bring the cost back to near zero. Also checks that stages recorded on
+// several threads at once all show up in the collected histograms.
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../SIClock.h"
+#include "../SIMetrics.h"
+
+static const uint64_t SIBenchmarkIterations = 20000000;
+static const unsigned SIBenchmarkRounds = 5;
+static const double SIBenchmarkMaximumDisabledOverhead = 2.0;
+static const unsigned SIBenchmarkThreadCount = 4;
+static const uint64_t SIBenchmarkThreadIterations = 100000;
+
+static volatile uint64_t SIBenchmarkSink;
+
+static double SIBenchmarkBaseline(void) {
+    uint64_t start = SIMonotonicNanoseconds();
+
+    for (uint64_t i = 0; i < SIBenchmarkIterations; i++) {
+        SIBenchmarkSink += i;
+    }
+
+    return (double)(SIMonotonicNanoseconds() - start) / SIBenchmarkIterations;
+}
+
+static double SIBenchmarkInstrumented(void) {
+    uint64_t start = SIMonotonicNanoseconds();
+
+    for (uint64_t i = 0; i < SIBenchmarkIterations; i++) {
+        uint64_t stageStart = SIMetricsBegin();
+        SIBenchmarkSink += i;
+        SIMetricsEnd(SIMetricsStageFormat, stageStart);
+    }
+
+    return (double)(SIMonotonicNanoseconds() - start) / SIBenchmarkIterations;
+}
+
+// The fastest of a few rounds, to keep scheduling noise out.
+static double SIBenchmarkFastest(double (*benchmark)(void)) {
+    double fastest = benchmark();
+
+    for (unsigned i = 1; i < SIBenchmarkRounds; i++) {
+        double elapsed = benchmark();
+
+        if (elapsed < fastest) {
+            fastest = elapsed;
+        }
+    }
+
+    return fastest;
+}
+
+static void *SIBenchmarkRecorder(void *argument) {
+    for (uint64_t i = 0; i < SIBenchmarkThreadIterations; i++) {
+        SIMetricsEnd(SIMetricsStagePost, SIMetricsBegin());
+        SIMetricsCount(SIMetricsCounterNotifications);
+    }
+
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    SIMetricsSetLevel(SIMetricsOff);
+    double baseline = SIBenchmarkFastest(SIBenchmarkBaseline);
+    double disabled = SIBenchmarkFastest(SIBenchmarkInstrumented);
+
+    SIMetricsSetLevel(SIMetricsOn);
+    double enabled = SIBenchmarkFastest(SIBenchmarkInstrumented);
+
+    SIMetricsSetLevel(SIMetricsTracing);
+    double tracing = SIBenchmarkFastest(SIBenchmarkInstrumented);
+
+    printf("metrics stage overhead: off %6.2f ns  on %6.2f ns  tracing %6.2f ns\n",
+           disabled - baseline, enabled - baseline, tracing - baseline);
+
+    SIMetricsSetLevel(SIMetricsOn);
+    pthread_t threads[SIBenchmarkThreadCount];
+    for (unsigned i = 0; i < SIBenchmarkThreadCount; i++) {
+        pthread_create(&threads[i], NULL, SIBenchmarkRecorder, NULL);
+    }
+    for (unsigned i = 0; i < SIBenchmarkThreadCount; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    SILatencyHistogram *stages = calloc(SIMetricsStageCount, sizeof(SILatencyHistogram));
+    uint64_t counters[SIMetricsCounterCount];
+    SIMetricsCollect(stages, counters);
+
+    uint64_t expected = SIBenchmarkThreadCount * SIBenchmarkThreadIterations;
+    uint64_t recorded = SILatencyHistogramCount(&stages[SIMetricsStagePost]);
+    free(stages);
+
+    printf("metrics %u threads: %llu of %llu stages, %llu of %llu counts\n",
+           SIBenchmarkThreadCount,
+           (unsigned long long)recorded, (unsigned long long)expected,
+           (unsigned long long)counters[SIMetricsCounterNotifications], (unsigned long long)expected);
+
+    if (disabled - baseline > SIBenchmarkMaximumDisabledOverhead) {
+        fprintf(stderr, "metrics: %.2f ns per stage with metrics off, expected at most %.2f\n",
+                disabled - baseline, SIBenchmarkMaximumDisabledOverhead);
+        return 1;
+    }
+
+    if (recorded != expected || counters[SIMetricsCounterNotifications] != expected) {
+        fprintf(stderr, "metrics: lost records across threads\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Checks each notification policy rule on a scripted sequence of events,
+// then times evaluating a stream of events that every rule has a say in,
+// and fails if a rule misbehaves or evaluation is not a matter of
+// nanoseconds.
+
+#include <stdio.h>
+#include <string.h>
+#include "../SIClock.h"
+#include "../SINotificationPolicy.h"
+
+static const uint64_t SIBenchmarkIterations = 20000000;
+static const double SIBenchmarkMaximumEvaluation = 50.0;
+static const uint64_t SISecond = 1000000000ULL;
+
+typedef struct SIBenchmarkStep {
+    double at;
+    uint64_t track;
+    uint64_t streamTitle;
+    SINotificationPolicyVerdict verdict;
+} SIBenchmarkStep;
+
+static int SIBenchmarkScript(void) {
+    SINotificationPolicyRules rules = {
+        .duplicateInterval = 10,
+        .notificationsPerMinute = 3,
+        .streamTitleInterval = 5
+    };
+    SIBenchmarkStep steps[] = {
+        {   1.0, 1, 0, SINotificationPolicyAllow },
+        {   4.0, 1, 0, SINotificationPolicySuppressDuplicate },     // resumed
+        {  13.0, 1, 0, SINotificationPolicySuppressDuplicate },     // seeked
+        {  30.0, 1, 0, SINotificationPolicyAllow },                 // resumed after a while
+        {  31.0, 2, 0, SINotificationPolicyAllow },
+        {  32.0, 3, 0, SINotificationPolicyAllow },
+        {  33.0, 4, 0, SINotificationPolicySuppressRate },          // bucket empty
+        {  52.0, 5, 0, SINotificationPolicyAllow },                 // a token back
+        { 100.0, 6, 7, SINotificationPolicyAllow },
+        { 102.0, 6, 8, SINotificationPolicySuppressStreamTitle },
+        { 103.0, 6, 9, SINotificationPolicySuppressStreamTitle },
+        { 106.0, 6, 9, SINotificationPolicyAllow },
+        { 107.0, 6, 9, SINotificationPolicySuppressDuplicate },
+    };
+    SINotificationPolicy policy;
+    uint64_t counts[SINotificationPolicyVerdictCount] = { 0 };
+    int failures = 0;
+
+    memset(&policy, 0, sizeof(policy));
+    SINotificationPolicyCompile(&policy, &rules, SISecond);
+
+    for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        SINotificationPolicyVerdict verdict = SINotificationPolicyEvaluate(&policy,
+                                                                           steps[i].track,
+                                                                           steps[i].streamTitle,
+                                                                           (uint64_t)(steps[i].at * SISecond));
+        counts[steps[i].verdict]++;
+
+        if (verdict != steps[i].verdict) {
+            fprintf(stderr, "policy: event at %.0f s was %s, expected %s\n",
+                    steps[i].at, SINotificationPolicyVerdictName(verdict), SINotificationPolicyVerdictName(steps[i].verdict));
+            failures++;
+        }
+    }
+
+    if (memcmp(counts, policy.counts, sizeof(counts)) != 0) {
+        fprintf(stderr, "policy: counts do not match the verdicts\n");
+        failures++;
+    }
+
+    return failures;
+}
+
+int main(int argc, char *argv[]) {
+    SINotificationPolicyRules rules = {
+        .duplicateInterval = 10,
+        .notificationsPerMinute = 20,
+        .streamTitleInterval = 5
+    };
+    SINotificationPolicy policy;
+    char summary[256];
+
+    int failures = SIBenchmarkScript();
+
+    // An event every 10 ms, a new track every 64 events and a new stream
+    // title every 16.
+    memset(&policy, 0, sizeof(policy));
+    SINotificationPolicyCompile(&policy, &rules, 0);
+
+    uint64_t start = SIMonotonicNanoseconds();
+
+    for (uint64_t i = 0; i < SIBenchmarkIterations; i++) {
+        SINotificationPolicyEvaluate(&policy, (i >> 6) + 1, (i >> 4) & 1, i * 10000000ULL);
+    }
+
+    double elapsed = (double)(SIMonotonicNanoseconds() - start) / SIBenchmarkIterations;
+
+    SINotificationPolicyFormat(&policy, summary, sizeof(summary));
+    printf("policy evaluation: %.2f ns per event\n", elapsed);
+    printf("%s\n", summary);
+
+    if (elapsed > SIBenchmarkMaximumEvaluation) {
+        fprintf(stderr, "policy: %.2f ns per event, expected at most %.2f\n", elapsed, SIBenchmarkMaximumEvaluation);
+        failures++;
+    }
+
+    return failures ? 1 : 0;
+}
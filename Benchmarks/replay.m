@@ -0,0 +1,250 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Replays playerInfo events through the whole notifier, from the coalescer to
+// a sink queue, backed by a synthetic library and a null sink. Without
+// arguments it replays a synthetic trace flat out; given a trace recorded
+// with RecordEventsPath it replays that, at the speed given as the second
+// argument (default 1, 0 for flat out).
+
+#import "../SIClock.h"
+#import "../SIEventTrace.h"
+#import "../SIFileMetadataProvider.h"
+#import "../SINowPlayingService.h"
+#import "../SIProcessMemory.h"
+#import "../SIRecordingNotificationSink.h"
+#import "../SIReplayEventSource.h"
+
+static const NSUInteger SIBenchmarkTrackCount = 2000;
+static const NSUInteger SIBenchmarkEventCount = 20000;
+
+// A properties request and an artwork request.
+static const unsigned long long SIBenchmarkMaximumAppleEventsPerTrack = 2;
+
+// Overrides defaults for this process only, without hiding the command line.
+static void SIBenchmarkSetDefaults(NSDictionary *defaults) {
+    NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+    NSMutableDictionary *arguments = [NSMutableDictionary dictionaryWithDictionary:defaults];
+
+    [arguments addEntriesFromDictionary:[userDefaults volatileDomainForName:NSArgumentDomain]];
+    [userDefaults removeVolatileDomainForName:NSArgumentDomain];
+    [userDefaults setVolatileDomain:arguments forName:NSArgumentDomain];
+}
+
+// Stream titles each radio track of the synthetic trace goes through, and
+// the seconds between them, longer than the default StreamTitleInterval so
+// that each is notified.
+static const NSUInteger SIBenchmarkStreamTitleCount = 3;
+static const NSTimeInterval SIBenchmarkStreamTitleSpacing = 6;
+
+// Seconds before a track is played again, past the default DuplicateInterval
+// so that it is notified anew rather than as an update.
+static const NSTimeInterval SIBenchmarkRepeatSpacing = 11;
+
+// Flat out, the notification policy runs on the time of the trace rather
+// than that of the replay.
+static SIReplayEventSource *SIBenchmarkEventSource;
+
+static uint64_t SIBenchmarkTraceClock(void) {
+    return [SIBenchmarkEventSource traceNanoseconds];
+}
+
+// Plays tracks half a second apart, mostly in library order with a jump to
+// a random track every so often. Each starts with a burst of two events,
+// every eighth is paused and resumed, every sixteenth is played as a stream
+// that changes its title a few times before the next track, and another
+// sixteenth is played twice.
+static SIEventTrace *SIBenchmarkSyntheticTrace(SIFileMetadataProvider *metadataProvider, NSUInteger *streamTitleChangeCount) {
+    SIEventTrace *trace = [[[SIEventTrace alloc] init] autorelease];
+    NSTimeInterval offset = 0;
+    NSUInteger trackIndex = 0;
+    uint32_t random = 1;
+
+    for (NSUInteger track = 0; [trace count] < SIBenchmarkEventCount; track++) {
+        random = random * 1664525 + 1013904223;
+        trackIndex = (random >> 16) % 10 ? trackIndex + 1 : random % [metadataProvider trackCount];
+        NSDictionary *userInfo = [metadataProvider userInfoForTrackAtIndex:trackIndex];
+
+        [trace addUserInfo:userInfo offset:offset];
+        [trace addUserInfo:userInfo offset:offset + 0.003];
+
+        if (track % 8 == 0) {
+            NSMutableDictionary *paused = [NSMutableDictionary dictionaryWithDictionary:userInfo];
+            [paused setObject:@"Paused" forKey:@"Player State"];
+            [trace addUserInfo:paused offset:offset + 0.2];
+            [trace addUserInfo:userInfo offset:offset + 0.3];
+        }
+
+        if (track % 16 == 4) {
+            for (NSUInteger i = 0; i < SIBenchmarkStreamTitleCount; i++) {
+                NSMutableDictionary *titled = [NSMutableDictionary dictionaryWithDictionary:userInfo];
+                [titled setObject:[NSString stringWithFormat:@"Song %lu", (unsigned long)i] forKey:@"Stream Title"];
+                [trace addUserInfo:titled offset:offset + SIBenchmarkStreamTitleSpacing * (i + 1)];
+                (*streamTitleChangeCount)++;
+            }
+
+            offset += SIBenchmarkStreamTitleSpacing * SIBenchmarkStreamTitleCount;
+        }
+
+        if (track % 16 == 12) {
+            [trace addUserInfo:userInfo offset:offset + SIBenchmarkRepeatSpacing];
+            offset += SIBenchmarkRepeatSpacing;
+        }
+
+        offset += 0.5;
+    }
+
+    return trace;
+}
+
+int main(int argc, char *argv[]) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSString *library = [NSTemporaryDirectory() stringByAppendingPathComponent:@"itunesnotify-replay"];
+    NSError *error = nil;
+
+    if (![[NSFileManager defaultManager] fileExistsAtPath:library]) {
+        [SIFileMetadataProvider writeSyntheticLibraryToDirectory:library
+                                                      trackCount:SIBenchmarkTrackCount
+                                                 albumTrackCount:12
+                                                   artworkLength:64 * 1024
+                                                           error:NULL];
+    }
+
+    SIFileMetadataProvider *metadataProvider = [[[SIFileMetadataProvider alloc] initWithDirectory:library error:&error] autorelease];
+    if (!metadataProvider) {
+        fprintf(stderr, "replay: cannot load %s: %s\n", [library UTF8String], [[error description] UTF8String]);
+        return 1;
+    }
+
+    SIEventTrace *trace = nil;
+    NSUInteger streamTitleChangeCount = 0;
+    double speed = 0;
+
+    if (argc > 1) {
+        trace = [SIEventTrace traceWithContentsOfFile:[NSString stringWithUTF8String:argv[1]] error:&error];
+        speed = argc > 2 ? atof(argv[2]) : 1;
+    } else {
+        trace = SIBenchmarkSyntheticTrace(metadataProvider, &streamTitleChangeCount);
+    }
+
+    if (!trace) {
+        fprintf(stderr, "replay: cannot load %s: %s\n", argv[1], [[error description] UTF8String]);
+        return 1;
+    }
+
+    // The synthetic listener skips a track every half second, far faster than
+    // the rate limit is meant for, so that is off; the notification formats
+    // and the other rules are the shipped ones.
+    NSMutableDictionary *defaults = [NSMutableDictionary dictionaryWithDictionary:@{
+        @"Sinks"                  : @[],
+        @"SinkQueueCapacity"      : @1024,
+        @"SinkQueuePolicy"        : @"Block",
+        @"NowPlayingSnapshotPath" : [NSTemporaryDirectory() stringByAppendingPathComponent:@"itunesnotify-replay.nowplaying"],
+        @"NowPlayingSocketPath"   : @"",
+        @"RecordEventsPath"       : @"",
+        @"PrefetchDelay"          : @0,
+        @"NotificationsPerMinute" : @0,
+        @"HistoryDirectory"       : [NSTemporaryDirectory() stringByAppendingPathComponent:@"itunesnotify-replay-history"],
+        @"ScrobbleURL"            : @""
+    }];
+    if (speed <= 0) {
+        [defaults setObject:@0 forKey:@"CoalescingInterval"];
+    }
+    SIBenchmarkSetDefaults(defaults);
+
+    SIReplayEventSource *eventSource = [[[SIReplayEventSource alloc] initWithTrace:trace speed:speed] autorelease];
+    SINowPlayingService *service = [[SINowPlayingService alloc] initWithMetadataProvider:metadataProvider
+                                                                             eventSource:eventSource
+                                                                        artworkDirectory:nil];
+    if (speed <= 0) {
+        SIBenchmarkEventSource = eventSource;
+        [[service pipeline] setPolicyClock:SIBenchmarkTraceClock];
+    }
+
+    SIRecordingNotificationSink *sink = [[[SIRecordingNotificationSink alloc] initWithCapacity:0] autorelease];
+    SISinkQueue *sinkQueue = [service addSink:sink name:@"Recording"];
+    uint64_t start = SIMonotonicNanoseconds();
+
+    [service start];
+
+    while (![eventSource isFinished]) {
+        NSAutoreleasePool *runLoopPool = [[NSAutoreleasePool alloc] init];
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+        [runLoopPool drain];
+    }
+
+    [service stop];
+
+    uint64_t elapsed = SIMonotonicNanoseconds() - start;
+    const SILatencyHistogram *latency = [sinkQueue latency];
+
+    printf("replay %lu events %s: %10.0f events/s  %lu notifications  "
+           "p50 %.3f ms  p99 %.3f ms  p999 %.3f ms  peak rss %.1f MB\n",
+           (unsigned long)[eventSource replayedCount],
+           speed > 0 ? [[NSString stringWithFormat:@"at %gx", speed] UTF8String] : "flat out",
+           [eventSource replayedCount] / (elapsed / 1e9),
+           (unsigned long)[sink postedCount],
+           SILatencyHistogramPercentile(latency, 50) / 1e6,
+           SILatencyHistogramPercentile(latency, 99) / 1e6,
+           SILatencyHistogramPercentile(latency, 99.9) / 1e6,
+           SIPeakResidentMemoryBytes() / (1024.0 * 1024.0));
+    printf("replay %s\n", [[[service pipeline] policySummary] UTF8String]);
+    printf("replay %s\n", [[[service pipeline] updateSummary] UTF8String]);
+    printf("replay %s\n", [[[service pipeline] latencySummary] UTF8String]);
+    printf("replay %s\n", [[[service prefetcher] statisticsSummary] UTF8String]);
+    printf("replay %s\n", [[[[service artworkCache] store] statisticsSummary] UTF8String]);
+    printf("replay %s\n", [[[service pipeline] appleEventSummary] UTF8String]);
+    printf("replay %s\n", [[[service history] statisticsSummary] UTF8String]);
+    printf("replay %s\n", [[[service memoryBudget] statisticsSummary] UTF8String]);
+
+    BOOL posted = [sink postedCount] > 0;
+    unsigned long long maximumAppleEvents = [[service pipeline] maximumAppleEventsPerTrack];
+    NSUInteger updateCount = [[service pipeline] updateCount];
+    NSUInteger unchangedUpdateCount = [[service pipeline] unchangedUpdateCount];
+    [service release];
+    [pool drain];
+
+    if (!posted) {
+        fprintf(stderr, "replay: no notifications posted\n");
+        return 1;
+    }
+
+    if (maximumAppleEvents > SIBenchmarkMaximumAppleEventsPerTrack) {
+        fprintf(stderr, "replay: %llu Apple Events for one track, expected at most %llu\n",
+                maximumAppleEvents, SIBenchmarkMaximumAppleEventsPerTrack);
+        return 1;
+    }
+
+    if (unchangedUpdateCount > 0) {
+        fprintf(stderr, "replay: %lu updates changed nothing the notification shows\n",
+                (unsigned long)unchangedUpdateCount);
+        return 1;
+    }
+
+    if (updateCount < streamTitleChangeCount) {
+        fprintf(stderr, "replay: %lu of %lu stream title changes updated the notification in place\n",
+                (unsigned long)updateCount, (unsigned long)streamTitleChangeCount);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Times SIImageResample on typical album artwork sizes.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../SIClock.h"
+#include "../SIImageResampler.h"
+
+static void SIBenchmarkResample(size_t sourceSize, size_t destinationSize, SIResampleFilter filter, const char *filterName) {
+    uint8_t *source = malloc(sourceSize * sourceSize * 4);
+    uint8_t *destination = malloc(destinationSize * destinationSize * 4);
+    const int iterations = 10;
+
+    for (size_t i = 0; i < sourceSize * sourceSize * 4; i++) {
+        source[i] = (uint8_t)(i * 2654435761u >> 24);
+    }
+
+    SIImageResample(source, sourceSize, sourceSize, sourceSize * 4,
+                    destination, destinationSize, destinationSize, destinationSize * 4, filter);
+
+    uint64_t start = SIMonotonicNanoseconds();
+    for (int i = 0; i < iterations; i++) {
+        SIImageResample(source, sourceSize, sourceSize, sourceSize * 4,
+                        destination, destinationSize, destinationSize, destinationSize * 4, filter);
+    }
+    uint64_t elapsed = SIMonotonicNanoseconds() - start;
+
+    printf("resample %-8s %4zux%-4zu -> %3zux%-3zu %8.2f ms\n",
+           filterName, sourceSize, sourceSize, destinationSize, destinationSize,
+           elapsed / 1e6 / iterations);
+
+    free(source);
+    free(destination);
+}
+
+int main(int argc, char *argv[]) {
+    const size_t sourceSizes[] = {600, 1400, 3000};
+
+    for (size_t i = 0; i < sizeof(sourceSizes) / sizeof(sourceSizes[0]); i++) {
+        SIBenchmarkResample(sourceSizes[i], 128, SIResampleFilterBox, "box");
+        SIBenchmarkResample(sourceSizes[i], 128, SIResampleFilterLanczos3, "lanczos3");
+    }
+
+    return 0;
+}
@@ -0,0 +1,152 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Reads the now-playing snapshot while another thread keeps rewriting it and
+// fails if a reader ever sees a torn state, if a read waits forever on a
+// writer that died mid-update, or if the snapshot is mapped through a
+// symbolic link.
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "../SIClock.h"
+#include "../SINowPlayingSnapshot.h"
+
+static const uint64_t SIBenchmarkDuration = 500000000;
+
+static atomic_bool SIBenchmarkStopping;
+static uint64_t SIBenchmarkWriteCount;
+
+static void *SIBenchmarkWriter(void *argument) {
+    SINowPlayingSnapshot *snapshot = argument;
+    SINowPlayingState state;
+
+    memset(&state, 0, sizeof(state));
+
+    while (!atomic_load(&SIBenchmarkStopping)) {
+        SIBenchmarkWriteCount++;
+        state.totalTime = SIBenchmarkWriteCount;
+        snprintf(state.name, sizeof(state.name), "Track %llu", (unsigned long long)SIBenchmarkWriteCount);
+        snprintf(state.artist, sizeof(state.artist), "Artist %llu", (unsigned long long)SIBenchmarkWriteCount);
+        memset(state.album, 'a' + SIBenchmarkWriteCount % 26, sizeof(state.album) - 1);
+        SINowPlayingSnapshotWrite(snapshot, &state);
+    }
+
+    return NULL;
+}
+
+static int SIBenchmarkStateIsConsistent(const SINowPlayingState *state) {
+    char name[sizeof(state->name)];
+    char artist[sizeof(state->artist)];
+
+    if (!state->totalTime) {
+        return 1;
+    }
+
+    snprintf(name, sizeof(name), "Track %llu", (unsigned long long)state->totalTime);
+    snprintf(artist, sizeof(artist), "Artist %llu", (unsigned long long)state->totalTime);
+
+    return strcmp(name, state->name) == 0
+        && strcmp(artist, state->artist) == 0
+        && state->album[0] == 'a' + state->totalTime % 26
+        && state->album[sizeof(state->album) - 2] == state->album[0];
+}
+
+int main(int argc, char *argv[]) {
+    char path[] = "/tmp/itunesnotify-snapshot-XXXXXX";
+    int fileDescriptor = mkstemp(path);
+
+    if (fileDescriptor < 0) {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fileDescriptor);
+
+    SINowPlayingSnapshot *writerMapping = SINowPlayingSnapshotMap(path, 1);
+    SINowPlayingSnapshot *readerMapping = SINowPlayingSnapshotMap(path, 0);
+    if (!writerMapping || !readerMapping) {
+        perror("SINowPlayingSnapshotMap");
+        return 1;
+    }
+
+    pthread_t writer;
+    pthread_create(&writer, NULL, SIBenchmarkWriter, writerMapping);
+
+    SINowPlayingState state;
+    uint64_t readCount = 0;
+    uint64_t busyCount = 0;
+    uint64_t tornCount = 0;
+    uint64_t start = SIMonotonicNanoseconds();
+
+    while (SIMonotonicNanoseconds() - start < SIBenchmarkDuration) {
+        if (SINowPlayingSnapshotRead(readerMapping, &state, NULL) != 0) {
+            busyCount++;
+            continue;
+        }
+
+        readCount++;
+
+        if (!SIBenchmarkStateIsConsistent(&state)) {
+            tornCount++;
+        }
+    }
+
+    uint64_t elapsed = SIMonotonicNanoseconds() - start;
+    atomic_store(&SIBenchmarkStopping, 1);
+    pthread_join(writer, NULL);
+
+    printf("snapshot reads %10.0f/s  writes %10.0f/s  %llu busy  %llu torn\n",
+           readCount / (elapsed / 1e9), SIBenchmarkWriteCount / (elapsed / 1e9),
+           (unsigned long long)busyCount, (unsigned long long)tornCount);
+
+    // A writer that dies mid-update leaves the sequence odd.
+    atomic_fetch_add(&writerMapping->sequence, 1);
+    uint64_t deadStart = SIMonotonicNanoseconds();
+    int deadResult = SINowPlayingSnapshotRead(readerMapping, &state, NULL);
+    int deadError = errno;
+    printf("snapshot read from a dead writer gave up after %.3f ms\n", (SIMonotonicNanoseconds() - deadStart) / 1e6);
+
+    char linkPath[sizeof(path) + 5];
+    snprintf(linkPath, sizeof(linkPath), "%s.link", path);
+    int linkRefused = symlink(path, linkPath) == 0 && !SINowPlayingSnapshotMap(linkPath, 1);
+    unlink(linkPath);
+
+    SINowPlayingSnapshotUnmap(readerMapping);
+    SINowPlayingSnapshotUnmap(writerMapping);
+    unlink(path);
+
+    if (deadResult != -1 || deadError != EAGAIN) {
+        fprintf(stderr, "snapshot: a read did not give up on a dead writer\n");
+        return 1;
+    }
+
+    if (!linkRefused) {
+        fprintf(stderr, "snapshot: mapped the snapshot through a symbolic link\n");
+        return 1;
+    }
+
+    return tornCount ? 1 : 0;
+}
@@ -0,0 +1,208 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Replays a million playerInfo events through the whole notifier, as a daemon
+// running for weeks would see them, and fails if its resident memory keeps
+// growing once the caches have filled or the track properties cache holds
+// more than its capacity. The trace is a short synthetic one played over and
+// over; the artwork budget is set low so that eviction runs throughout.
+
+#import "../SIClock.h"
+#import "../SIEventTrace.h"
+#import "../SIFileMetadataProvider.h"
+#import "../SINowPlayingService.h"
+#import "../SIProcessMemory.h"
+#import "../SIRecordingNotificationSink.h"
+#import "../SIReplayEventSource.h"
+
+static const NSUInteger SIBenchmarkTrackCount = 2000;
+static const NSUInteger SIBenchmarkTraceEventCount = 10000;
+static const NSUInteger SIBenchmarkEventCount = 1000000;
+static const NSUInteger SIBenchmarkWarmupEventCount = 100000;
+static const NSUInteger SIBenchmarkSampleInterval = 100000;
+static const NSUInteger SIBenchmarkMemoryBudget = 1024 * 1024;
+static const size_t SIBenchmarkMaximumGrowth = 2 * 1024 * 1024;
+
+// Overrides defaults for this process only, without hiding the command line.
+static void SIBenchmarkSetDefaults(NSDictionary *defaults) {
+    NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+    NSMutableDictionary *arguments = [NSMutableDictionary dictionaryWithDictionary:defaults];
+
+    [arguments addEntriesFromDictionary:[userDefaults volatileDomainForName:NSArgumentDomain]];
+    [userDefaults removeVolatileDomainForName:NSArgumentDomain];
+    [userDefaults setVolatileDomain:arguments forName:NSArgumentDomain];
+}
+
+// Plays tracks in library order, wrapping around, so every pass misses the
+// artwork evicted since the last one. Every eighth track is paused and
+// resumed, and every sixteenth changes its stream title.
+static SIEventTrace *SIBenchmarkSoakTrace(SIFileMetadataProvider *metadataProvider) {
+    SIEventTrace *trace = [[[SIEventTrace alloc] init] autorelease];
+    NSTimeInterval offset = 0;
+
+    for (NSUInteger track = 0; [trace count] < SIBenchmarkTraceEventCount; track++) {
+        NSDictionary *userInfo = [metadataProvider userInfoForTrackAtIndex:track % [metadataProvider trackCount]];
+
+        [trace addUserInfo:userInfo offset:offset];
+
+        if (track % 8 == 0) {
+            NSMutableDictionary *paused = [NSMutableDictionary dictionaryWithDictionary:userInfo];
+            [paused setObject:@"Paused" forKey:@"Player State"];
+            [trace addUserInfo:paused offset:offset + 0.2];
+            [trace addUserInfo:userInfo offset:offset + 0.3];
+        }
+
+        if (track % 16 == 4) {
+            NSMutableDictionary *titled = [NSMutableDictionary dictionaryWithDictionary:userInfo];
+            [titled setObject:@"Song" forKey:@"Stream Title"];
+            [trace addUserInfo:titled offset:offset + 0.1];
+        }
+
+        offset += 0.5;
+    }
+
+    return trace;
+}
+
+int main(int argc, char *argv[]) {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSString *library = [NSTemporaryDirectory() stringByAppendingPathComponent:@"itunesnotify-replay"];
+    NSString *historyDirectory = [NSTemporaryDirectory() stringByAppendingPathComponent:@"itunesnotify-soak-history"];
+    NSError *error = nil;
+
+    if (![[NSFileManager defaultManager] fileExistsAtPath:library]) {
+        [SIFileMetadataProvider writeSyntheticLibraryToDirectory:library
+                                                      trackCount:SIBenchmarkTrackCount
+                                                 albumTrackCount:12
+                                                   artworkLength:64 * 1024
+                                                           error:NULL];
+    }
+
+    SIFileMetadataProvider *metadataProvider = [[[SIFileMetadataProvider alloc] initWithDirectory:library error:&error] autorelease];
+    if (!metadataProvider) {
+        fprintf(stderr, "soak: cannot load %s: %s\n", [library UTF8String], [[error description] UTF8String]);
+        return 1;
+    }
+
+    [[NSFileManager defaultManager] removeItemAtPath:historyDirectory error:NULL];
+    SIBenchmarkSetDefaults(@{
+        @"Sinks"                  : @[],
+        @"SinkQueueCapacity"      : @1024,
+        @"SinkQueuePolicy"        : @"Block",
+        @"NowPlayingSnapshotPath" : [NSTemporaryDirectory() stringByAppendingPathComponent:@"itunesnotify-soak.nowplaying"],
+        @"NowPlayingSocketPath"   : @"",
+        @"RecordEventsPath"       : @"",
+        @"CoalescingInterval"     : @0,
+        @"PrefetchDelay"          : @0,
+        @"NotificationsPerMinute" : @0,
+        @"StreamTitleInterval"    : @0,
+        @"HistoryDirectory"       : historyDirectory,
+        @"HistorySyncBatchSize"   : @1024,
+        @"ScrobbleURL"            : @"",
+        @"MemoryBudget"           : @(SIBenchmarkMemoryBudget)
+    });
+
+    SIEventTrace *trace = SIBenchmarkSoakTrace(metadataProvider);
+    SIReplayEventSource *eventSource = [[[SIReplayEventSource alloc] initWithTrace:trace speed:0] autorelease];
+    [eventSource setRepeatCount:SIBenchmarkEventCount / [trace count] - 1];
+
+    SINowPlayingService *service = [[SINowPlayingService alloc] initWithMetadataProvider:metadataProvider
+                                                                             eventSource:eventSource
+                                                                        artworkDirectory:nil];
+    SIRecordingNotificationSink *sink = [[[SIRecordingNotificationSink alloc] initWithCapacity:0] autorelease];
+    [service addSink:sink name:@"Recording"];
+    uint64_t start = SIMonotonicNanoseconds();
+    NSUInteger nextSample = SIBenchmarkWarmupEventCount;
+    size_t warmResidentBytes = 0;
+    size_t maximumResidentBytes = 0;
+
+    [service start];
+
+    while (![eventSource isFinished]) {
+        NSAutoreleasePool *runLoopPool = [[NSAutoreleasePool alloc] init];
+        [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+        [runLoopPool drain];
+
+        NSUInteger replayedCount = [eventSource replayedCount];
+        if (replayedCount < nextSample) {
+            continue;
+        }
+
+        size_t residentBytes = SIResidentMemoryBytes();
+
+        if (!warmResidentBytes) {
+            warmResidentBytes = residentBytes;
+        }
+
+        if (residentBytes > maximumResidentBytes) {
+            maximumResidentBytes = residentBytes;
+        }
+
+        printf("soak %7lu events: rss %.1f MB\n", (unsigned long)replayedCount, residentBytes / (1024.0 * 1024.0));
+        nextSample = replayedCount + SIBenchmarkSampleInterval;
+    }
+
+    [service stop];
+
+    uint64_t elapsed = SIMonotonicNanoseconds() - start;
+    size_t finalResidentBytes = SIResidentMemoryBytes();
+
+    if (finalResidentBytes > maximumResidentBytes) {
+        maximumResidentBytes = finalResidentBytes;
+    }
+
+    printf("soak %lu events: %10.0f events/s  %lu notifications  rss warm %.1f MB  max %.1f MB  final %.1f MB\n",
+           (unsigned long)[eventSource replayedCount],
+           [eventSource replayedCount] / (elapsed / 1e9),
+           (unsigned long)[sink postedCount],
+           warmResidentBytes / (1024.0 * 1024.0),
+           maximumResidentBytes / (1024.0 * 1024.0),
+           finalResidentBytes / (1024.0 * 1024.0));
+    printf("soak %s\n", [[[service memoryBudget] statisticsSummary] UTF8String]);
+    printf("soak %s\n", [[[[service artworkCache] store] statisticsSummary] UTF8String]);
+
+    NSUInteger replayedCount = [eventSource replayedCount];
+    NSUInteger propertiesCount = [[metadataProvider propertiesCache] count];
+    [service release];
+    [[NSFileManager defaultManager] removeItemAtPath:historyDirectory error:NULL];
+    [pool drain];
+
+    if (replayedCount != SIBenchmarkEventCount || !warmResidentBytes) {
+        fprintf(stderr, "soak: replayed %lu of %lu events\n", (unsigned long)replayedCount, (unsigned long)SIBenchmarkEventCount);
+        return 1;
+    }
+
+    if (propertiesCount > SITrackPropertiesCacheCapacity) {
+        fprintf(stderr, "soak: %lu tracks in the properties cache, expected at most %lu\n",
+                (unsigned long)propertiesCount, (unsigned long)SITrackPropertiesCacheCapacity);
+        return 1;
+    }
+
+    if (maximumResidentBytes - warmResidentBytes > SIBenchmarkMaximumGrowth) {
+        fprintf(stderr, "soak: resident memory grew %.1f MB after warming up, expected at most %.1f\n",
+                (maximumResidentBytes - warmResidentBytes) / (1024.0 * 1024.0),
+                SIBenchmarkMaximumGrowth / (1024.0 * 1024.0));
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <pthread.h>
+#include <stdlib.h>
+#include "SIArena.h"
+
+#define SIThreadArenaChunkSize (64 * 1024)
+
+struct SIArenaChunk {
+    SIArenaChunk *next;
+    size_t size;
+    size_t offset;
+    _Alignas(16) unsigned char bytes[];
+};
+
+static pthread_key_t SIThreadArenaKey;
+static pthread_once_t SIThreadArenaKeyOnce = PTHREAD_ONCE_INIT;
+static __thread SIArena *SICurrentThreadArena;
+
+static SIArenaChunk *SIArenaChunkCreate(size_t size) {
+    SIArenaChunk *chunk = malloc(sizeof(SIArenaChunk) + size);
+
+    if (chunk) {
+        chunk->next = NULL;
+        chunk->size = size;
+        chunk->offset = 0;
+    }
+
+    return chunk;
+}
+
+static void SIArenaFreeChunks(SIArenaChunk *chunk) {
+    while (chunk) {
+        SIArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+}
+
+bool SIArenaInit(SIArena *arena, size_t chunkSize) {
+    arena->chunkSize = chunkSize ? chunkSize : SIThreadArenaChunkSize;
+    arena->first = SIArenaChunkCreate(arena->chunkSize);
+    arena->current = arena->first;
+    arena->usedBytes = 0;
+    arena->highWaterMark = 0;
+    arena->overflowCount = 0;
+
+    return arena->first != NULL;
+}
+
+void SIArenaDestroy(SIArena *arena) {
+    SIArenaFreeChunks(arena->first);
+    arena->first = NULL;
+    arena->current = NULL;
+}
+
+void *SIArenaAllocate(SIArena *arena, size_t size) {
+    size_t alignedSize = (size + 15) & ~(size_t)15;
+    SIArenaChunk *chunk = arena->current;
+
+    if (!chunk || alignedSize < size) {
+        return NULL;
+    }
+
+    if (chunk->size - chunk->offset < alignedSize) {
+        // Chunks kept past a rewind are reused before new ones are made.
+        SIArenaChunk *next = chunk->next;
+
+        if (next && next->size >= alignedSize) {
+            next->offset = 0;
+            chunk = next;
+        } else {
+            chunk = SIArenaChunkCreate(alignedSize > arena->chunkSize ? alignedSize : arena->chunkSize);
+
+            if (!chunk) {
+                return NULL;
+            }
+
+            chunk->next = next;
+            arena->current->next = chunk;
+            arena->overflowCount++;
+        }
+
+        arena->current = chunk;
+    }
+
+    void *bytes = chunk->bytes + chunk->offset;
+    chunk->offset += alignedSize;
+    arena->usedBytes += alignedSize;
+
+    if (arena->usedBytes > arena->highWaterMark) {
+        arena->highWaterMark = arena->usedBytes;
+    }
+
+    return bytes;
+}
+
+SIArenaMark SIArenaGetMark(const SIArena *arena) {
+    SIArenaMark mark = {
+        arena->current,
+        arena->current ? arena->current->offset : 0,
+        arena->usedBytes
+    };
+
+    return mark;
+}
+
+void SIArenaRewind(SIArena *arena, SIArenaMark mark) {
+    if (!mark.chunk) {
+        return;
+    }
+
+    arena->current = mark.chunk;
+    arena->current->offset = mark.offset;
+    arena->usedBytes = mark.usedBytes;
+}
+
+void SIArenaReset(SIArena *arena) {
+    if (!arena->first) {
+        return;
+    }
+
+    SIArenaFreeChunks(arena->first->next);
+    arena->first->next = NULL;
+    arena->first->offset = 0;
+    arena->current = arena->first;
+    arena->usedBytes = 0;
+}
+
+size_t SIArenaReservedBytes(const SIArena *arena) {
+    size_t bytes = 0;
+
+    for (const SIArenaChunk *chunk = arena->first; chunk; chunk = chunk->next) {
+        bytes += sizeof(SIArenaChunk) + chunk->size;
+    }
+
+    return bytes;
+}
+
+static void SIThreadArenaDidExit(void *value) {
+    SIArena *arena = value;
+
+    SIArenaDestroy(arena);
+    free(arena);
+}
+
+static void SICreateThreadArenaKey(void) {
+    pthread_key_create(&SIThreadArenaKey, SIThreadArenaDidExit);
+}
+
+SIArena *SIThreadArena(void) {
+    SIArena *arena = SICurrentThreadArena;
+
+    if (arena) {
+        return arena;
+    }
+
+    pthread_once(&SIThreadArenaKeyOnce, SICreateThreadArenaKey);
+    arena = malloc(sizeof(SIArena));
+
+    if (!arena || !SIArenaInit(arena, SIThreadArenaChunkSize)) {
+        free(arena);
+        return NULL;
+    }
+
+    pthread_setspecific(SIThreadArenaKey, arena);
+    SICurrentThreadArena = arena;
+
+    return arena;
+}
@@ -0,0 +1,71 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef SIARENA_H
+#define SIARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct SIArenaChunk SIArenaChunk;
+
+// A bump allocator for buffers that live no longer than one event. Nothing
+// is freed on its own; resetting the arena takes everything back at once
+// and returns every chunk but the first to malloc, so an event that needed
+// more than usual does not keep it. Allocations are 16-byte aligned.
+typedef struct SIArena {
+    SIArenaChunk *first;
+    SIArenaChunk *current;
+    size_t chunkSize;
+    size_t usedBytes;
+    size_t highWaterMark;
+    uint64_t overflowCount;
+} SIArena;
+
+// A point to rewind to, releasing whatever was allocated after it.
+typedef struct SIArenaMark {
+    SIArenaChunk *chunk;
+    size_t offset;
+    size_t usedBytes;
+} SIArenaMark;
+
+// Returns false if out of memory.
+bool SIArenaInit(SIArena *arena, size_t chunkSize);
+void SIArenaDestroy(SIArena *arena);
+
+// Returns NULL only when out of memory. Sizes past the chunk size get a
+// chunk of their own, counted as an overflow.
+void *SIArenaAllocate(SIArena *arena, size_t size);
+
+SIArenaMark SIArenaGetMark(const SIArena *arena);
+void SIArenaRewind(SIArena *arena, SIArenaMark mark);
+void SIArenaReset(SIArena *arena);
+
+// Bytes held from malloc, whether handed out or not.
+size_t SIArenaReservedBytes(const SIArena *arena);
+
+// The calling thread's arena, created on first use and freed when the
+// thread exits. Whoever handles an event on a thread resets it afterwards.
+SIArena *SIThreadArena(void);
+
+#endif
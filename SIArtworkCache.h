@@ -0,0 +1,101 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIArtworkNormalizer.h"
+#import "SIArtworkProvider.h"
+#import "SIArtworkStore.h"
+#import "SIMemoryBudget.h"
+
+// Returns the persistent ID of the track described by a playerInfo userInfo
+// dictionary as the hexadecimal string used by SIITunesItem.persistentID.
+extern NSString *SIPersistentIDFromUserInfo(NSDictionary *userInfo);
+
+// A two-level artwork cache keyed by track persistent ID. The first level is
+// an LRU-bounded in-memory table; the second is a directory holding an
+// artwork store, which keeps one copy of each image however many tracks
+// share it, and an index of modification dates. Changes to the index are
+// appended to a log, which is folded into the index once per launch. Without
+// a directory the store holds only what the first level does. Tracks without
+// artwork are cached too, so that repeats never reach the provider. Artwork
+// passes through the normalizer, when set, before it is stored, so that
+// resampling is paid once per image. All methods are thread-safe; the
+// provider, the normalizer and all file I/O run without the cache lock held.
+//
+// As a memory consumer the cache counts the artwork its first level holds,
+// each shared image once, and gives it back least recently used first,
+// keeping the newest entry. An evicted image held in memory leaves the store
+// with it; one mapped from the pack has its pages dropped, once no entry
+// left holds it, until it is read again.
+@interface SIArtworkCache : NSObject <SIMemoryConsumer> {
+    id<SIArtworkProvider> provider;
+    SIArtworkNormalizer *normalizer;
+    NSString *directory;
+    NSUInteger capacity;
+    NSMutableDictionary *entries;
+    NSMutableArray *recentKeys;
+    NSUInteger memoryBytes;
+    NSMutableDictionary *memoryReferenceCounts;
+    NSMutableDictionary *index;
+    NSMutableData *pendingIndexRecords;
+    int indexFileDescriptor;
+    unsigned long long indexLength;
+    NSLock *indexLock;
+    SIArtworkStore *store;
+    NSLock *lock;
+    NSUInteger memoryHits;
+    NSUInteger diskHits;
+    NSUInteger misses;
+}
+
+@property (retain) SIArtworkNormalizer *normalizer;
+@property (nonatomic, readonly) SIArtworkStore *store;
+@property (nonatomic, readonly) NSUInteger memoryHits;
+@property (nonatomic, readonly) NSUInteger diskHits;
+@property (nonatomic, readonly) NSUInteger misses;
+
++ (NSString *)defaultDirectory;
+
+- (id)initWithProvider:(id<SIArtworkProvider>)aProvider
+             directory:(NSString *)aDirectory
+              capacity:(NSUInteger)aCapacity;
+
+// Returns the artwork of the track, or nil when it has none or the provider
+// cannot resolve it, in which case nothing is cached. A non-nil
+// modificationDate newer than the cached one invalidates the entry.
+- (NSData *)artworkDataForPersistentID:(NSString *)persistentID
+                      modificationDate:(NSDate *)modificationDate;
+
+// Looks the track up without consulting the provider. Returns NO on a miss;
+// on a hit stores the artwork, possibly nil, in data.
+- (BOOL)getCachedArtworkData:(NSData **)data
+             forPersistentID:(NSString *)persistentID
+            modificationDate:(NSDate *)modificationDate;
+
+// Normalizes and stores the artwork, returning what was stored.
+- (NSData *)storeArtworkData:(NSData *)data
+            modificationDate:(NSDate *)modificationDate
+             forPersistentID:(NSString *)persistentID;
+
+- (void)removeArtworkForPersistentID:(NSString *)persistentID;
+- (void)removeAllArtwork;
+
+@end
@@ -0,0 +1,651 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <errno.h>
+#import <fcntl.h>
+#import <stddef.h>
+#import <unistd.h>
+#import "SIArtworkCache.h"
+#import "SIContentHash.h"
+#import "SIMetrics.h"
+
+static NSString *const SIArtworkCacheIndexFileName = @"Tracks.plist";
+static NSString *const SIArtworkCacheIndexLogFileName = @"Tracks.log";
+static NSString *const SIArtworkCacheStoreFileName = @"Artwork.pack";
+static NSString *const SIArtworkCacheHasArtworkKey = @"HasArtwork";
+static NSString *const SIArtworkCacheModificationDateKey = @"ModificationDate";
+
+// Written by earlier versions, which kept a file per image.
+static NSString *const SIArtworkCacheLegacyIndexFileName = @"Index.plist";
+static NSString *const SIArtworkCacheLegacyObjectsDirectoryName = @"Objects";
+
+static const uint64_t SIArtworkIndexLogMagic = 0x3158495452414953ULL;  // "SIARTIX1"
+
+enum {
+    SIArtworkIndexRecordHasArtwork = 1 << 0,
+    SIArtworkIndexRecordHasModificationDate = 1 << 1,
+    SIArtworkIndexRecordRemoved = 1 << 2
+};
+
+// Each change to the index appended to the log: this header, then length
+// bytes of the UTF-8 persistent ID, padded to eight bytes. Modification dates
+// are seconds since the reference date. The checksum covers the header before
+// it and the persistent ID, so the log ends at the first torn record.
+typedef struct SIArtworkIndexRecord {
+    uint32_t flags;
+    uint32_t length;
+    double modificationDate;
+    uint32_t checksum;
+    uint32_t reserved;
+} SIArtworkIndexRecord;
+
+static size_t SIArtworkIndexRecordSize(size_t length) {
+    return (sizeof(SIArtworkIndexRecord) + length + 7) & ~(size_t)7;
+}
+
+static uint32_t SIArtworkIndexChecksum(const SIArtworkIndexRecord *record, const void *persistentID) {
+    uint64_t seed = SIContentHash64(record, offsetof(SIArtworkIndexRecord, checksum), 0);
+
+    return (uint32_t)SIContentHash64(persistentID, record->length, seed);
+}
+
+static BOOL SIWriteFully(int fileDescriptor, const void *bytes, size_t length, off_t offset) {
+    const char *cursor = bytes;
+
+    while (length > 0) {
+        ssize_t written = pwrite(fileDescriptor, cursor, length, offset);
+
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return NO;
+        }
+
+        cursor += written;
+        length -= (size_t)written;
+        offset += written;
+    }
+
+    return YES;
+}
+
+NSString *SIPersistentIDFromUserInfo(NSDictionary *userInfo) {
+    id persistentID = [userInfo objectForKey:@"PersistentID"];
+
+    if ([persistentID isKindOfClass:[NSNumber class]]) {
+        return [NSString stringWithFormat:@"%016llX", [persistentID unsignedLongLongValue]];
+    }
+
+    if ([persistentID isKindOfClass:[NSString class]]) {
+        return persistentID;
+    }
+
+    return nil;
+}
+
+@interface SIArtworkCacheEntry : NSObject {
+    NSData *data;
+    NSDate *modificationDate;
+}
+
+@property (nonatomic, retain) NSData *data;
+@property (nonatomic, retain) NSDate *modificationDate;
+
+@end
+
+@implementation SIArtworkCacheEntry
+
+@synthesize data;
+@synthesize modificationDate;
+
+- (void)dealloc {
+    [data release];
+    [modificationDate release];
+
+    [super dealloc];
+}
+
+- (BOOL)isStaleForModificationDate:(NSDate *)aModificationDate {
+    if (!aModificationDate) {
+        return NO;
+    }
+
+    if (!modificationDate) {
+        return YES;
+    }
+
+    return [aModificationDate compare:modificationDate] == NSOrderedDescending;
+}
+
+@end
+
+@implementation SIArtworkCache
+
+@synthesize normalizer;
+@synthesize store;
+@synthesize memoryHits;
+@synthesize diskHits;
+@synthesize misses;
+
++ (NSString *)defaultDirectory {
+    NSArray *paths = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES);
+
+    if (![paths count]) {
+        return nil;
+    }
+
+    return [[[paths objectAtIndex:0] stringByAppendingPathComponent:@"itunesnotify"] stringByAppendingPathComponent:@"Artwork"];
+}
+
+- (id)initWithProvider:(id<SIArtworkProvider>)aProvider
+             directory:(NSString *)aDirectory
+              capacity:(NSUInteger)aCapacity {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    provider = [aProvider retain];
+    directory = [aDirectory copy];
+    capacity = aCapacity > 0 ? aCapacity : 1;
+    entries = [[NSMutableDictionary alloc] initWithCapacity:capacity];
+    recentKeys = [[NSMutableArray alloc] initWithCapacity:capacity];
+    memoryReferenceCounts = [[NSMutableDictionary alloc] initWithCapacity:capacity];
+    lock = [[NSLock alloc] init];
+    indexLock = [[NSLock alloc] init];
+    pendingIndexRecords = [[NSMutableData alloc] init];
+    indexFileDescriptor = -1;
+
+    if (directory) {
+        NSFileManager *fileManager = [NSFileManager defaultManager];
+        [fileManager createDirectoryAtPath:directory withIntermediateDirectories:YES attributes:nil error:NULL];
+        [fileManager removeItemAtPath:[directory stringByAppendingPathComponent:SIArtworkCacheLegacyObjectsDirectoryName]
+                                error:NULL];
+        [fileManager removeItemAtPath:[directory stringByAppendingPathComponent:SIArtworkCacheLegacyIndexFileName]
+                                error:NULL];
+
+        NSString *indexPath = [directory stringByAppendingPathComponent:SIArtworkCacheIndexFileName];
+        index = [[NSMutableDictionary alloc] initWithContentsOfFile:indexPath];
+        store = [[SIArtworkStore alloc] initWithPath:[directory stringByAppendingPathComponent:SIArtworkCacheStoreFileName]];
+    } else {
+        store = [[SIArtworkStore alloc] initWithPath:nil];
+    }
+
+    if (!index) {
+        index = [[NSMutableDictionary alloc] init];
+    }
+
+    if (directory) {
+        [self openIndexLog];
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [provider release];
+    [normalizer release];
+    [directory release];
+    [entries release];
+    [recentKeys release];
+    [memoryReferenceCounts release];
+    [index release];
+    [store release];
+    [lock release];
+    [indexLock release];
+    [pendingIndexRecords release];
+
+    if (indexFileDescriptor >= 0) {
+        close(indexFileDescriptor);
+    }
+
+    [super dealloc];
+}
+
+// Entries sharing an image hold the store's one copy of it, so each image is
+// counted once, however many entries hold it, by the identity of its data.
+- (void)retainMemoryForData:(NSData *)data {
+    if (!data) {
+        return;
+    }
+
+    NSValue *dataKey = [NSValue valueWithPointer:data];
+    NSUInteger count = [[memoryReferenceCounts objectForKey:dataKey] unsignedIntegerValue];
+
+    if (!count) {
+        memoryBytes += [data length];
+    }
+
+    [memoryReferenceCounts setObject:[NSNumber numberWithUnsignedInteger:count + 1] forKey:dataKey];
+}
+
+// Returns the bytes freed, which are none while another entry holds the
+// image.
+- (NSUInteger)releaseMemoryForData:(NSData *)data {
+    if (!data) {
+        return 0;
+    }
+
+    NSValue *dataKey = [NSValue valueWithPointer:data];
+    NSUInteger count = [[memoryReferenceCounts objectForKey:dataKey] unsignedIntegerValue];
+
+    if (count > 1) {
+        [memoryReferenceCounts setObject:[NSNumber numberWithUnsignedInteger:count - 1] forKey:dataKey];
+        return 0;
+    }
+
+    [memoryReferenceCounts removeObjectForKey:dataKey];
+    memoryBytes -= [data length];
+
+    return [data length];
+}
+
+- (NSUInteger)evictLeastRecentEntry {
+    NSString *evictedKey = [recentKeys objectAtIndex:0];
+    NSUInteger evictedBytes = [self releaseMemoryForData:[[entries objectForKey:evictedKey] data]];
+
+    if (!directory) {
+        [store removeDataForKey:evictedKey];
+    } else if (evictedBytes) {
+        [store discardPagesForKey:evictedKey];
+    }
+
+    [entries removeObjectForKey:evictedKey];
+    [recentKeys removeObjectAtIndex:0];
+
+    return evictedBytes;
+}
+
+- (void)insertEntry:(SIArtworkCacheEntry *)entry forPersistentID:(NSString *)persistentID {
+    [self retainMemoryForData:[entry data]];
+    [self releaseMemoryForData:[[entries objectForKey:persistentID] data]];
+    [recentKeys removeObject:persistentID];
+    [recentKeys addObject:persistentID];
+    [entries setObject:entry forKey:persistentID];
+
+    while ([recentKeys count] > capacity) {
+        [self evictLeastRecentEntry];
+    }
+}
+
+// Reads the artwork an index record names from the store, without the lock
+// held. Returns nil if the store has lost it.
+- (SIArtworkCacheEntry *)diskEntryForRecord:(NSDictionary *)record persistentID:(NSString *)persistentID {
+    SIArtworkCacheEntry *entry = [[[SIArtworkCacheEntry alloc] init] autorelease];
+    [entry setModificationDate:[record objectForKey:SIArtworkCacheModificationDateKey]];
+
+    if ([[record objectForKey:SIArtworkCacheHasArtworkKey] boolValue]) {
+        NSData *data = [store dataForKey:persistentID];
+
+        if (!data) {
+            return nil;
+        }
+
+        [entry setData:data];
+    }
+
+    return entry;
+}
+
+#pragma mark - Index
+
+- (void)setIndexRecordWithFlags:(uint32_t)flags
+               modificationDate:(NSDate *)modificationDate
+                forPersistentID:(NSString *)persistentID {
+    if (flags & SIArtworkIndexRecordRemoved) {
+        [index removeObjectForKey:persistentID];
+        return;
+    }
+
+    NSNumber *hasArtwork = [NSNumber numberWithBool:(flags & SIArtworkIndexRecordHasArtwork) != 0];
+    NSMutableDictionary *record = [NSMutableDictionary dictionaryWithObject:hasArtwork forKey:SIArtworkCacheHasArtworkKey];
+    if (modificationDate) {
+        [record setObject:modificationDate forKey:SIArtworkCacheModificationDateKey];
+    }
+
+    [index setObject:record forKey:persistentID];
+}
+
+// Applies the log left by the last run over the index read from
+// Tracks.plist, stopping at the first record that is torn. Returns the
+// offset it stopped at, or 0 if the log is missing or not a log.
+- (unsigned long long)replayIndexLog:(NSData *)log {
+    uint64_t magic = 0;
+
+    if ([log length] < sizeof(magic)) {
+        return 0;
+    }
+
+    memcpy(&magic, [log bytes], sizeof(magic));
+    if (magic != SIArtworkIndexLogMagic) {
+        return 0;
+    }
+
+    const char *bytes = [log bytes];
+    NSUInteger length = [log length];
+    NSUInteger offset = sizeof(magic);
+
+    while (offset + sizeof(SIArtworkIndexRecord) <= length) {
+        SIArtworkIndexRecord record;
+        memcpy(&record, bytes + offset, sizeof(record));
+
+        const char *persistentIDBytes = bytes + offset + sizeof(record);
+        if (record.length > length - offset - sizeof(record)
+            || record.checksum != SIArtworkIndexChecksum(&record, persistentIDBytes)) {
+            break;
+        }
+
+        NSString *persistentID = [[[NSString alloc] initWithBytes:persistentIDBytes
+                                                           length:record.length
+                                                         encoding:NSUTF8StringEncoding] autorelease];
+        if (!persistentID) {
+            break;
+        }
+
+        NSDate *modificationDate = nil;
+        if (record.flags & SIArtworkIndexRecordHasModificationDate) {
+            modificationDate = [NSDate dateWithTimeIntervalSinceReferenceDate:record.modificationDate];
+        }
+
+        [self setIndexRecordWithFlags:record.flags modificationDate:modificationDate forPersistentID:persistentID];
+        offset += MIN(SIArtworkIndexRecordSize(record.length), length - offset);
+    }
+
+    return offset;
+}
+
+// Folds the log of the last run into Tracks.plist and starts it afresh, so
+// the whole index is only written once per launch. If Tracks.plist cannot be
+// written, appends to the old log instead.
+- (void)openIndexLog {
+    NSString *logPath = [directory stringByAppendingPathComponent:SIArtworkCacheIndexLogFileName];
+    NSString *indexPath = [directory stringByAppendingPathComponent:SIArtworkCacheIndexFileName];
+    NSData *log = [NSData dataWithContentsOfFile:logPath];
+    unsigned long long replayedLength = [self replayIndexLog:log];
+    BOOL folded = replayedLength <= sizeof(uint64_t) || [index writeToFile:indexPath atomically:YES];
+
+    indexFileDescriptor = open([logPath fileSystemRepresentation], O_RDWR | O_CREAT | (folded ? O_TRUNC : 0), 0644);
+    if (indexFileDescriptor < 0) {
+        NSLog(@"Could not open the artwork index log %@: %s", logPath, strerror(errno));
+        return;
+    }
+
+    fcntl(indexFileDescriptor, F_SETFD, FD_CLOEXEC);
+
+    if (folded) {
+        if (!SIWriteFully(indexFileDescriptor, &SIArtworkIndexLogMagic, sizeof(SIArtworkIndexLogMagic), 0)) {
+            close(indexFileDescriptor);
+            indexFileDescriptor = -1;
+            return;
+        }
+
+        indexLength = sizeof(SIArtworkIndexLogMagic);
+    } else {
+        ftruncate(indexFileDescriptor, (off_t)replayedLength);
+        indexLength = replayedLength;
+    }
+}
+
+// Updates the index and queues the change for the log. Called with the lock
+// held; the change reaches the file on the next flush.
+- (void)recordIndexEntry:(SIArtworkCacheEntry *)entry
+         forPersistentID:(NSString *)persistentID
+                 removed:(BOOL)removed {
+    if (!directory) {
+        return;
+    }
+
+    uint32_t flags = 0;
+    if (removed) {
+        flags |= SIArtworkIndexRecordRemoved;
+    } else {
+        if ([entry data]) {
+            flags |= SIArtworkIndexRecordHasArtwork;
+        }
+
+        if ([entry modificationDate]) {
+            flags |= SIArtworkIndexRecordHasModificationDate;
+        }
+    }
+
+    [self setIndexRecordWithFlags:flags modificationDate:[entry modificationDate] forPersistentID:persistentID];
+
+    const char *persistentIDBytes = [persistentID UTF8String];
+    SIArtworkIndexRecord record = {
+        flags,
+        (uint32_t)strlen(persistentIDBytes),
+        [[entry modificationDate] timeIntervalSinceReferenceDate],
+        0,
+        0
+    };
+    record.checksum = SIArtworkIndexChecksum(&record, persistentIDBytes);
+
+    NSUInteger recordOffset = [pendingIndexRecords length];
+    [pendingIndexRecords increaseLengthBy:SIArtworkIndexRecordSize(record.length)];
+    memcpy((char *)[pendingIndexRecords mutableBytes] + recordOffset, &record, sizeof(record));
+    memcpy((char *)[pendingIndexRecords mutableBytes] + recordOffset + sizeof(record), persistentIDBytes, record.length);
+}
+
+// Writes the changes queued so far to the log without the cache lock held.
+// Whoever flushes writes everything queued before it, so stores finishing
+// together share a write, and the log keeps the order the index changed in.
+- (void)flushIndexLog {
+    if (!directory) {
+        return;
+    }
+
+    [indexLock lock];
+
+    [lock lock];
+    NSData *records = pendingIndexRecords;
+    pendingIndexRecords = [[NSMutableData alloc] init];
+    [lock unlock];
+
+    if ([records length] && indexFileDescriptor >= 0) {
+        if (SIWriteFully(indexFileDescriptor, [records bytes], [records length], (off_t)indexLength)) {
+            indexLength += [records length];
+        } else {
+            ftruncate(indexFileDescriptor, (off_t)indexLength);
+        }
+    }
+
+    [records release];
+    [indexLock unlock];
+}
+
+- (BOOL)getCachedArtworkData:(NSData **)data
+             forPersistentID:(NSString *)persistentID
+            modificationDate:(NSDate *)modificationDate {
+    if (!persistentID) {
+        return NO;
+    }
+
+    [lock lock];
+
+    SIArtworkCacheEntry *entry = [entries objectForKey:persistentID];
+    if (entry && ![entry isStaleForModificationDate:modificationDate]) {
+        memoryHits++;
+        SIMetricsCount(SIMetricsCounterCacheHits);
+        [recentKeys removeObject:persistentID];
+        [recentKeys addObject:persistentID];
+        *data = [[[entry data] retain] autorelease];
+        [lock unlock];
+        return YES;
+    }
+
+    NSDictionary *record = [[[index objectForKey:persistentID] retain] autorelease];
+    [lock unlock];
+
+    entry = record ? [self diskEntryForRecord:record persistentID:persistentID] : nil;
+
+    [lock lock];
+
+    // A store or a removal while the store was read replaced the record; what
+    // was read for the old one is a miss.
+    if (record && [index objectForKey:persistentID] == record) {
+        if (!entry) {
+            [index removeObjectForKey:persistentID];
+        } else if (![entry isStaleForModificationDate:modificationDate]) {
+            diskHits++;
+            SIMetricsCount(SIMetricsCounterCacheHits);
+            [self insertEntry:entry forPersistentID:persistentID];
+            *data = [entry data];
+            [lock unlock];
+            return YES;
+        }
+    }
+
+    misses++;
+    SIMetricsCount(SIMetricsCounterCacheMisses);
+    [lock unlock];
+
+    return NO;
+}
+
+- (NSData *)storeArtworkData:(NSData *)data
+            modificationDate:(NSDate *)modificationDate
+             forPersistentID:(NSString *)persistentID {
+    SIArtworkNormalizer *currentNormalizer = [self normalizer];
+
+    if (currentNormalizer) {
+        data = [currentNormalizer normalizedArtworkData:data];
+    }
+
+    if (!persistentID) {
+        return data;
+    }
+
+    SIArtworkCacheEntry *entry = [[[SIArtworkCacheEntry alloc] init] autorelease];
+    [entry setModificationDate:modificationDate];
+
+    data = [store storeData:data forKey:persistentID];
+    [entry setData:data];
+
+    [lock lock];
+    [self insertEntry:entry forPersistentID:persistentID];
+    [self recordIndexEntry:entry forPersistentID:persistentID removed:NO];
+    [lock unlock];
+
+    [self flushIndexLog];
+
+    return data;
+}
+
+- (NSData *)artworkDataForPersistentID:(NSString *)persistentID
+                      modificationDate:(NSDate *)modificationDate {
+    NSData *data = nil;
+
+    if ([self getCachedArtworkData:&data forPersistentID:persistentID modificationDate:modificationDate]) {
+        return data;
+    }
+
+    if (!persistentID) {
+        [lock lock];
+        misses++;
+        [lock unlock];
+    }
+
+    NSDate *fetchedModificationDate = nil;
+    if (![provider getArtworkData:&data
+                 modificationDate:&fetchedModificationDate
+                  appleEventCount:NULL
+                  forPersistentID:persistentID]) {
+        return nil;
+    }
+
+    return [self storeArtworkData:data
+                 modificationDate:fetchedModificationDate ? fetchedModificationDate : modificationDate
+                  forPersistentID:persistentID];
+}
+
+- (void)removeArtworkForPersistentID:(NSString *)persistentID {
+    if (!persistentID) {
+        return;
+    }
+
+    [lock lock];
+    [self releaseMemoryForData:[[entries objectForKey:persistentID] data]];
+    [entries removeObjectForKey:persistentID];
+    [recentKeys removeObject:persistentID];
+
+    if ([index objectForKey:persistentID]) {
+        [self recordIndexEntry:nil forPersistentID:persistentID removed:YES];
+    }
+    [lock unlock];
+
+    [store removeDataForKey:persistentID];
+    [self flushIndexLog];
+}
+
+// Holds the index lock throughout, so that no flush slips a record from
+// before the reset into the new log.
+- (void)removeAllArtwork {
+    [indexLock lock];
+
+    [lock lock];
+    memoryBytes = 0;
+    [memoryReferenceCounts removeAllObjects];
+    [entries removeAllObjects];
+    [recentKeys removeAllObjects];
+    [index removeAllObjects];
+    [pendingIndexRecords setLength:0];
+    [lock unlock];
+
+    [store removeAllData];
+
+    if (directory) {
+        [[NSDictionary dictionary] writeToFile:[directory stringByAppendingPathComponent:SIArtworkCacheIndexFileName]
+                                    atomically:YES];
+
+        if (indexFileDescriptor >= 0) {
+            indexLength = sizeof(SIArtworkIndexLogMagic);
+            ftruncate(indexFileDescriptor, (off_t)indexLength);
+        }
+    }
+
+    [indexLock unlock];
+}
+
+- (NSUInteger)memoryCost {
+    [lock lock];
+    NSUInteger bytes = memoryBytes;
+    [lock unlock];
+
+    return bytes;
+}
+
+- (NSUInteger)evictMemory:(NSUInteger)bytes {
+    NSUInteger evictedBytes = 0;
+
+    [lock lock];
+    while (evictedBytes < bytes && [recentKeys count] > 1) {
+        evictedBytes += [self evictLeastRecentEntry];
+    }
+    [lock unlock];
+
+    return evictedBytes;
+}
+
+@end
@@ -0,0 +1,66 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIArtworkCache.h"
+
+@class SIArtworkFetchOperation;
+
+@protocol SIArtworkFetchOperationDelegate <NSObject>
+
+// Sent on the main thread once the artwork has been fetched.
+- (void)artworkFetchOperationDidFinish:(SIArtworkFetchOperation *)operation;
+
+@end
+
+// Fetches the artwork of a track from a provider on an operation queue and
+// stores it in the artwork cache. A fetch cancelled before it completes, or
+// whose track the provider no longer resolves, is not cached, so that a track
+// change cannot attach stale artwork to it.
+@interface SIArtworkFetchOperation : NSOperation {
+    NSString *persistentID;
+    SIArtworkCache *artworkCache;
+    id<SIArtworkProvider> provider;
+    id<SIArtworkFetchOperationDelegate> delegate;
+    NSCondition *condition;
+    NSData *artworkData;
+    BOOL fetched;
+    unsigned long long appleEventCount;
+}
+
+@property (nonatomic, readonly) NSString *persistentID;
+@property (nonatomic, assign) id<SIArtworkFetchOperationDelegate> delegate;
+
+- (id)initWithPersistentID:(NSString *)aPersistentID
+              artworkCache:(SIArtworkCache *)anArtworkCache
+                  provider:(id<SIArtworkProvider>)aProvider;
+
+// Blocks until the artwork has been fetched or the date has passed and
+// returns whether it was fetched.
+- (BOOL)waitUntilFetchedBeforeDate:(NSDate *)date;
+
+- (NSData *)artworkData;
+
+// The Apple Events the provider sent for this fetch, as it reports them, so
+// prefetches using the provider at the same time are not counted.
+- (unsigned long long)appleEventCount;
+
+@end
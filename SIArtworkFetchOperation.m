@@ -0,0 +1,134 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIArtworkFetchOperation.h"
+#import "SIArena.h"
+#import "SIMetrics.h"
+
+@implementation SIArtworkFetchOperation
+
+@synthesize persistentID;
+@synthesize delegate;
+
+- (id)initWithPersistentID:(NSString *)aPersistentID
+              artworkCache:(SIArtworkCache *)anArtworkCache
+                  provider:(id<SIArtworkProvider>)aProvider {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    persistentID = [aPersistentID copy];
+    artworkCache = [anArtworkCache retain];
+    provider = [aProvider retain];
+    condition = [[NSCondition alloc] init];
+
+    return self;
+}
+
+- (void)dealloc {
+    [persistentID release];
+    [artworkCache release];
+    [provider release];
+    [condition release];
+    [artworkData release];
+
+    [super dealloc];
+}
+
+- (void)fetch {
+    uint64_t stageStart = SIMetricsBegin();
+    NSData *data = nil;
+    NSDate *modificationDate = nil;
+    unsigned long long appleEventsSent = 0;
+    BOOL resolved = [provider getArtworkData:&data
+                            modificationDate:&modificationDate
+                             appleEventCount:&appleEventsSent
+                             forPersistentID:persistentID];
+
+    if (!resolved || [self isCancelled]) {
+        return;
+    }
+
+    data = [artworkCache storeArtworkData:data modificationDate:modificationDate forPersistentID:persistentID];
+    SIMetricsEnd(SIMetricsStageArtwork, stageStart);
+
+    [condition lock];
+    artworkData = [data retain];
+    appleEventCount = appleEventsSent;
+    fetched = YES;
+    [condition broadcast];
+    [condition unlock];
+
+    [(NSObject *)delegate performSelectorOnMainThread:@selector(artworkFetchOperationDidFinish:)
+                                           withObject:self
+                                        waitUntilDone:NO];
+}
+
+- (void)main {
+    if ([self isCancelled]) {
+        return;
+    }
+
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    [self fetch];
+    [pool drain];
+
+    SIArena *arena = SIThreadArena();
+    if (arena) {
+        SIArenaReset(arena);
+    }
+}
+
+- (BOOL)waitUntilFetchedBeforeDate:(NSDate *)date {
+    [condition lock];
+
+    while (!fetched && ![self isFinished]) {
+        if (![condition waitUntilDate:date]) {
+            break;
+        }
+    }
+
+    BOOL result = fetched;
+    [condition unlock];
+
+    return result;
+}
+
+- (unsigned long long)appleEventCount {
+    [condition lock];
+    unsigned long long count = appleEventCount;
+    [condition unlock];
+
+    return count;
+}
+
+- (NSData *)artworkData {
+    [condition lock];
+    NSData *data = [[artworkData retain] autorelease];
+    [condition unlock];
+
+    return data;
+}
+
+@end
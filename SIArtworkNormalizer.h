@@ -0,0 +1,47 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIImageResampler.h"
+
+// Shrinks artwork to notification icon size. Images larger than iconSize
+// pixels or byteBudget bytes are decoded once, resampled with
+// SIImageResample and re-encoded as PNG when they have alpha and as JPEG,
+// at decreasing quality until they fit the budget, otherwise. Images within
+// both limits are returned unchanged.
+//
+// Decoding and encoding use ImageIO, so off Mac OS X artwork passes through
+// untouched; only the resampler itself is portable.
+@interface SIArtworkNormalizer : NSObject {
+    NSUInteger iconSize;
+    NSUInteger byteBudget;
+    SIResampleFilter filter;
+}
+
+@property (nonatomic, readonly) NSUInteger iconSize;
+@property (nonatomic, readonly) NSUInteger byteBudget;
+@property (nonatomic, assign) SIResampleFilter filter;
+
+- (id)initWithIconSize:(NSUInteger)anIconSize byteBudget:(NSUInteger)aByteBudget;
+
+- (NSData *)normalizedArtworkData:(NSData *)data;
+
+@end
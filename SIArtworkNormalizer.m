@@ -0,0 +1,212 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIArtworkNormalizer.h"
+#import "SIArena.h"
+
+#ifdef __APPLE__
+#import <ApplicationServices/ApplicationServices.h>
+
+// Icons carry several representations; resample from the largest one.
+static size_t SILargestImageIndex(CGImageSourceRef source) {
+    size_t count = CGImageSourceGetCount(source);
+    size_t largestIndex = 0;
+    long long largestWidth = -1;
+
+    for (size_t i = 0; count > 1 && i < count; i++) {
+        NSDictionary *properties = [(NSDictionary *)CGImageSourceCopyPropertiesAtIndex(source, i, NULL) autorelease];
+        long long width = [[properties objectForKey:(NSString *)kCGImagePropertyPixelWidth] longLongValue];
+
+        if (width > largestWidth) {
+            largestWidth = width;
+            largestIndex = i;
+        }
+    }
+
+    return largestIndex;
+}
+
+static NSData *SIEncodeImage(CGImageRef image, NSString *type, CGFloat quality) {
+    NSMutableData *data = [NSMutableData data];
+    CGImageDestinationRef destination = CGImageDestinationCreateWithData((CFMutableDataRef)data, (CFStringRef)type, 1, NULL);
+
+    if (!destination) {
+        return nil;
+    }
+
+    NSDictionary *properties = @{(NSString *)kCGImageDestinationLossyCompressionQuality : @(quality)};
+    CGImageDestinationAddImage(destination, image, (CFDictionaryRef)properties);
+    BOOL finalized = CGImageDestinationFinalize(destination);
+    CFRelease(destination);
+
+    return finalized ? data : nil;
+}
+
+// Pixels are staged in the thread's arena when it has one. The image made
+// from the destination may share its pixels until it is released.
+static void *SICreateStagingBuffer(SIArena *arena, size_t length) {
+    void *buffer = arena ? SIArenaAllocate(arena, length) : NULL;
+
+    if (!buffer) {
+        return [[NSMutableData dataWithLength:length] mutableBytes];
+    }
+
+    memset(buffer, 0, length);
+
+    return buffer;
+}
+
+static CGImageRef SICreateResampledImage(CGImageRef image, size_t width, size_t height, SIResampleFilter filter, SIArena *arena) {
+    size_t sourceWidth = CGImageGetWidth(image);
+    size_t sourceHeight = CGImageGetHeight(image);
+    CGBitmapInfo bitmapInfo = kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big;
+    CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+    void *destinationPixels = SICreateStagingBuffer(arena, width * height * 4);
+    void *sourcePixels = SICreateStagingBuffer(arena, sourceWidth * sourceHeight * 4);
+    CGImageRef resampledImage = NULL;
+
+    CGContextRef sourceContext = CGBitmapContextCreate(sourcePixels, sourceWidth, sourceHeight, 8,
+                                                       sourceWidth * 4, colorSpace, bitmapInfo);
+    if (sourceContext) {
+        CGContextDrawImage(sourceContext, CGRectMake(0, 0, sourceWidth, sourceHeight), image);
+        CGContextRelease(sourceContext);
+
+        if (SIImageResample(sourcePixels, sourceWidth, sourceHeight, sourceWidth * 4,
+                            destinationPixels, width, height, width * 4, filter) == 0) {
+            CGContextRef destinationContext = CGBitmapContextCreate(destinationPixels, width, height, 8,
+                                                                    width * 4, colorSpace, bitmapInfo);
+            if (destinationContext) {
+                resampledImage = CGBitmapContextCreateImage(destinationContext);
+                CGContextRelease(destinationContext);
+            }
+        }
+    }
+
+    CGColorSpaceRelease(colorSpace);
+
+    return resampledImage;
+}
+#endif
+
+@implementation SIArtworkNormalizer
+
+@synthesize iconSize;
+@synthesize byteBudget;
+@synthesize filter;
+
+- (id)initWithIconSize:(NSUInteger)anIconSize byteBudget:(NSUInteger)aByteBudget {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    iconSize = anIconSize > 0 ? anIconSize : 128;
+    byteBudget = aByteBudget;
+    filter = SIResampleFilterBox;
+
+    return self;
+}
+
+#ifdef __APPLE__
+- (NSData *)normalizedArtworkData:(NSData *)data {
+    if (!data) {
+        return nil;
+    }
+
+    CGImageSourceRef source = CGImageSourceCreateWithData((CFDataRef)data, NULL);
+    if (!source) {
+        return data;
+    }
+
+    CGImageRef image = CGImageSourceCreateImageAtIndex(source, SILargestImageIndex(source), NULL);
+    CFRelease(source);
+
+    if (!image) {
+        return data;
+    }
+
+    size_t width = CGImageGetWidth(image);
+    size_t height = CGImageGetHeight(image);
+    BOOL withinBudget = !byteBudget || [data length] <= byteBudget;
+
+    if (width <= iconSize && height <= iconSize && withinBudget) {
+        CGImageRelease(image);
+        return data;
+    }
+
+    double scale = MIN(1.0, (double)iconSize / MAX(width, height));
+    size_t iconWidth = MAX((size_t)1, (size_t)(width * scale + 0.5));
+    size_t iconHeight = MAX((size_t)1, (size_t)(height * scale + 0.5));
+    CGImageAlphaInfo alphaInfo = CGImageGetAlphaInfo(image);
+    BOOL hasAlpha = alphaInfo != kCGImageAlphaNone
+        && alphaInfo != kCGImageAlphaNoneSkipFirst
+        && alphaInfo != kCGImageAlphaNoneSkipLast;
+
+    SIArena *arena = SIThreadArena();
+    SIArenaMark mark = arena ? SIArenaGetMark(arena) : (SIArenaMark){ NULL, 0, 0 };
+    CGImageRef icon = SICreateResampledImage(image, iconWidth, iconHeight, filter, arena);
+    CGImageRelease(image);
+
+    if (!icon) {
+        if (arena) {
+            SIArenaRewind(arena, mark);
+        }
+
+        return data;
+    }
+
+    NSData *normalizedData = nil;
+
+    if (hasAlpha) {
+        normalizedData = SIEncodeImage(icon, @"public.png", 1.0);
+    } else {
+        const CGFloat qualities[] = {0.85, 0.7, 0.5, 0.3};
+
+        for (size_t i = 0; i < sizeof(qualities) / sizeof(qualities[0]); i++) {
+            normalizedData = SIEncodeImage(icon, @"public.jpeg", qualities[i]);
+
+            if (!byteBudget || [normalizedData length] <= byteBudget) {
+                break;
+            }
+        }
+    }
+
+    CGImageRelease(icon);
+
+    if (arena) {
+        SIArenaRewind(arena, mark);
+    }
+
+    if (!normalizedData || [normalizedData length] >= [data length]) {
+        return data;
+    }
+
+    return normalizedData;
+}
+#else
+- (NSData *)normalizedArtworkData:(NSData *)data {
+    return data;
+}
+#endif
+
+@end
@@ -0,0 +1,69 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIArtworkCache.h"
+#import "SIMetadataProvider.h"
+
+@class SIArtworkPrefetchOperation;
+
+@protocol SIArtworkPrefetchOperationDelegate <NSObject>
+
+// Sent on the main thread when the operation finishes, cancelled or not.
+- (void)artworkPrefetchOperationDidFinish:(SIArtworkPrefetchOperation *)operation;
+
+@end
+
+// Resolves the tracks that follow the current one and stores their artwork
+// in the cache, stopping before the prefetched artwork could exceed
+// byteLimit. Skipped when nothing is playing.
+@interface SIArtworkPrefetchOperation : NSOperation {
+    NSString *persistentID;
+    NSUInteger trackCount;
+    NSUInteger byteLimit;
+    SIArtworkCache *artworkCache;
+    id<SIMetadataProvider> metadataProvider;
+    id<SIArtworkPrefetchOperationDelegate> delegate;
+    NSMutableDictionary *prefetchedBytes;
+    NSMutableSet *cachedPersistentIDs;
+    NSUInteger limitedCount;
+}
+
+@property (nonatomic, readonly) NSString *persistentID;
+@property (nonatomic, assign) id<SIArtworkPrefetchOperationDelegate> delegate;
+
+- (id)initWithPersistentID:(NSString *)aPersistentID
+                trackCount:(NSUInteger)aTrackCount
+                 byteLimit:(NSUInteger)aByteLimit
+              artworkCache:(SIArtworkCache *)anArtworkCache
+          metadataProvider:(id<SIMetadataProvider>)aMetadataProvider;
+
+// The upcoming tracks whose artwork this operation fetched, mapped to its
+// bytes; tracks found cached already are left out. Read once finished.
+- (NSDictionary *)prefetchedBytes;
+
+// The upcoming tracks whose artwork was cached already.
+- (NSSet *)cachedPersistentIDs;
+
+// The upcoming tracks left out because of the byte limit.
+- (NSUInteger)limitedCount;
+
+@end
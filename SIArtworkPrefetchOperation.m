@@ -0,0 +1,135 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIArtworkPrefetchOperation.h"
+#import "SIArena.h"
+
+@implementation SIArtworkPrefetchOperation
+
+@synthesize persistentID;
+@synthesize delegate;
+
+- (id)initWithPersistentID:(NSString *)aPersistentID
+                trackCount:(NSUInteger)aTrackCount
+                 byteLimit:(NSUInteger)aByteLimit
+              artworkCache:(SIArtworkCache *)anArtworkCache
+          metadataProvider:(id<SIMetadataProvider>)aMetadataProvider {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    persistentID = [aPersistentID copy];
+    trackCount = aTrackCount;
+    byteLimit = aByteLimit;
+    artworkCache = [anArtworkCache retain];
+    metadataProvider = [aMetadataProvider retain];
+    prefetchedBytes = [[NSMutableDictionary alloc] init];
+    cachedPersistentIDs = [[NSMutableSet alloc] init];
+
+    return self;
+}
+
+- (void)dealloc {
+    [persistentID release];
+    [artworkCache release];
+    [metadataProvider release];
+    [prefetchedBytes release];
+    [cachedPersistentIDs release];
+
+    [super dealloc];
+}
+
+- (NSDictionary *)prefetchedBytes {
+    return prefetchedBytes;
+}
+
+- (NSSet *)cachedPersistentIDs {
+    return cachedPersistentIDs;
+}
+
+- (NSUInteger)limitedCount {
+    return limitedCount;
+}
+
+- (void)prefetch {
+    if ([metadataProvider remainingTimeOfCurrentTrack] == 0) {
+        return;
+    }
+
+    NSArray *persistentIDs = [metadataProvider persistentIDsOfTracksFollowingPersistentID:persistentID count:trackCount];
+    NSUInteger worstCaseBytes = [[artworkCache normalizer] byteBudget];
+    NSUInteger totalBytes = 0;
+
+    for (NSString *upcomingPersistentID in persistentIDs) {
+        if ([self isCancelled]) {
+            return;
+        }
+
+        NSData *data = nil;
+        NSDate *modificationDate = [metadataProvider modificationDateOfTrackWithPersistentID:upcomingPersistentID];
+
+        if ([artworkCache getCachedArtworkData:&data forPersistentID:upcomingPersistentID modificationDate:modificationDate]) {
+            [cachedPersistentIDs addObject:upcomingPersistentID];
+            continue;
+        }
+
+        if (totalBytes + worstCaseBytes > byteLimit || totalBytes >= byteLimit) {
+            limitedCount++;
+            continue;
+        }
+
+        if (![metadataProvider getArtworkData:&data
+                             modificationDate:&modificationDate
+                              appleEventCount:NULL
+                              forPersistentID:upcomingPersistentID]) {
+            continue;
+        }
+
+        data = [artworkCache storeArtworkData:data modificationDate:modificationDate forPersistentID:upcomingPersistentID];
+
+        totalBytes += [data length];
+        [prefetchedBytes setObject:@([data length]) forKey:upcomingPersistentID];
+    }
+}
+
+- (void)main {
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+    if (![self isCancelled]) {
+        [self prefetch];
+    }
+
+    [(NSObject *)delegate performSelectorOnMainThread:@selector(artworkPrefetchOperationDidFinish:)
+                                           withObject:self
+                                        waitUntilDone:NO];
+
+    [pool drain];
+
+    SIArena *arena = SIThreadArena();
+    if (arena) {
+        SIArenaReset(arena);
+    }
+}
+
+@end
@@ -0,0 +1,80 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIArtworkCache.h"
+#import "SIArtworkPrefetchOperation.h"
+#import "SIMetadataProvider.h"
+#import "SITrack.h"
+
+// Warms the artwork cache with the tracks that follow the one playing, so
+// that sequential playback finds its artwork cached. A prefetch starts delay
+// seconds into each track, once the notification is out, on a serial queue
+// of its own at low thread priority, so that it never holds up the
+// pipeline's fetch of a cache miss; a track change cancels it. Prefetched
+// artwork not yet played is capped at byteLimit bytes.
+//
+// A track that starts with its artwork fetched by a prefetch is a hit; one
+// that starts after a finished prefetch without it is a miss, and upcoming
+// tracks found cached already count as neither. Prefetched tracks that never
+// start are wasted. Main thread only.
+@interface SIArtworkPrefetcher : NSObject <SIArtworkPrefetchOperationDelegate> {
+    id<SIMetadataProvider> metadataProvider;
+    SIArtworkCache *artworkCache;
+    NSOperationQueue *operationQueue;
+    NSUInteger trackCount;
+    NSTimeInterval delay;
+    NSUInteger byteLimit;
+    NSString *currentPersistentID;
+    SIArtworkPrefetchOperation *pendingOperation;
+    NSMutableDictionary *prefetchedBytes;
+    NSMutableSet *cachedPersistentIDs;
+    BOOL prefetched;
+    NSUInteger prefetchCount;
+    NSUInteger hitCount;
+    NSUInteger missCount;
+    NSUInteger wastedCount;
+    NSUInteger limitedCount;
+}
+
+@property (nonatomic, assign) NSUInteger trackCount;
+@property (nonatomic, assign) NSTimeInterval delay;
+@property (nonatomic, assign) NSUInteger byteLimit;
+@property (nonatomic, readonly) NSUInteger prefetchCount;
+@property (nonatomic, readonly) NSUInteger hitCount;
+@property (nonatomic, readonly) NSUInteger missCount;
+@property (nonatomic, readonly) NSUInteger wastedCount;
+@property (nonatomic, readonly) NSUInteger limitedCount;
+
+- (id)initWithMetadataProvider:(id<SIMetadataProvider>)aMetadataProvider
+                  artworkCache:(SIArtworkCache *)anArtworkCache;
+
+// Called for every playing event; repeats for the same track are ignored.
+- (void)trackDidStart:(SITrack *)track;
+
+- (void)cancel;
+
+// Bytes of prefetched artwork whose tracks have not started yet.
+- (NSUInteger)outstandingBytes;
+
+- (NSString *)statisticsSummary;
+
+@end
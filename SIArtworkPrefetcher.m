@@ -0,0 +1,163 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIArtworkPrefetcher.h"
+
+// Below the default of 0.5 the pipeline's fetches run at.
+static const double SIArtworkPrefetchThreadPriority = 0.1;
+
+@implementation SIArtworkPrefetcher
+
+@synthesize trackCount;
+@synthesize delay;
+@synthesize byteLimit;
+@synthesize prefetchCount;
+@synthesize hitCount;
+@synthesize missCount;
+@synthesize wastedCount;
+@synthesize limitedCount;
+
+- (id)initWithMetadataProvider:(id<SIMetadataProvider>)aMetadataProvider
+                  artworkCache:(SIArtworkCache *)anArtworkCache {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    metadataProvider = [aMetadataProvider retain];
+    artworkCache = [anArtworkCache retain];
+    operationQueue = [[NSOperationQueue alloc] init];
+    [operationQueue setMaxConcurrentOperationCount:1];
+    trackCount = 2;
+    delay = 1;
+    byteLimit = 1024 * 1024;
+    prefetchedBytes = [[NSMutableDictionary alloc] init];
+    cachedPersistentIDs = [[NSMutableSet alloc] init];
+
+    return self;
+}
+
+- (void)dealloc {
+    [self cancel];
+    [operationQueue waitUntilAllOperationsAreFinished];
+    [metadataProvider release];
+    [artworkCache release];
+    [operationQueue release];
+    [currentPersistentID release];
+    [prefetchedBytes release];
+    [cachedPersistentIDs release];
+
+    [super dealloc];
+}
+
+- (void)cancel {
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(prefetch) object:nil];
+    [pendingOperation setDelegate:nil];
+    [pendingOperation cancel];
+    [pendingOperation release];
+    pendingOperation = nil;
+}
+
+- (void)trackDidStart:(SITrack *)track {
+    NSString *persistentID = [track persistentID];
+
+    if (!persistentID || [persistentID isEqualToString:currentPersistentID]) {
+        return;
+    }
+
+    if ([prefetchedBytes objectForKey:persistentID]) {
+        hitCount++;
+        [prefetchedBytes removeObjectForKey:persistentID];
+    } else if (prefetched && ![cachedPersistentIDs containsObject:persistentID]) {
+        missCount++;
+    }
+
+    prefetched = NO;
+    [cachedPersistentIDs removeAllObjects];
+
+    // Whatever was prefetched for the previous track and did not play is no
+    // longer upcoming.
+    wastedCount += [prefetchedBytes count];
+    [prefetchedBytes removeAllObjects];
+
+    [currentPersistentID release];
+    currentPersistentID = [persistentID copy];
+
+    [self cancel];
+
+    if (trackCount && byteLimit) {
+        [self performSelector:@selector(prefetch) withObject:nil afterDelay:delay];
+    }
+}
+
+- (void)prefetch {
+    pendingOperation = [[SIArtworkPrefetchOperation alloc] initWithPersistentID:currentPersistentID
+                                                                     trackCount:trackCount
+                                                                      byteLimit:byteLimit
+                                                                   artworkCache:artworkCache
+                                                               metadataProvider:metadataProvider];
+    [pendingOperation setDelegate:self];
+    [pendingOperation setThreadPriority:SIArtworkPrefetchThreadPriority];
+    [operationQueue addOperation:pendingOperation];
+    prefetchCount++;
+}
+
+- (void)artworkPrefetchOperationDidFinish:(SIArtworkPrefetchOperation *)operation {
+    if (operation != pendingOperation) {
+        return;
+    }
+
+    [prefetchedBytes addEntriesFromDictionary:[operation prefetchedBytes]];
+    [cachedPersistentIDs unionSet:[operation cachedPersistentIDs]];
+    limitedCount += [operation limitedCount];
+    prefetched = YES;
+
+    [pendingOperation release];
+    pendingOperation = nil;
+}
+
+- (NSUInteger)outstandingBytes {
+    NSUInteger bytes = 0;
+
+    for (NSNumber *trackBytes in [prefetchedBytes allValues]) {
+        bytes += [trackBytes unsignedIntegerValue];
+    }
+
+    return bytes;
+}
+
+- (NSString *)statisticsSummary {
+    NSUInteger startCount = hitCount + missCount;
+
+    return [NSString stringWithFormat:@"prefetch: %lu runs, %lu hits, %lu misses (%.0f%% hit rate), "
+                                      @"%lu wasted, %lu over the limit, %lu bytes outstanding",
+        (unsigned long)prefetchCount,
+        (unsigned long)hitCount,
+        (unsigned long)missCount,
+        startCount ? 100.0 * hitCount / startCount : 0.0,
+        (unsigned long)wastedCount,
+        (unsigned long)limitedCount,
+        (unsigned long)[self outstandingBytes]];
+}
+
+@end
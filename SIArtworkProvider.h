@@ -0,0 +1,40 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Supplies the raw artwork bytes of a track. The iTunes implementation goes
+// through the Scripting Bridge; others may be stubs or file-backed.
+@protocol SIArtworkProvider <NSObject>
+
+// Fetches the artwork of a track, nil when it has none, and the modification
+// date of its content when known, and counts in appleEventCount, if not NULL,
+// the round trips this call made. Returns NO, leaving nothing to cache, when
+// the track cannot be resolved, as when the player has moved on from it.
+- (BOOL)getArtworkData:(NSData **)data
+      modificationDate:(NSDate **)modificationDate
+       appleEventCount:(unsigned long long *)appleEventCount
+       forPersistentID:(NSString *)persistentID;
+
+// The number of round trips made to the player so far (Apple Events, for
+// iTunes), from any thread.
+- (unsigned long long)appleEventCount;
+
+@end
@@ -0,0 +1,76 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+@class SIArtworkPackMapping;
+
+// One copy of every distinct artwork image, shared by all the tracks that
+// carry it and counted by reference. Images are found by SIContentHash64 and
+// compared byte for byte before they are shared.
+//
+// With a path, images and the tracks that use them are appended to a pack
+// file, and images are served from read-only mappings of it, so a restarted
+// daemon starts warm without asking the player again and the kernel can drop
+// the pages under memory pressure. Images no track uses any more are
+// compacted away when the pack is opened, once they make up more than half of
+// it. Data handed out holds the mapping it points into, and a mapping is
+// unmapped once no image or data uses it, so images dropped and packs
+// discarded give back their address space. All methods are thread-safe.
+@interface SIArtworkStore : NSObject {
+    NSString *path;
+    int fileDescriptor;
+    unsigned long long fileLength;
+    SIArtworkPackMapping *appendMapping;
+    NSMutableDictionary *images;
+    NSMutableDictionary *references;
+    unsigned long long residentBytes;
+    unsigned long long referencedBytes;
+    NSLock *lock;
+}
+
+@property (nonatomic, readonly) NSString *path;
+
+// A nil path keeps the images in memory only. A pack that cannot be opened
+// is logged and the store falls back to memory.
+- (id)initWithPath:(NSString *)aPath;
+
+// Makes key refer to the image, replacing what it referred to before, and
+// returns the shared copy. Nil data removes the key.
+- (NSData *)storeData:(NSData *)data forKey:(NSString *)key;
+- (NSData *)dataForKey:(NSString *)key;
+- (void)removeDataForKey:(NSString *)key;
+- (void)removeAllData;
+
+// Lets the kernel drop the pages of the key's image until they are next
+// read, when they come back from the pack. Images in memory are kept.
+- (void)discardPagesForKey:(NSString *)key;
+
+- (NSUInteger)imageCount;
+- (NSUInteger)keyCount;
+
+// The bytes of the distinct images, and of the images every key refers to;
+// the second over the first is the deduplication ratio.
+- (unsigned long long)residentBytes;
+- (unsigned long long)referencedBytes;
+- (double)deduplicationRatio;
+- (NSString *)statisticsSummary;
+
+@end
@@ -0,0 +1,757 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <errno.h>
+#import <fcntl.h>
+#import <stddef.h>
+#import <string.h>
+#import <sys/mman.h>
+#import <sys/stat.h>
+#import <unistd.h>
+#import "SIArtworkStore.h"
+#import "SIContentHash.h"
+
+static const uint64_t SIArtworkPackMagic = 0x324b504b52414953ULL;  // "SIARKPK2"
+
+// Appended images are served from windows of the pack this long, or as long
+// as the image if it is longer, so that a mapping is not made per image.
+static const size_t SIArtworkPackWindowLength = 4 * 1024 * 1024;
+
+enum {
+    SIArtworkPackImageRecord = 1,
+    SIArtworkPackReferenceRecord = 2,
+    SIArtworkPackUnreferenceRecord = 3
+};
+
+// Every record starts on an eight-byte boundary: this header, then length
+// bytes of payload, which is the image for an image record and the UTF-8 key
+// for the others. Reference records name the image by hash. The checksum
+// covers the header before it and the payload, so the pack ends at the first
+// torn or damaged record.
+typedef struct SIArtworkPackRecord {
+    uint32_t type;
+    uint32_t length;
+    uint64_t hash;
+    uint32_t checksum;
+    uint32_t reserved;
+} SIArtworkPackRecord;
+
+static unsigned long long SIArtworkPackRecordSize(unsigned long long length) {
+    return (sizeof(SIArtworkPackRecord) + length + 7) & ~7ULL;
+}
+
+static uint32_t SIArtworkPackChecksum(const SIArtworkPackRecord *record, const void *payload) {
+    uint64_t seed = SIContentHash64(record, offsetof(SIArtworkPackRecord, checksum), 0);
+
+    return (uint32_t)SIContentHash64(payload, record->length, seed);
+}
+
+static BOOL SIWriteFully(int fileDescriptor, const void *bytes, size_t length, off_t offset) {
+    const char *cursor = bytes;
+
+    while (length > 0) {
+        ssize_t written = pwrite(fileDescriptor, cursor, length, offset);
+
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return NO;
+        }
+
+        cursor += written;
+        length -= (size_t)written;
+        offset += written;
+    }
+
+    return YES;
+}
+
+// A read-only mapping of part of the pack, unmapped when released for the
+// last time. It may run past the end of the file, which is only ever read
+// where it has been written.
+@interface SIArtworkPackMapping : NSObject {
+    char *bytes;
+    unsigned long long offset;
+    size_t length;
+}
+
+// The offset must be a multiple of the page size.
+- (id)initWithFileDescriptor:(int)fileDescriptor offset:(unsigned long long)anOffset length:(size_t)aLength;
+
+- (const char *)bytes;
+- (BOOL)containsOffset:(unsigned long long)anOffset length:(NSUInteger)aLength;
+
+// Data for that part of the pack, which holds the mapping until it is freed.
+- (NSData *)dataWithOffset:(unsigned long long)anOffset length:(NSUInteger)aLength;
+
+@end
+
+// Bytes inside a pack mapping.
+@interface SIArtworkMappedData : NSData {
+    SIArtworkPackMapping *mapping;
+    const void *mappedBytes;
+    NSUInteger mappedLength;
+}
+
+- (id)initWithMapping:(SIArtworkPackMapping *)aMapping bytes:(const void *)someBytes length:(NSUInteger)aLength;
+
+@end
+
+@implementation SIArtworkPackMapping
+
+- (id)initWithFileDescriptor:(int)fileDescriptor offset:(unsigned long long)anOffset length:(size_t)aLength {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    bytes = mmap(NULL, aLength, PROT_READ, MAP_SHARED, fileDescriptor, (off_t)anOffset);
+    if (bytes == MAP_FAILED) {
+        bytes = NULL;
+        [self release];
+        return nil;
+    }
+
+    offset = anOffset;
+    length = aLength;
+
+    return self;
+}
+
+- (void)dealloc {
+    if (bytes) {
+        munmap(bytes, length);
+    }
+
+    [super dealloc];
+}
+
+- (const char *)bytes {
+    return bytes;
+}
+
+- (BOOL)containsOffset:(unsigned long long)anOffset length:(NSUInteger)aLength {
+    return anOffset >= offset && anOffset + aLength <= offset + length;
+}
+
+- (NSData *)dataWithOffset:(unsigned long long)anOffset length:(NSUInteger)aLength {
+    return [[[SIArtworkMappedData alloc] initWithMapping:self
+                                                   bytes:bytes + (anOffset - offset)
+                                                  length:aLength] autorelease];
+}
+
+@end
+
+@implementation SIArtworkMappedData
+
+- (id)initWithMapping:(SIArtworkPackMapping *)aMapping bytes:(const void *)someBytes length:(NSUInteger)aLength {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    mapping = [aMapping retain];
+    mappedBytes = someBytes;
+    mappedLength = aLength;
+
+    return self;
+}
+
+- (void)dealloc {
+    [mapping release];
+
+    [super dealloc];
+}
+
+- (const void *)bytes {
+    return mappedBytes;
+}
+
+- (NSUInteger)length {
+    return mappedLength;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    return [self retain];
+}
+
+@end
+
+@interface SIArtworkStoreImage : NSObject {
+    NSData *data;
+    NSUInteger referenceCount;
+    BOOL mapped;
+}
+
+@property (nonatomic, retain) NSData *data;
+@property (nonatomic, assign) NSUInteger referenceCount;
+@property (nonatomic, assign, getter=isMapped) BOOL mapped;
+
+@end
+
+@implementation SIArtworkStoreImage
+
+@synthesize data;
+@synthesize referenceCount;
+@synthesize mapped;
+
+- (void)dealloc {
+    [data release];
+
+    [super dealloc];
+}
+
+@end
+
+@implementation SIArtworkStore
+
+@synthesize path;
+
+- (id)init {
+    return [self initWithPath:nil];
+}
+
+- (id)initWithPath:(NSString *)aPath {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    fileDescriptor = -1;
+    images = [[NSMutableDictionary alloc] init];
+    references = [[NSMutableDictionary alloc] init];
+    lock = [[NSLock alloc] init];
+
+    if (aPath) {
+        path = [aPath copy];
+
+        if (![self openPackCompacting:YES]) {
+            NSLog(@"Could not open the artwork pack %@: %s", path, strerror(errno));
+            [self closePack];
+            [images removeAllObjects];
+            [references removeAllObjects];
+            residentBytes = 0;
+            referencedBytes = 0;
+        }
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [self closePack];
+    [path release];
+    [images release];
+    [references release];
+    [lock release];
+
+    [super dealloc];
+}
+
+// Mappings outlive the descriptor; data still handed out keeps them.
+- (void)closePack {
+    [appendMapping release];
+    appendMapping = nil;
+
+    if (fileDescriptor >= 0) {
+        close(fileDescriptor);
+        fileDescriptor = -1;
+    }
+}
+
+#pragma mark - Pack
+
+- (BOOL)appendRecordOfType:(uint32_t)type hash:(uint64_t)hash bytes:(const void *)bytes length:(NSUInteger)length {
+    SIArtworkPackRecord record = { type, (uint32_t)length, hash, 0, 0 };
+    record.checksum = SIArtworkPackChecksum(&record, bytes);
+    unsigned long long recordSize = SIArtworkPackRecordSize(length);
+    NSMutableData *buffer = [NSMutableData dataWithLength:(NSUInteger)recordSize];
+
+    memcpy([buffer mutableBytes], &record, sizeof(record));
+    memcpy((char *)[buffer mutableBytes] + sizeof(record), bytes, length);
+
+    if (!SIWriteFully(fileDescriptor, [buffer bytes], [buffer length], (off_t)fileLength)) {
+        ftruncate(fileDescriptor, (off_t)fileLength);
+        return NO;
+    }
+
+    fileLength += recordSize;
+
+    return YES;
+}
+
+- (BOOL)appendReferenceOfType:(uint32_t)type hash:(uint64_t)hash key:(NSString *)key {
+    if (fileDescriptor < 0) {
+        return NO;
+    }
+
+    const char *bytes = [key UTF8String];
+
+    return [self appendRecordOfType:type hash:hash bytes:bytes length:strlen(bytes)];
+}
+
+// Appends the image and returns it from the mapped window of the pack it
+// landed in, or nil if either fails. A window the image does not fit is let
+// go for a new one starting at the image.
+- (NSData *)appendImageData:(NSData *)data hash:(uint64_t)hash {
+    if (fileDescriptor < 0 || ![data length] || [data length] > UINT32_MAX) {
+        return nil;
+    }
+
+    unsigned long long recordOffset = fileLength;
+    if (![self appendRecordOfType:SIArtworkPackImageRecord hash:hash bytes:[data bytes] length:[data length]]) {
+        return nil;
+    }
+
+    unsigned long long imageOffset = recordOffset + sizeof(SIArtworkPackRecord);
+
+    if (![appendMapping containsOffset:imageOffset length:[data length]]) {
+        unsigned long long pageSize = (unsigned long long)sysconf(_SC_PAGESIZE);
+        unsigned long long mapOffset = imageOffset & ~(pageSize - 1);
+        size_t mapLength = (size_t)(imageOffset + [data length] - mapOffset);
+
+        [appendMapping release];
+        appendMapping = [[SIArtworkPackMapping alloc] initWithFileDescriptor:fileDescriptor
+                                                                      offset:mapOffset
+                                                                      length:MAX(mapLength, SIArtworkPackWindowLength)];
+    }
+
+    return [appendMapping dataWithOffset:imageOffset length:[data length]];
+}
+
+- (BOOL)resetPack {
+    [self closePack];
+    unlink([path fileSystemRepresentation]);
+
+    fileDescriptor = open([path fileSystemRepresentation], O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fileDescriptor < 0) {
+        return NO;
+    }
+
+    fcntl(fileDescriptor, F_SETFD, FD_CLOEXEC);
+
+    if (!SIWriteFully(fileDescriptor, &SIArtworkPackMagic, sizeof(SIArtworkPackMagic), 0)) {
+        return NO;
+    }
+
+    fileLength = sizeof(SIArtworkPackMagic);
+
+    return YES;
+}
+
+// Reads the pack back: the last record for each key wins, and images no key
+// refers to are skipped. The pack is cut off at the first record that is
+// torn or fails its checksum.
+- (BOOL)openPackCompacting:(BOOL)compacting {
+    fileDescriptor = open([path fileSystemRepresentation], O_RDWR | O_CREAT, 0644);
+    if (fileDescriptor < 0) {
+        return NO;
+    }
+
+    fcntl(fileDescriptor, F_SETFD, FD_CLOEXEC);
+
+    struct stat status;
+    if (fstat(fileDescriptor, &status) != 0) {
+        return NO;
+    }
+
+    uint64_t magic = 0;
+    if (status.st_size < (off_t)sizeof(magic)
+        || pread(fileDescriptor, &magic, sizeof(magic), 0) != sizeof(magic)
+        || magic != SIArtworkPackMagic) {
+        return [self resetPack];
+    }
+
+    size_t mapLength = (size_t)status.st_size;
+    SIArtworkPackMapping *mapping = [[SIArtworkPackMapping alloc] initWithFileDescriptor:fileDescriptor
+                                                                                  offset:0
+                                                                                  length:mapLength];
+    if (!mapping) {
+        return NO;
+    }
+
+    const char *base = [mapping bytes];
+
+    NSMutableDictionary *imageRanges = [NSMutableDictionary dictionary];
+    NSMutableDictionary *keyHashes = [NSMutableDictionary dictionary];
+    unsigned long long offset = sizeof(magic);
+
+    while (offset + sizeof(SIArtworkPackRecord) <= mapLength) {
+        SIArtworkPackRecord record;
+        memcpy(&record, base + offset, sizeof(record));
+
+        unsigned long long payloadOffset = offset + sizeof(record);
+        if (payloadOffset + record.length > mapLength
+            || record.checksum != SIArtworkPackChecksum(&record, base + payloadOffset)) {
+            break;
+        }
+
+        NSNumber *hashNumber = [NSNumber numberWithUnsignedLongLong:record.hash];
+
+        if (record.type == SIArtworkPackImageRecord) {
+            [imageRanges setObject:[NSValue valueWithRange:NSMakeRange((NSUInteger)payloadOffset, record.length)]
+                            forKey:hashNumber];
+        } else if (record.type == SIArtworkPackReferenceRecord || record.type == SIArtworkPackUnreferenceRecord) {
+            NSString *key = [[[NSString alloc] initWithBytes:base + payloadOffset
+                                                      length:record.length
+                                                    encoding:NSUTF8StringEncoding] autorelease];
+
+            if (!key) {
+                break;
+            }
+
+            if (record.type == SIArtworkPackReferenceRecord) {
+                [keyHashes setObject:hashNumber forKey:key];
+            } else {
+                [keyHashes removeObjectForKey:key];
+            }
+        } else {
+            break;
+        }
+
+        offset += SIArtworkPackRecordSize(record.length);
+    }
+
+    if (offset > mapLength) {
+        offset = mapLength;
+    }
+
+    if (offset < mapLength) {
+        ftruncate(fileDescriptor, (off_t)offset);
+    }
+
+    fileLength = offset;
+
+    unsigned long long liveLength = sizeof(magic);
+
+    for (NSString *key in keyHashes) {
+        NSNumber *hashNumber = [keyHashes objectForKey:key];
+        NSValue *range = [imageRanges objectForKey:hashNumber];
+
+        if (!range) {
+            continue;
+        }
+
+        SIArtworkStoreImage *image = [images objectForKey:hashNumber];
+        NSRange imageRange = [range rangeValue];
+
+        if (!image) {
+            image = [[[SIArtworkStoreImage alloc] init] autorelease];
+            [image setData:[mapping dataWithOffset:imageRange.location length:imageRange.length]];
+            [image setMapped:YES];
+            [images setObject:image forKey:hashNumber];
+            residentBytes += imageRange.length;
+            liveLength += SIArtworkPackRecordSize(imageRange.length);
+        }
+
+        [image setReferenceCount:[image referenceCount] + 1];
+        [references setObject:hashNumber forKey:key];
+        referencedBytes += imageRange.length;
+        liveLength += SIArtworkPackRecordSize(strlen([key UTF8String]));
+    }
+
+    if (compacting && fileLength > 2 * liveLength) {
+        [self compactPack];
+
+        [images removeAllObjects];
+        [references removeAllObjects];
+        residentBytes = 0;
+        referencedBytes = 0;
+        [mapping release];
+        [self closePack];
+
+        return [self openPackCompacting:NO];
+    }
+
+    [mapping release];
+
+    return YES;
+}
+
+// Writes the live images and references to a new pack and moves it over
+// the old one, leaving the old one alone if anything fails. Only called
+// while opening, before any data is handed out.
+- (BOOL)compactPack {
+    NSString *compactPath = [path stringByAppendingPathExtension:@"compact"];
+    NSString *packPath = path;
+    int packFileDescriptor = fileDescriptor;
+    unsigned long long packLength = fileLength;
+    BOOL compacted = YES;
+
+    path = compactPath;
+    fileDescriptor = -1;
+
+    if (![self resetPack]) {
+        compacted = NO;
+    }
+
+    for (NSNumber *hashNumber in images) {
+        if (!compacted) {
+            break;
+        }
+
+        NSData *data = [[images objectForKey:hashNumber] data];
+        compacted = [self appendRecordOfType:SIArtworkPackImageRecord
+                                        hash:[hashNumber unsignedLongLongValue]
+                                       bytes:[data bytes]
+                                      length:[data length]];
+    }
+
+    for (NSString *key in references) {
+        if (!compacted) {
+            break;
+        }
+
+        compacted = [self appendReferenceOfType:SIArtworkPackReferenceRecord
+                                           hash:[[references objectForKey:key] unsignedLongLongValue]
+                                            key:key];
+    }
+
+    if (compacted) {
+        compacted = fsync(fileDescriptor) == 0
+            && rename([compactPath fileSystemRepresentation], [packPath fileSystemRepresentation]) == 0;
+    }
+
+    if (!compacted) {
+        unlink([compactPath fileSystemRepresentation]);
+    }
+
+    [self closePack];
+    path = packPath;
+    fileDescriptor = packFileDescriptor;
+    fileLength = packLength;
+
+    return compacted;
+}
+
+#pragma mark - Images
+
+// Finds the image with these bytes, probing past hash collisions; on return
+// hash is the one the image is, or would be, stored under.
+- (SIArtworkStoreImage *)imageForData:(NSData *)data hash:(uint64_t *)hash {
+    for (;;) {
+        SIArtworkStoreImage *image = [images objectForKey:[NSNumber numberWithUnsignedLongLong:*hash]];
+
+        if (!image || [[image data] isEqualToData:data]) {
+            return image;
+        }
+
+        (*hash)++;
+    }
+}
+
+- (void)releaseImageWithHash:(NSNumber *)hashNumber {
+    SIArtworkStoreImage *image = [images objectForKey:hashNumber];
+    NSUInteger length = [[image data] length];
+
+    referencedBytes -= length;
+    [image setReferenceCount:[image referenceCount] - 1];
+
+    if (![image referenceCount]) {
+        residentBytes -= length;
+        [images removeObjectForKey:hashNumber];
+    }
+}
+
+- (NSData *)storeData:(NSData *)data forKey:(NSString *)key {
+    if (!data) {
+        [self removeDataForKey:key];
+        return nil;
+    }
+
+    if (!key) {
+        return data;
+    }
+
+    uint64_t hash = SIContentHash64([data bytes], [data length], 0);
+
+    [lock lock];
+
+    SIArtworkStoreImage *image = [self imageForData:data hash:&hash];
+    NSNumber *hashNumber = [NSNumber numberWithUnsignedLongLong:hash];
+    NSNumber *previousHashNumber = [[[references objectForKey:key] retain] autorelease];
+
+    if (image && [previousHashNumber isEqualToNumber:hashNumber]) {
+        NSData *sharedData = [[[image data] retain] autorelease];
+        [lock unlock];
+        return sharedData;
+    }
+
+    if (!image) {
+        NSData *mappedData = [self appendImageData:data hash:hash];
+
+        image = [[[SIArtworkStoreImage alloc] init] autorelease];
+        [image setData:mappedData ? mappedData : [[data copy] autorelease]];
+        [image setMapped:mappedData != nil];
+        [images setObject:image forKey:hashNumber];
+        residentBytes += [data length];
+    }
+
+    [image setReferenceCount:[image referenceCount] + 1];
+    referencedBytes += [data length];
+    [references setObject:hashNumber forKey:key];
+
+    if (previousHashNumber) {
+        [self releaseImageWithHash:previousHashNumber];
+    }
+
+    [self appendReferenceOfType:SIArtworkPackReferenceRecord hash:hash key:key];
+
+    NSData *sharedData = [[[image data] retain] autorelease];
+    [lock unlock];
+
+    return sharedData;
+}
+
+- (NSData *)dataForKey:(NSString *)key {
+    if (!key) {
+        return nil;
+    }
+
+    [lock lock];
+    NSNumber *hashNumber = [references objectForKey:key];
+    NSData *data = hashNumber ? [[[[images objectForKey:hashNumber] data] retain] autorelease] : nil;
+    [lock unlock];
+
+    return data;
+}
+
+- (void)removeDataForKey:(NSString *)key {
+    if (!key) {
+        return;
+    }
+
+    [lock lock];
+
+    NSNumber *hashNumber = [references objectForKey:key];
+    if (hashNumber) {
+        [self releaseImageWithHash:hashNumber];
+        [self appendReferenceOfType:SIArtworkPackUnreferenceRecord hash:[hashNumber unsignedLongLongValue] key:key];
+        [references removeObjectForKey:key];
+    }
+
+    [lock unlock];
+}
+
+- (void)discardPagesForKey:(NSString *)key {
+    if (!key) {
+        return;
+    }
+
+    [lock lock];
+
+    NSNumber *hashNumber = [references objectForKey:key];
+    SIArtworkStoreImage *image = hashNumber ? [images objectForKey:hashNumber] : nil;
+
+    // Only the pages wholly inside the image, so that its neighbours keep
+    // theirs.
+    if ([image isMapped]) {
+        uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+        uintptr_t start = ((uintptr_t)[[image data] bytes] + pageSize - 1) & ~(pageSize - 1);
+        uintptr_t end = ((uintptr_t)[[image data] bytes] + [[image data] length]) & ~(pageSize - 1);
+
+        if (end > start) {
+            madvise((void *)start, end - start, MADV_DONTNEED);
+        }
+    }
+
+    [lock unlock];
+}
+
+- (void)removeAllData {
+    [lock lock];
+
+    [images removeAllObjects];
+    [references removeAllObjects];
+    residentBytes = 0;
+    referencedBytes = 0;
+
+    // Start a new file rather than truncating this one: data handed out may
+    // still point into its mappings, which go once that data does.
+    if (fileDescriptor >= 0 && ![self resetPack]) {
+        NSLog(@"Could not reset the artwork pack %@: %s", path, strerror(errno));
+        [self closePack];
+    }
+
+    [lock unlock];
+}
+
+#pragma mark - Statistics
+
+- (NSUInteger)imageCount {
+    [lock lock];
+    NSUInteger count = [images count];
+    [lock unlock];
+
+    return count;
+}
+
+- (NSUInteger)keyCount {
+    [lock lock];
+    NSUInteger count = [references count];
+    [lock unlock];
+
+    return count;
+}
+
+- (unsigned long long)residentBytes {
+    [lock lock];
+    unsigned long long bytes = residentBytes;
+    [lock unlock];
+
+    return bytes;
+}
+
+- (unsigned long long)referencedBytes {
+    [lock lock];
+    unsigned long long bytes = referencedBytes;
+    [lock unlock];
+
+    return bytes;
+}
+
+- (double)deduplicationRatio {
+    [lock lock];
+    double ratio = residentBytes ? (double)referencedBytes / residentBytes : 1.0;
+    [lock unlock];
+
+    return ratio;
+}
+
+- (NSString *)statisticsSummary {
+    [lock lock];
+    NSString *summary = [NSString stringWithFormat:@"artwork store: %lu images for %lu tracks, %llu bytes resident, %.2fx deduplication",
+        (unsigned long)[images count],
+        (unsigned long)[references count],
+        residentBytes,
+        residentBytes ? (double)referencedBytes / residentBytes : 1.0];
+    [lock unlock];
+
+    return summary;
+}
+
+@end
@@ -0,0 +1,182 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <string.h>
+#include "SIContentHash.h"
+
+#define SIPrime1 0x9E3779B185EBCA87ULL
+#define SIPrime2 0xC2B2AE3D27D4EB4FULL
+#define SIPrime3 0x165667B19E3779F9ULL
+#define SIPrime4 0x85EBCA77C2B2AE63ULL
+#define SIPrime5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t SIRotateLeft(uint64_t value, int count) {
+    return (value << count) | (value >> (64 - count));
+}
+
+static inline uint64_t SIRead64(const unsigned char *bytes) {
+    uint64_t value;
+    memcpy(&value, bytes, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap64(value);
+#endif
+    return value;
+}
+
+static inline uint32_t SIRead32(const unsigned char *bytes) {
+    uint32_t value;
+    memcpy(&value, bytes, sizeof(value));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    value = __builtin_bswap32(value);
+#endif
+    return value;
+}
+
+static inline uint64_t SIRound(uint64_t accumulator, uint64_t input) {
+    accumulator += input * SIPrime2;
+    accumulator = SIRotateLeft(accumulator, 31);
+    return accumulator * SIPrime1;
+}
+
+static inline uint64_t SIMergeRound(uint64_t hash, uint64_t accumulator) {
+    hash ^= SIRound(0, accumulator);
+    return hash * SIPrime1 + SIPrime4;
+}
+
+static inline uint64_t SIMergeAccumulators(const uint64_t accumulators[4]) {
+    uint64_t hash = SIRotateLeft(accumulators[0], 1) + SIRotateLeft(accumulators[1], 7)
+                  + SIRotateLeft(accumulators[2], 12) + SIRotateLeft(accumulators[3], 18);
+
+    hash = SIMergeRound(hash, accumulators[0]);
+    hash = SIMergeRound(hash, accumulators[1]);
+    hash = SIMergeRound(hash, accumulators[2]);
+    return SIMergeRound(hash, accumulators[3]);
+}
+
+// Mixes in the last bytes, fewer than 32, and avalanches.
+static uint64_t SIFinish(uint64_t hash, const unsigned char *cursor, const unsigned char *end) {
+    while (cursor + 8 <= end) {
+        hash ^= SIRound(0, SIRead64(cursor));
+        hash = SIRotateLeft(hash, 27) * SIPrime1 + SIPrime4;
+        cursor += 8;
+    }
+
+    if (cursor + 4 <= end) {
+        hash ^= (uint64_t)SIRead32(cursor) * SIPrime1;
+        hash = SIRotateLeft(hash, 23) * SIPrime2 + SIPrime3;
+        cursor += 4;
+    }
+
+    while (cursor < end) {
+        hash ^= (*cursor) * SIPrime5;
+        hash = SIRotateLeft(hash, 11) * SIPrime1;
+        cursor++;
+    }
+
+    hash ^= hash >> 33;
+    hash *= SIPrime2;
+    hash ^= hash >> 29;
+    hash *= SIPrime3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+uint64_t SIContentHash64(const void *bytes, size_t length, uint64_t seed) {
+    const unsigned char *cursor = bytes;
+    const unsigned char *end = cursor + length;
+    uint64_t hash;
+
+    if (length >= 32) {
+        const unsigned char *limit = end - 32;
+        uint64_t v1 = seed + SIPrime1 + SIPrime2;
+        uint64_t v2 = seed + SIPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - SIPrime1;
+
+        do {
+            v1 = SIRound(v1, SIRead64(cursor));
+            v2 = SIRound(v2, SIRead64(cursor + 8));
+            v3 = SIRound(v3, SIRead64(cursor + 16));
+            v4 = SIRound(v4, SIRead64(cursor + 24));
+            cursor += 32;
+        } while (cursor <= limit);
+
+        hash = SIMergeAccumulators((const uint64_t[4]){ v1, v2, v3, v4 });
+    } else {
+        hash = seed + SIPrime5;
+    }
+
+    return SIFinish(hash + (uint64_t)length, cursor, end);
+}
+
+void SIContentHashBegin(SIContentHashState *state, uint64_t seed) {
+    memset(state, 0, sizeof(*state));
+    state->accumulators[0] = seed + SIPrime1 + SIPrime2;
+    state->accumulators[1] = seed + SIPrime2;
+    state->accumulators[2] = seed;
+    state->accumulators[3] = seed - SIPrime1;
+    state->seed = seed;
+}
+
+static inline void SIConsumeStripe(uint64_t accumulators[4], const unsigned char *stripe) {
+    accumulators[0] = SIRound(accumulators[0], SIRead64(stripe));
+    accumulators[1] = SIRound(accumulators[1], SIRead64(stripe + 8));
+    accumulators[2] = SIRound(accumulators[2], SIRead64(stripe + 16));
+    accumulators[3] = SIRound(accumulators[3], SIRead64(stripe + 24));
+}
+
+void SIContentHashUpdate(SIContentHashState *state, const void *bytes, size_t length) {
+    const unsigned char *cursor = bytes;
+    const unsigned char *end = cursor + length;
+
+    state->length += length;
+
+    if (state->bufferLength + length < sizeof(state->buffer)) {
+        memcpy(state->buffer + state->bufferLength, cursor, length);
+        state->bufferLength += length;
+        return;
+    }
+
+    if (state->bufferLength) {
+        size_t fill = sizeof(state->buffer) - state->bufferLength;
+
+        memcpy(state->buffer + state->bufferLength, cursor, fill);
+        SIConsumeStripe(state->accumulators, state->buffer);
+        cursor += fill;
+        state->bufferLength = 0;
+    }
+
+    while (end - cursor >= 32) {
+        SIConsumeStripe(state->accumulators, cursor);
+        cursor += 32;
+    }
+
+    memcpy(state->buffer, cursor, (size_t)(end - cursor));
+    state->bufferLength = (size_t)(end - cursor);
+}
+
+uint64_t SIContentHashEnd(const SIContentHashState *state) {
+    uint64_t hash = state->length >= 32 ? SIMergeAccumulators(state->accumulators) : state->seed + SIPrime5;
+
+    return SIFinish(hash + state->length, state->buffer, state->buffer + state->bufferLength);
+}
@@ -0,0 +1,50 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef SICONTENTHASH_H
+#define SICONTENTHASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// XXH64 of the bytes. Not cryptographic: it identifies identical content
+// quickly, and callers compare the bytes before trusting a match. The four
+// accumulators are independent, so the main loop keeps the multipliers busy
+// on every core the daemon runs on without needing vector intrinsics.
+uint64_t SIContentHash64(const void *bytes, size_t length, uint64_t seed);
+
+// The same hash fed a piece at a time, for content never held in one
+// buffer: the bytes given to SIContentHashUpdate between Begin and End hash
+// as SIContentHash64 hashes them together.
+typedef struct SIContentHashState {
+    uint64_t accumulators[4];
+    uint64_t seed;
+    uint64_t length;
+    unsigned char buffer[32];
+    size_t bufferLength;
+} SIContentHashState;
+
+void SIContentHashBegin(SIContentHashState *state, uint64_t seed);
+void SIContentHashUpdate(SIContentHashState *state, const void *bytes, size_t length);
+uint64_t SIContentHashEnd(const SIContentHashState *state);
+
+#endif
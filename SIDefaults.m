@@ -0,0 +1,62 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIDefaults.h"
+
+void SIRegisterDefaults(void) {
+    [[NSUserDefaults standardUserDefaults] registerDefaults:@{
+        @"CoalescingInterval"     : @0.25,
+        @"CoalescingMaximumDelay" : @1,
+        @"ArtworkLatencyBudget"   : @0.05,
+        @"ArtworkIconSize"        : @128,
+        @"ArtworkByteBudget"      : @32768,
+        @"TitleFormat"            : @"{name}",
+        @"BodyFormat"             : @"{artist}\n{album}",
+        @"StreamBodyFormat"       : @"{stream}",
+        @"DuplicateInterval"      : @10,
+        @"NotificationsPerMinute" : @20,
+        @"StreamTitleInterval"    : @5,
+        @"Sinks"                  : @[@"Growl"],
+        @"SinkQueueCapacity"      : @16,
+        @"SinkQueuePolicy"        : @"DropOldest",
+        @"SinkQueues"             : @{},
+        @"SocketPath"             : [NSTemporaryDirectory() stringByAppendingPathComponent:@"itunesnotify.sock"],
+        @"LogPath"                : @"~/Library/Logs/itunesnotify.log",
+        @"NowPlayingSnapshotPath" : [NSTemporaryDirectory() stringByAppendingPathComponent:@"itunesnotify.nowplaying"],
+        @"NowPlayingSocketPath"   : [NSTemporaryDirectory() stringByAppendingPathComponent:@"itunesnotify-nowplaying.sock"],
+        @"RecordEventsPath"       : @"",
+        @"ProfileStartup"         : @NO,
+        @"PrefetchTrackCount"     : @2,
+        @"PrefetchDelay"          : @1,
+        @"PrefetchByteLimit"      : @1048576,
+        @"Metrics"                : @NO,
+        @"MetricsTracePath"       : @"",
+        @"HistoryDirectory"       : @"~/Library/Application Support/itunesnotify/History",
+        @"HistorySyncBatchSize"   : @32,
+        @"HistorySyncInterval"    : @30,
+        @"HistoryRetentionDays"   : @365,
+        @"ScrobbleURL"            : @"",
+        @"ScrobbleBatchSize"      : @50,
+        @"ScrobbleInterval"       : @300,
+        @"MemoryBudget"           : @4194304
+    }];
+}
@@ -0,0 +1,77 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIDistributedNotificationSource.h"
+
+static NSString *const SIPlayerInfoNotificationName = @"com.apple.iTunes.playerInfo";
+
+@implementation SIDistributedNotificationSource
+
+- (void)dealloc {
+    [self stop];
+
+    [super dealloc];
+}
+
+- (void)setDelegate:(id<SIEventSourceDelegate>)aDelegate {
+    delegate = aDelegate;
+}
+
+- (void)start {
+    if (started) {
+        return;
+    }
+
+    [[NSDistributedNotificationCenter defaultCenter] addObserver:self
+                                                        selector:@selector(playerStateDidChange:)
+                                                            name:SIPlayerInfoNotificationName
+                                                          object:nil];
+    started = YES;
+}
+
+- (void)stop {
+    if (!started) {
+        return;
+    }
+
+    [[NSDistributedNotificationCenter defaultCenter] removeObserver:self];
+    started = NO;
+}
+
+- (void)playerStateDidChange:(NSNotification *)notification {
+    if (!notification) {
+      return;
+    }
+
+    if (![[notification name] isEqual:SIPlayerInfoNotificationName]) {
+      return;
+    }
+
+    NSDictionary *userInfo = [notification userInfo];
+    if (!userInfo) {
+        return;
+    }
+
+    [delegate eventSource:self didReceivePlayerInfo:userInfo];
+}
+
+@end
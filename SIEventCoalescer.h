@@ -0,0 +1,60 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIEventSource.h"
+
+// Collapses bursts of playerInfo events. Events are held for a quiet interval
+// that restarts with every new event; only the latest one is delivered when
+// it expires, or once the burst has been held for maximumDelay, so that a
+// burst that never goes quiet, such as skipping through a playlist, still
+// notifies. A held event replaced by one for the same track and player state
+// counts as merged, by one for a different track or state as dropped. A zero
+// interval delivers every event immediately; a zero maximumDelay waits for
+// quiet however long it takes.
+@interface SIEventCoalescer : NSObject <SIEventSource, SIEventSourceDelegate> {
+    id<SIEventSource> eventSource;
+    id<SIEventSourceDelegate> delegate;
+    NSTimeInterval quietInterval;
+    NSTimeInterval maximumDelay;
+    uint64_t burstStartedAt;
+    NSDictionary *pendingUserInfo;
+    NSString *pendingKey;
+    NSTimer *timer;
+    NSUInteger receivedCount;
+    NSUInteger deliveredCount;
+    NSUInteger mergedCount;
+    NSUInteger droppedCount;
+}
+
+@property (nonatomic, assign) NSTimeInterval quietInterval;
+@property (nonatomic, assign) NSTimeInterval maximumDelay;
+@property (nonatomic, readonly) NSUInteger receivedCount;
+@property (nonatomic, readonly) NSUInteger deliveredCount;
+@property (nonatomic, readonly) NSUInteger mergedCount;
+@property (nonatomic, readonly) NSUInteger droppedCount;
+
+- (id)initWithEventSource:(id<SIEventSource>)anEventSource quietInterval:(NSTimeInterval)aQuietInterval;
+
+// Delivers the held event, if any, without waiting for the interval.
+- (void)flush;
+
+@end
@@ -0,0 +1,169 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIEventCoalescer.h"
+#import "SIArtworkCache.h"
+#import "SIClock.h"
+#import "SIMetrics.h"
+
+static NSString *SIEventKeyForUserInfo(NSDictionary *userInfo) {
+    NSString *playerState = [userInfo objectForKey:@"Player State"];
+    NSString *persistentID = SIPersistentIDFromUserInfo(userInfo);
+
+    if (persistentID) {
+        return [NSString stringWithFormat:@"%@|%@", persistentID, playerState];
+    }
+
+    return [NSString stringWithFormat:@"%@|%@|%@|%@",
+        [userInfo objectForKey:@"Name"],
+        [userInfo objectForKey:@"Artist"],
+        [userInfo objectForKey:@"Album"],
+        playerState];
+}
+
+@implementation SIEventCoalescer
+
+@synthesize quietInterval;
+@synthesize maximumDelay;
+@synthesize receivedCount;
+@synthesize deliveredCount;
+@synthesize mergedCount;
+@synthesize droppedCount;
+
+- (id)initWithEventSource:(id<SIEventSource>)anEventSource quietInterval:(NSTimeInterval)aQuietInterval {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    eventSource = [anEventSource retain];
+    [eventSource setDelegate:self];
+    quietInterval = aQuietInterval;
+    maximumDelay = 1;
+
+    return self;
+}
+
+- (void)dealloc {
+    [eventSource setDelegate:nil];
+    [eventSource release];
+    [timer invalidate];
+    [timer release];
+    [pendingUserInfo release];
+    [pendingKey release];
+
+    [super dealloc];
+}
+
+- (void)setDelegate:(id<SIEventSourceDelegate>)aDelegate {
+    delegate = aDelegate;
+}
+
+- (void)start {
+    [eventSource start];
+}
+
+- (void)stop {
+    [eventSource stop];
+    [self flush];
+}
+
+- (void)flush {
+    [timer invalidate];
+    [timer release];
+    timer = nil;
+
+    if (!pendingUserInfo) {
+        return;
+    }
+
+    NSDictionary *userInfo = [pendingUserInfo autorelease];
+    pendingUserInfo = nil;
+    [pendingKey release];
+    pendingKey = nil;
+
+    deliveredCount++;
+    [delegate eventSource:self didReceivePlayerInfo:userInfo];
+}
+
+- (void)quietIntervalDidElapse:(NSTimer *)aTimer {
+    [self flush];
+}
+
+// The quiet interval, cut short where it would hold the burst past
+// maximumDelay.
+- (NSTimeInterval)delayUntilDelivery {
+    if (maximumDelay <= 0) {
+        return quietInterval;
+    }
+
+    NSTimeInterval remaining = maximumDelay - (SIMonotonicNanoseconds() - burstStartedAt) / 1e9;
+
+    return MAX(0, MIN(quietInterval, remaining));
+}
+
+// The receive stage ends where the pipeline's filter stage begins.
+- (void)eventSource:(id<SIEventSource>)anEventSource didReceivePlayerInfo:(NSDictionary *)userInfo {
+    uint64_t stageStart = SIMetricsBegin();
+    receivedCount++;
+    SIMetricsCount(SIMetricsCounterEvents);
+
+    if (quietInterval <= 0) {
+        deliveredCount++;
+        SIMetricsEnd(SIMetricsStageReceive, stageStart);
+        [delegate eventSource:self didReceivePlayerInfo:userInfo];
+        return;
+    }
+
+    NSString *key = SIEventKeyForUserInfo(userInfo);
+
+    if (pendingUserInfo) {
+        if ([key isEqual:pendingKey]) {
+            mergedCount++;
+        } else {
+            droppedCount++;
+            SIMetricsCount(SIMetricsCounterDrops);
+        }
+    }
+
+    [pendingUserInfo release];
+    pendingUserInfo = [userInfo retain];
+    [pendingKey release];
+    pendingKey = [key retain];
+
+    if (timer) {
+        [timer setFireDate:[NSDate dateWithTimeIntervalSinceNow:[self delayUntilDelivery]]];
+        SIMetricsEnd(SIMetricsStageReceive, stageStart);
+        return;
+    }
+
+    burstStartedAt = SIMonotonicNanoseconds();
+    timer = [[NSTimer scheduledTimerWithTimeInterval:[self delayUntilDelivery]
+                                              target:self
+                                            selector:@selector(quietIntervalDidElapse:)
+                                            userInfo:nil
+                                             repeats:NO] retain];
+    SIMetricsEnd(SIMetricsStageReceive, stageStart);
+}
+
+@end
@@ -0,0 +1,98 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <errno.h>
+#import "SIClock.h"
+#import "SIEventRecorder.h"
+#import "SIEventTrace.h"
+#import "SIUnixSocketServer.h"
+
+@implementation SIEventRecorder
+
+@synthesize recordedCount;
+
+- (id)init {
+    return [self initWithEventSource:nil path:nil error:NULL];
+}
+
+- (id)initWithEventSource:(id<SIEventSource>)anEventSource path:(NSString *)path error:(NSError **)error {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    file = path ? fopen([path fileSystemRepresentation], "w") : NULL;
+    if (!file) {
+        if (error) {
+            *error = SIPOSIXError(errno);
+        }
+
+        [self release];
+        return nil;
+    }
+
+    eventSource = [anEventSource retain];
+    [eventSource setDelegate:self];
+
+    return self;
+}
+
+- (void)dealloc {
+    [eventSource setDelegate:nil];
+    [eventSource release];
+
+    if (file) {
+        fclose(file);
+    }
+
+    [super dealloc];
+}
+
+- (void)setDelegate:(id<SIEventSourceDelegate>)aDelegate {
+    delegate = aDelegate;
+}
+
+- (void)start {
+    [eventSource start];
+}
+
+- (void)stop {
+    [eventSource stop];
+}
+
+- (void)eventSource:(id<SIEventSource>)anEventSource didReceivePlayerInfo:(NSDictionary *)userInfo {
+    uint64_t now = SIMonotonicNanoseconds();
+
+    if (!recordedCount) {
+        firstEventAt = now;
+    }
+
+    NSData *line = [SIEventTrace lineWithUserInfo:userInfo offset:(now - firstEventAt) / 1e9];
+    fwrite([line bytes], 1, [line length], file);
+    fflush(file);
+    recordedCount++;
+
+    [delegate eventSource:self didReceivePlayerInfo:userInfo];
+}
+
+@end
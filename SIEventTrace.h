@@ -0,0 +1,49 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// A recording of playerInfo events. Traces are stored as JSON lines, one
+// {"offset": seconds, "userInfo": {...}} object per event, offsets counted
+// from the first event.
+@interface SIEventTrace : NSObject {
+    NSMutableArray *offsets;
+    NSMutableArray *userInfos;
+}
+
++ (id)traceWithContentsOfFile:(NSString *)path error:(NSError **)error;
+
+// Encodes one event as a trace line, newline included. Values JSON cannot
+// hold are recorded as their descriptions.
++ (NSData *)lineWithUserInfo:(NSDictionary *)userInfo offset:(NSTimeInterval)offset;
+
+- (id)initWithContentsOfFile:(NSString *)path error:(NSError **)error;
+
+- (NSUInteger)count;
+- (NSTimeInterval)offsetAtIndex:(NSUInteger)anIndex;
+- (NSDictionary *)userInfoAtIndex:(NSUInteger)anIndex;
+- (NSTimeInterval)duration;
+
+// Offsets must not decrease.
+- (void)addUserInfo:(NSDictionary *)userInfo offset:(NSTimeInterval)offset;
+
+- (BOOL)writeToFile:(NSString *)path error:(NSError **)error;
+
+@end
@@ -0,0 +1,173 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIEventTrace.h"
+
+static id SIJSONValue(id value) {
+    if ([value isKindOfClass:[NSString class]] || [value isKindOfClass:[NSNumber class]]) {
+        return value;
+    }
+
+    if ([value isKindOfClass:[NSArray class]]) {
+        NSMutableArray *array = [NSMutableArray arrayWithCapacity:[value count]];
+
+        for (id element in value) {
+            [array addObject:SIJSONValue(element)];
+        }
+
+        return array;
+    }
+
+    if ([value isKindOfClass:[NSDictionary class]]) {
+        NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:[value count]];
+
+        for (id key in value) {
+            [dictionary setObject:SIJSONValue([value objectForKey:key]) forKey:[key description]];
+        }
+
+        return dictionary;
+    }
+
+    return [value description];
+}
+
+@implementation SIEventTrace
+
++ (id)traceWithContentsOfFile:(NSString *)path error:(NSError **)error {
+    return [[[self alloc] initWithContentsOfFile:path error:error] autorelease];
+}
+
++ (NSData *)lineWithUserInfo:(NSDictionary *)userInfo offset:(NSTimeInterval)offset {
+    NSDictionary *event = @{
+        @"offset"   : @(offset),
+        @"userInfo" : SIJSONValue(userInfo ? userInfo : @{})
+    };
+    NSMutableData *line = [NSMutableData dataWithData:[NSJSONSerialization dataWithJSONObject:event
+                                                                                      options:0
+                                                                                        error:NULL]];
+    [line appendBytes:"\n" length:1];
+
+    return line;
+}
+
+- (id)init {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    offsets = [[NSMutableArray alloc] init];
+    userInfos = [[NSMutableArray alloc] init];
+
+    return self;
+}
+
+- (id)initWithContentsOfFile:(NSString *)path error:(NSError **)error {
+    self = [self init];
+
+    if (!self) {
+        return nil;
+    }
+
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:error];
+    if (!data) {
+        [self release];
+        return nil;
+    }
+
+    const char *bytes = [data bytes];
+    NSUInteger length = [data length];
+    NSUInteger lineStart = 0;
+
+    while (lineStart < length) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        const char *newline = memchr(bytes + lineStart, '\n', length - lineStart);
+        NSUInteger lineEnd = newline ? (NSUInteger)(newline - bytes) : length;
+
+        if (lineEnd > lineStart) {
+            NSData *line = [data subdataWithRange:NSMakeRange(lineStart, lineEnd - lineStart)];
+            NSDictionary *event = [NSJSONSerialization JSONObjectWithData:line options:0 error:NULL];
+
+            if (![event isKindOfClass:[NSDictionary class]]) {
+                [pool drain];
+
+                if (error) {
+                    *error = [NSError errorWithDomain:NSCocoaErrorDomain
+                                                 code:NSFileReadCorruptFileError
+                                             userInfo:@{NSFilePathErrorKey : path}];
+                }
+
+                [self release];
+                return nil;
+            }
+
+            [self addUserInfo:[event objectForKey:@"userInfo"]
+                       offset:[[event objectForKey:@"offset"] doubleValue]];
+        }
+
+        lineStart = lineEnd + 1;
+        [pool drain];
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [offsets release];
+    [userInfos release];
+
+    [super dealloc];
+}
+
+- (NSUInteger)count {
+    return [userInfos count];
+}
+
+- (NSTimeInterval)offsetAtIndex:(NSUInteger)anIndex {
+    return [[offsets objectAtIndex:anIndex] doubleValue];
+}
+
+- (NSDictionary *)userInfoAtIndex:(NSUInteger)anIndex {
+    return [userInfos objectAtIndex:anIndex];
+}
+
+- (NSTimeInterval)duration {
+    return [offsets count] ? [[offsets lastObject] doubleValue] : 0;
+}
+
+- (void)addUserInfo:(NSDictionary *)userInfo offset:(NSTimeInterval)offset {
+    [offsets addObject:@(offset)];
+    [userInfos addObject:(userInfo ? userInfo : @{})];
+}
+
+- (BOOL)writeToFile:(NSString *)path error:(NSError **)error {
+    NSMutableData *data = [NSMutableData data];
+
+    for (NSUInteger i = 0; i < [userInfos count]; i++) {
+        [data appendData:[SIEventTrace lineWithUserInfo:[userInfos objectAtIndex:i] offset:[self offsetAtIndex:i]]];
+    }
+
+    return [data writeToFile:path options:NSDataWritingAtomic error:error];
+}
+
+@end
@@ -0,0 +1,53 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIArtworkNormalizer.h"
+#import "SIMetadataProvider.h"
+
+// The icon posted for tracks without artwork. It is rendered from the player
+// icon on first use, normalized to icon size and kept for the life of the
+// process. At most once per refreshInterval it checks the player icon
+// modification date and renders the icon again if it changed. Main thread
+// only.
+@interface SIFallbackIcon : NSObject {
+    id<SIMetadataProvider> metadataProvider;
+    SIArtworkNormalizer *normalizer;
+    NSData *iconData;
+    NSDate *iconModificationDate;
+    BOOL rendered;
+    uint64_t checkedAt;
+    NSTimeInterval refreshInterval;
+    NSUInteger renderCount;
+}
+
+@property (nonatomic, assign) NSTimeInterval refreshInterval;
+@property (nonatomic, readonly) NSUInteger renderCount;
+
+- (id)initWithMetadataProvider:(id<SIMetadataProvider>)aMetadataProvider
+                    normalizer:(SIArtworkNormalizer *)aNormalizer;
+
+- (NSData *)iconData;
+
+// Renders the icon again on next use.
+- (void)invalidate;
+
+@end
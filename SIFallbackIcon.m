@@ -0,0 +1,89 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIFallbackIcon.h"
+#import "SIClock.h"
+
+@implementation SIFallbackIcon
+
+@synthesize refreshInterval;
+@synthesize renderCount;
+
+- (id)initWithMetadataProvider:(id<SIMetadataProvider>)aMetadataProvider
+                    normalizer:(SIArtworkNormalizer *)aNormalizer {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    metadataProvider = [aMetadataProvider retain];
+    normalizer = [aNormalizer retain];
+    refreshInterval = 60;
+
+    return self;
+}
+
+- (void)dealloc {
+    [metadataProvider release];
+    [normalizer release];
+    [iconData release];
+    [iconModificationDate release];
+
+    [super dealloc];
+}
+
+- (void)invalidate {
+    rendered = NO;
+}
+
+- (NSData *)iconData {
+    uint64_t now = SIMonotonicNanoseconds();
+
+    if (rendered && now - checkedAt < (uint64_t)(refreshInterval * 1e9)) {
+        return iconData;
+    }
+
+    checkedAt = now;
+
+    NSDate *modificationDate = [metadataProvider playerIconModificationDate];
+    if (rendered && (modificationDate == iconModificationDate || [modificationDate isEqual:iconModificationDate])) {
+        return iconData;
+    }
+
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+    NSData *playerIconData = [metadataProvider playerIconData];
+    NSData *renderedIconData = normalizer ? [normalizer normalizedArtworkData:playerIconData] : playerIconData;
+
+    [iconData release];
+    iconData = [renderedIconData retain];
+    [iconModificationDate release];
+    iconModificationDate = [modificationDate retain];
+    rendered = YES;
+    renderCount++;
+
+    [pool drain];
+
+    return iconData;
+}
+
+@end
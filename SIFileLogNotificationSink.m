@@ -0,0 +1,85 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <errno.h>
+#import "SIFileLogNotificationSink.h"
+#import "SIUnixSocketServer.h"
+
+static NSString *SILogField(NSString *field) {
+    if (!field) {
+        return @"";
+    }
+
+    field = [field stringByReplacingOccurrencesOfString:@"\t" withString:@" "];
+
+    return [field stringByReplacingOccurrencesOfString:@"\n" withString:@" / "];
+}
+
+@implementation SIFileLogNotificationSink
+
+- (id)init {
+    return [self initWithPath:nil error:NULL];
+}
+
+- (id)initWithPath:(NSString *)path error:(NSError **)error {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    [[NSFileManager defaultManager] createDirectoryAtPath:[path stringByDeletingLastPathComponent]
+                              withIntermediateDirectories:YES
+                                               attributes:nil
+                                                    error:NULL];
+
+    file = path ? fopen([path fileSystemRepresentation], "a") : NULL;
+    if (!file) {
+        if (error) {
+            *error = SIPOSIXError(errno);
+        }
+
+        [self release];
+        return nil;
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    if (file) {
+        fclose(file);
+    }
+
+    [super dealloc];
+}
+
+- (void)postNotification:(SINotification *)notification {
+    fprintf(file, "%s\t%s\t%s\t%s\n",
+            [[[NSDate date] description] UTF8String],
+            [SILogField([[notification track] persistentID]) UTF8String],
+            [SILogField([notification title]) UTF8String],
+            [SILogField([notification body]) UTF8String]);
+    fflush(file);
+}
+
+@end
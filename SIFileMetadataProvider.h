@@ -0,0 +1,65 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <stdatomic.h>
+#import "SIMetadataProvider.h"
+#import "SITrackPropertiesCache.h"
+
+// Serves a library stored on disk in place of iTunes. A library is a
+// directory holding Tracks.plist, an array of playerInfo userInfo
+// dictionaries extended with artwork offsets and optionally a Modification
+// Date, served as the track property iTunes has, and Artwork.bin, the
+// concatenated artwork blobs, which is memory-mapped. An optional Icon.png
+// serves as the player icon and is read anew on every request, like the
+// iTunes icon is rendered anew.
+//
+// Requests are counted as the iTunes provider would send Apple Events for
+// them, properties cache included, so that round trips can be checked
+// without iTunes.
+@interface SIFileMetadataProvider : NSObject <SIMetadataProvider> {
+    NSString *directory;
+    NSArray *tracks;
+    NSDictionary *trackIndexes;
+    NSData *artwork;
+    SITrackPropertiesCache *propertiesCache;
+    _Atomic(unsigned long long) appleEventCount;
+}
+
+@property (nonatomic, readonly) SITrackPropertiesCache *propertiesCache;
+
+// Writes a library of trackCount tracks grouped into albums of
+// albumTrackCount tracks that share one artworkLength byte blob.
++ (BOOL)writeSyntheticLibraryToDirectory:(NSString *)aDirectory
+                              trackCount:(NSUInteger)trackCount
+                         albumTrackCount:(NSUInteger)albumTrackCount
+                           artworkLength:(NSUInteger)artworkLength
+                                   error:(NSError **)error;
+
+- (id)initWithDirectory:(NSString *)aDirectory error:(NSError **)error;
+
+- (NSUInteger)trackCount;
+
+// Returns the playerInfo userInfo dictionary of a track, as iTunes would
+// post it while the track is playing.
+- (NSDictionary *)userInfoForTrackAtIndex:(NSUInteger)anIndex;
+
+@end
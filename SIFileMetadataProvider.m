@@ -0,0 +1,297 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIFileMetadataProvider.h"
+#import "SIArtworkCache.h"
+#import "SIMetrics.h"
+
+static NSString *const SIFileLibraryTracksFileName = @"Tracks.plist";
+static NSString *const SIFileLibraryArtworkFileName = @"Artwork.bin";
+static NSString *const SIFileLibraryIconFileName = @"Icon.png";
+static NSString *const SIFileLibraryArtworkOffsetKey = @"Artwork Offset";
+static NSString *const SIFileLibraryArtworkLengthKey = @"Artwork Length";
+static NSString *const SIFileLibraryModificationDateKey = @"Modification Date";
+
+@implementation SIFileMetadataProvider
+
+@synthesize propertiesCache;
+
++ (BOOL)writeSyntheticLibraryToDirectory:(NSString *)aDirectory
+                              trackCount:(NSUInteger)trackCount
+                         albumTrackCount:(NSUInteger)albumTrackCount
+                           artworkLength:(NSUInteger)artworkLength
+                                   error:(NSError **)error {
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+
+    if (![fileManager createDirectoryAtPath:aDirectory withIntermediateDirectories:YES attributes:nil error:error]) {
+        return NO;
+    }
+
+    NSString *artworkPath = [aDirectory stringByAppendingPathComponent:SIFileLibraryArtworkFileName];
+    [fileManager createFileAtPath:artworkPath contents:nil attributes:nil];
+    NSFileHandle *artworkHandle = [NSFileHandle fileHandleForWritingAtPath:artworkPath];
+
+    if (!artworkHandle) {
+        return NO;
+    }
+
+    if (!albumTrackCount) {
+        albumTrackCount = 1;
+    }
+
+    NSMutableArray *records = [NSMutableArray arrayWithCapacity:trackCount];
+    NSMutableData *blob = [NSMutableData dataWithLength:artworkLength];
+    unsigned long long offset = 0;
+
+    for (NSUInteger i = 0; i < trackCount; i++) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        NSUInteger albumIndex = i / albumTrackCount;
+
+        if (i % albumTrackCount == 0 && artworkLength) {
+            uint64_t state = 0x9e3779b97f4a7c15ULL ^ albumIndex;
+            unsigned char *bytes = [blob mutableBytes];
+
+            for (NSUInteger j = 0; j < artworkLength; j++) {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                bytes[j] = (unsigned char)state;
+            }
+
+            [artworkHandle writeData:blob];
+            offset += artworkLength;
+        }
+
+        NSDictionary *record = @{
+            @"PersistentID"               : @((long long)(0x5100000000000000ULL | i)),
+            @"Name"                       : [NSString stringWithFormat:@"Track %lu", (unsigned long)i],
+            @"Artist"                     : [NSString stringWithFormat:@"Artist %lu", (unsigned long)(albumIndex / 4)],
+            @"Album"                      : [NSString stringWithFormat:@"Album %lu", (unsigned long)albumIndex],
+            @"Player State"               : @"Playing",
+            SIFileLibraryArtworkOffsetKey : @(artworkLength ? offset - artworkLength : 0),
+            SIFileLibraryArtworkLengthKey : @(artworkLength)
+        };
+        [records addObject:record];
+
+        [pool drain];
+    }
+
+    [artworkHandle closeFile];
+
+    NSData *tracksData = [NSPropertyListSerialization dataWithPropertyList:records
+                                                                    format:NSPropertyListBinaryFormat_v1_0
+                                                                   options:0
+                                                                     error:error];
+    if (!tracksData) {
+        return NO;
+    }
+
+    return [tracksData writeToFile:[aDirectory stringByAppendingPathComponent:SIFileLibraryTracksFileName]
+                           options:NSDataWritingAtomic
+                             error:error];
+}
+
+- (id)init {
+    return [self initWithDirectory:nil error:NULL];
+}
+
+- (id)initWithDirectory:(NSString *)aDirectory error:(NSError **)error {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    directory = [aDirectory copy];
+
+    NSData *tracksData = [NSData dataWithContentsOfFile:[directory stringByAppendingPathComponent:SIFileLibraryTracksFileName]
+                                                options:0
+                                                  error:error];
+    if (tracksData) {
+        tracks = [[NSPropertyListSerialization propertyListWithData:tracksData
+                                                            options:NSPropertyListImmutable
+                                                             format:NULL
+                                                              error:error] retain];
+    }
+
+    if (![tracks isKindOfClass:[NSArray class]]) {
+        [self release];
+        return nil;
+    }
+
+    artwork = [[NSData alloc] initWithContentsOfFile:[directory stringByAppendingPathComponent:SIFileLibraryArtworkFileName]
+                                             options:NSDataReadingMappedIfSafe
+                                               error:NULL];
+
+    NSMutableDictionary *indexes = [NSMutableDictionary dictionaryWithCapacity:[tracks count]];
+    NSUInteger trackCount = [tracks count];
+
+    for (NSUInteger i = 0; i < trackCount; i++) {
+        NSString *persistentID = SIPersistentIDFromUserInfo([tracks objectAtIndex:i]);
+
+        if (persistentID) {
+            [indexes setObject:@(i) forKey:persistentID];
+        }
+    }
+    trackIndexes = [indexes copy];
+    propertiesCache = [[SITrackPropertiesCache alloc] init];
+
+    return self;
+}
+
+- (void)dealloc {
+    [directory release];
+    [tracks release];
+    [trackIndexes release];
+    [artwork release];
+    [propertiesCache release];
+
+    [super dealloc];
+}
+
+- (NSUInteger)trackCount {
+    return [tracks count];
+}
+
+- (NSDictionary *)userInfoForTrackAtIndex:(NSUInteger)anIndex {
+    return [tracks objectAtIndex:anIndex % [tracks count]];
+}
+
+- (BOOL)isPlayerRunning {
+    return YES;
+}
+
+- (NSData *)playerIconData {
+    return [NSData dataWithContentsOfFile:[directory stringByAppendingPathComponent:SIFileLibraryIconFileName]];
+}
+
+- (NSDate *)playerIconModificationDate {
+    NSString *iconPath = [directory stringByAppendingPathComponent:SIFileLibraryIconFileName];
+
+    return [[[NSFileManager defaultManager] attributesOfItemAtPath:iconPath error:NULL] fileModificationDate];
+}
+
+- (unsigned long long)appleEventCount {
+    return atomic_load(&appleEventCount);
+}
+
+// Stands in for a properties request.
+- (NSDictionary *)fetchPropertiesOfTrackAtIndex:(NSUInteger)trackIndex {
+    uint64_t stageStart = SIMetricsBegin();
+    NSDictionary *record = [self userInfoForTrackAtIndex:trackIndex];
+    NSMutableDictionary *properties = [NSMutableDictionary dictionaryWithDictionary:@{
+        @"databaseID"   : @(trackIndex),
+        @"persistentID" : SIPersistentIDFromUserInfo(record),
+        @"index"        : @(trackIndex + 1)
+    }];
+    if ([record objectForKey:SIFileLibraryModificationDateKey]) {
+        [properties setObject:[record objectForKey:SIFileLibraryModificationDateKey] forKey:@"modificationDate"];
+    }
+    SIMetricsEnd(SIMetricsStageMetadata, stageStart);
+
+    atomic_fetch_add(&appleEventCount, 1);
+    [propertiesCache storeProperties:properties];
+
+    return properties;
+}
+
+// Plays the library in order. Properties already cached are not requested
+// again, as the iTunes provider reuses those of the positions it resolved
+// last time.
+- (NSArray *)persistentIDsOfTracksFollowingPersistentID:(NSString *)persistentID count:(NSUInteger)count {
+    NSNumber *trackIndex = [trackIndexes objectForKey:persistentID];
+    NSMutableArray *persistentIDs = [NSMutableArray arrayWithCapacity:count];
+
+    if (!trackIndex) {
+        return persistentIDs;
+    }
+
+    // The current track's properties, the shuffle setting and the track
+    // count, then the properties of each upcoming track.
+    if (![propertiesCache propertiesForPersistentID:persistentID]) {
+        [self fetchPropertiesOfTrackAtIndex:[trackIndex unsignedIntegerValue]];
+    }
+    atomic_fetch_add(&appleEventCount, 2);
+
+    for (NSUInteger i = 1; i <= count && i < [tracks count]; i++) {
+        NSUInteger upcomingIndex = ([trackIndex unsignedIntegerValue] + i) % [tracks count];
+        NSString *upcomingPersistentID = SIPersistentIDFromUserInfo([self userInfoForTrackAtIndex:upcomingIndex]);
+
+        if (![propertiesCache propertiesForPersistentID:upcomingPersistentID]) {
+            [self fetchPropertiesOfTrackAtIndex:upcomingIndex];
+        }
+
+        [persistentIDs addObject:upcomingPersistentID];
+    }
+
+    [propertiesCache retainPropertiesForPersistentIDs:[persistentIDs arrayByAddingObject:persistentID]];
+
+    return persistentIDs;
+}
+
+- (NSDate *)modificationDateOfTrackWithPersistentID:(NSString *)persistentID {
+    return [propertiesCache property:@"modificationDate" forPersistentID:persistentID];
+}
+
+- (NSTimeInterval)remainingTimeOfCurrentTrack {
+    return -1;
+}
+
+- (BOOL)getArtworkData:(NSData **)data
+      modificationDate:(NSDate **)modificationDate
+       appleEventCount:(unsigned long long *)appleEventCount
+       forPersistentID:(NSString *)persistentID {
+    NSNumber *trackIndex = [trackIndexes objectForKey:persistentID];
+    unsigned long long appleEventsSent = 1;
+
+    if (!trackIndex) {
+        return NO;
+    }
+
+    NSDictionary *properties = [propertiesCache propertiesForPersistentID:persistentID];
+    if (!properties) {
+        properties = [self fetchPropertiesOfTrackAtIndex:[trackIndex unsignedIntegerValue]];
+        appleEventsSent++;
+    }
+
+    if (appleEventCount) {
+        *appleEventCount = appleEventsSent;
+    }
+
+    if (modificationDate) {
+        *modificationDate = [properties objectForKey:@"modificationDate"];
+    }
+
+    atomic_fetch_add(&appleEventCount, 1);
+
+    NSDictionary *record = [tracks objectAtIndex:[trackIndex unsignedIntegerValue]];
+    unsigned long long offset = [[record objectForKey:SIFileLibraryArtworkOffsetKey] unsignedLongLongValue];
+    unsigned long long length = [[record objectForKey:SIFileLibraryArtworkLengthKey] unsignedLongLongValue];
+
+    *data = length && offset + length <= [artwork length]
+        ? [artwork subdataWithRange:NSMakeRange((NSUInteger)offset, (NSUInteger)length)]
+        : nil;
+
+    return YES;
+}
+
+@end
@@ -0,0 +1,76 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIFrameworkLoader.h"
+
+static NSMutableDictionary *SILoadedFrameworks = nil;
+
+static NSArray *SIFrameworkDirectories(void) {
+    NSMutableArray *directories = [NSMutableArray arrayWithCapacity:4];
+    NSString *privateFrameworksPath = [[NSBundle mainBundle] privateFrameworksPath];
+
+    if (privateFrameworksPath) {
+        [directories addObject:privateFrameworksPath];
+    }
+
+    [directories addObject:[@"~/Library/Frameworks" stringByExpandingTildeInPath]];
+    [directories addObject:@"/Library/Frameworks"];
+    [directories addObject:@"/System/Library/Frameworks"];
+
+    return directories;
+}
+
+BOOL SILoadFramework(NSString *name) {
+    @synchronized ([NSBundle class]) {
+        if (!SILoadedFrameworks) {
+            SILoadedFrameworks = [[NSMutableDictionary alloc] init];
+        }
+
+        NSNumber *loaded = [SILoadedFrameworks objectForKey:name];
+        if (loaded) {
+            return [loaded boolValue];
+        }
+
+        NSString *frameworkName = [name stringByAppendingPathExtension:@"framework"];
+        NSError *error = nil;
+        BOOL found = NO;
+
+        for (NSString *directory in SIFrameworkDirectories()) {
+            NSBundle *bundle = [NSBundle bundleWithPath:[directory stringByAppendingPathComponent:frameworkName]];
+
+            if (bundle) {
+                found = YES;
+                loaded = @([bundle loadAndReturnError:&error]);
+                break;
+            }
+        }
+
+        if (![loaded boolValue]) {
+            NSLog(@"Cannot load %@: %@", frameworkName, found ? (id)error : @"not found");
+            loaded = @NO;
+        }
+
+        [SILoadedFrameworks setObject:loaded forKey:name];
+
+        return [loaded boolValue];
+    }
+}
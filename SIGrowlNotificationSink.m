@@ -0,0 +1,89 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIGrowlNotificationSink.h"
+#import "SIFrameworkLoader.h"
+
+@implementation SIGrowlNotificationSink
+
+- (id)initWithFallbackIcon:(SIFallbackIcon *)aFallbackIcon {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    fallbackIcon = [aFallbackIcon retain];
+
+    NSArray *notifications = @[@"Playing"];
+    registrationDictionary = [@{
+        GROWL_TICKET_VERSION        : @1,
+        GROWL_APP_ID                : @"itunesnotify",
+        GROWL_NOTIFICATIONS_ALL     : notifications,
+        GROWL_NOTIFICATIONS_DEFAULT : notifications
+    } retain];
+
+    return self;
+}
+
+- (void)dealloc {
+    [fallbackIcon release];
+    [registrationDictionary release];
+
+    [super dealloc];
+}
+
+- (NSDictionary *)registrationDictionaryForGrowl {
+    return registrationDictionary;
+}
+
+- (NSData *)applicationIconDataForGrowl {
+    return [fallbackIcon iconData];
+}
+
+- (Class)growlApplicationBridge {
+    if (!growlApplicationBridge && SILoadFramework(@"Growl")) {
+        growlApplicationBridge = NSClassFromString(@"GrowlApplicationBridge");
+        [growlApplicationBridge setGrowlDelegate:self];
+    }
+
+    return growlApplicationBridge;
+}
+
+// Sink queues post from their own threads; Growl expects the main thread.
+- (void)postNotification:(SINotification *)notification {
+    if (![NSThread isMainThread]) {
+        [self performSelectorOnMainThread:_cmd withObject:notification waitUntilDone:NO];
+        return;
+    }
+
+    [[self growlApplicationBridge] notifyWithTitle:[notification title]
+                                       description:[notification body]
+                                  notificationName:@"Playing"
+                                          iconData:[notification iconData]
+                                          priority:0
+                                          isSticky:NO
+                                      clickContext:nil
+                                        identifier:[notification identifier]];
+}
+
+@end
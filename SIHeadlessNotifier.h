@@ -0,0 +1,38 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIFileMetadataProvider.h"
+#import "SINowPlayingService.h"
+#import "SIRecordingNotificationSink.h"
+
+// Runs the pipeline without iTunes or Growl: metadata comes from a file-backed
+// library and notifications go to a recording sink. Configured through the
+// Library, SyntheticTrackCount and LogNotifications user defaults, plus the
+// settings shared with the iTunes notifier.
+@interface SIHeadlessNotifier : NSObject {
+    SINowPlayingService *service;
+    SIRecordingNotificationSink *recordingSink;
+}
+
+@property (nonatomic, readonly) SINowPlayingService *service;
+
+@end
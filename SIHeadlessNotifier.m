@@ -0,0 +1,83 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIHeadlessNotifier.h"
+#import "SIDistributedNotificationSource.h"
+
+@implementation SIHeadlessNotifier
+
+@synthesize service;
+
+- (id)init {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+    [userDefaults registerDefaults:@{
+        @"Library"             : [NSTemporaryDirectory() stringByAppendingPathComponent:@"itunesnotify-library"],
+        @"SyntheticTrackCount" : @100000,
+        @"LogNotifications"    : @YES
+    }];
+
+    NSString *library = [userDefaults stringForKey:@"Library"];
+    NSError *error = nil;
+
+    if (![[NSFileManager defaultManager] fileExistsAtPath:library]) {
+        [SIFileMetadataProvider writeSyntheticLibraryToDirectory:library
+                                                      trackCount:[userDefaults integerForKey:@"SyntheticTrackCount"]
+                                                 albumTrackCount:12
+                                                   artworkLength:256 * 1024
+                                                           error:&error];
+    }
+
+    SIFileMetadataProvider *metadataProvider = [[[SIFileMetadataProvider alloc] initWithDirectory:library error:&error] autorelease];
+    if (!metadataProvider) {
+        NSLog(@"Cannot load library %@: %@", library, error);
+        [self release];
+        return nil;
+    }
+
+    SIDistributedNotificationSource *eventSource = [[[SIDistributedNotificationSource alloc] init] autorelease];
+    service = [[SINowPlayingService alloc] initWithMetadataProvider:metadataProvider
+                                                        eventSource:eventSource
+                                                   artworkDirectory:nil];
+
+    recordingSink = [[SIRecordingNotificationSink alloc] initWithCapacity:0];
+    [recordingSink setLogsNotifications:[userDefaults boolForKey:@"LogNotifications"]];
+    [service addSink:recordingSink name:@"Recording"];
+    [service start];
+
+    return self;
+}
+
+- (void)dealloc {
+    [service stop];
+    [service release];
+    [recordingSink release];
+
+    [super dealloc];
+}
+
+@end
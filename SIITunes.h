@@ -195,6 +195,7 @@ typedef enum SIITunesERtK SIITunesERtK;
 @property (readonly) NSInteger index;  // The index of the item in internal application order.
 @property (copy) NSString *name;  // the name of the item
 @property (copy, readonly) NSString *persistentID;  // the id of the item as a hexadecimal string. This id does not change over time.
+@property (copy) NSDictionary *properties;  // every property of the item
 
 - (void) printPrintDialog:(BOOL)printDialog withProperties:(SIITunesPrintSettings *)withProperties kind:(SIITunesEKnd)kind theme:(NSString *)theme;  // Print the specified object(s)
 - (void) close;  // Close an object
@@ -0,0 +1,47 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <stdatomic.h>
+#import "SIMetadataProvider.h"
+#import "SIITunes.h"
+#import "SITrackPropertiesCache.h"
+
+// Answers metadata questions about the current iTunes track through the
+// Scripting Bridge, which is loaded the first time it is needed. Only
+// consulted on artwork cache misses and to prefetch the artwork of the
+// tracks that follow the current one in its playlist.
+//
+// Track properties are fetched all at once with one properties request and
+// kept while the track is current or next, and all artwork of a track comes
+// in one request, so an artwork miss costs at most two Apple Events.
+@interface SIITunesMetadataProvider : NSObject <SIMetadataProvider> {
+    SIITunesApplication *iTunes;
+    NSString *iTunesPath;
+    NSDictionary *upcomingTracks;
+    NSDictionary *upcomingPositions;
+    SITrackPropertiesCache *propertiesCache;
+    _Atomic(unsigned long long) appleEventCount;
+}
+
+@property (nonatomic, readonly) SITrackPropertiesCache *propertiesCache;
+
+@end
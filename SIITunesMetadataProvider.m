@@ -0,0 +1,284 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <ApplicationServices/ApplicationServices.h>
+#import "SIITunesMetadataProvider.h"
+#import "SIFrameworkLoader.h"
+#import "SIMetrics.h"
+
+static NSString *const SIITunesBundleIdentifier = @"com.apple.iTunes";
+
+@implementation SIITunesMetadataProvider
+
+@synthesize propertiesCache;
+
+- (id)init {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    propertiesCache = [[SITrackPropertiesCache alloc] init];
+
+    return self;
+}
+
+- (void)dealloc {
+    [iTunes release];
+    [iTunesPath release];
+    [upcomingTracks release];
+    [upcomingPositions release];
+    [propertiesCache release];
+
+    [super dealloc];
+}
+
+// Loads the Scripting Bridge on first use; asked from the main thread and the
+// artwork queue.
+- (SIITunesApplication *)iTunes {
+    @synchronized (self) {
+        if (!iTunes && SILoadFramework(@"ScriptingBridge")) {
+            iTunes = [[NSClassFromString(@"SBApplication") alloc] initWithBundleIdentifier:SIITunesBundleIdentifier];
+        }
+
+        return iTunes;
+    }
+}
+
+- (BOOL)isPlayerRunning {
+    return [[self iTunes] isRunning];
+}
+
+- (NSString *)iTunesPath {
+    @synchronized (self) {
+        if (!iTunesPath || ![[NSFileManager defaultManager] fileExistsAtPath:iTunesPath]) {
+            CFURLRef url = NULL;
+
+            [iTunesPath release];
+            iTunesPath = nil;
+
+            if (LSFindApplicationForInfo(kLSUnknownCreator, (CFStringRef)SIITunesBundleIdentifier, NULL, NULL, &url) == noErr) {
+                iTunesPath = [[(NSURL *)url path] copy];
+                CFRelease(url);
+            }
+        }
+
+        return [[iTunesPath retain] autorelease];
+    }
+}
+
+- (NSString *)infoPath {
+    return [[[self iTunesPath] stringByAppendingPathComponent:@"Contents"] stringByAppendingPathComponent:@"Info.plist"];
+}
+
+// The icon file itself rather than an NSImage rendering of it, which would
+// need AppKit; the artwork normalizer decodes it.
+- (NSData *)playerIconData {
+    NSString *iconFile = [[NSDictionary dictionaryWithContentsOfFile:[self infoPath]] objectForKey:@"CFBundleIconFile"];
+
+    if (!iconFile) {
+        return nil;
+    }
+
+    if (![[iconFile pathExtension] length]) {
+        iconFile = [iconFile stringByAppendingPathExtension:@"icns"];
+    }
+
+    NSString *resourcesPath = [[[self iTunesPath] stringByAppendingPathComponent:@"Contents"] stringByAppendingPathComponent:@"Resources"];
+
+    return [NSData dataWithContentsOfFile:[resourcesPath stringByAppendingPathComponent:iconFile]];
+}
+
+- (NSDate *)playerIconModificationDate {
+    return [[[NSFileManager defaultManager] attributesOfItemAtPath:[self infoPath] error:NULL] fileModificationDate];
+}
+
+- (unsigned long long)appleEventCount {
+    return atomic_load(&appleEventCount);
+}
+
+- (void)countAppleEvents:(unsigned long long)count {
+    atomic_fetch_add(&appleEventCount, count);
+}
+
+// One Apple Event for every property of the track.
+- (NSDictionary *)fetchPropertiesOfTrack:(SIITunesTrack *)track {
+    uint64_t stageStart = SIMetricsBegin();
+    NSDictionary *properties = [track properties];
+    SIMetricsEnd(SIMetricsStageMetadata, stageStart);
+
+    [self countAppleEvents:1];
+    [propertiesCache storeProperties:properties];
+
+    return properties;
+}
+
+- (NSDictionary *)propertiesOfTrack:(SIITunesTrack *)track persistentID:(NSString *)persistentID {
+    NSDictionary *properties = [propertiesCache propertiesForPersistentID:persistentID];
+
+    return properties ? properties : [self fetchPropertiesOfTrack:track];
+}
+
+// The current track and the tracks after it go through the properties
+// cache. A playlist position is only known by its track's persistent ID once
+// a properties request has named it, so the positions the last lookup
+// resolved are remembered, and a track that moves up a place as the next one
+// starts costs no request. They go stale only if the playlist is reordered
+// between two tracks; the artwork request then reaches another track than the
+// one remembered, which the check that follows it refuses.
+- (NSArray *)persistentIDsOfTracksFollowingPersistentID:(NSString *)persistentID count:(NSUInteger)count {
+    SIITunesApplication *application = [self iTunes];
+    SIITunesPlaylist *playlist = [application currentPlaylist];
+    NSDictionary *currentProperties = [self propertiesOfTrack:[application currentTrack] persistentID:persistentID];
+    NSMutableArray *persistentIDs = [NSMutableArray arrayWithCapacity:count];
+    NSMutableDictionary *tracks = [NSMutableDictionary dictionaryWithCapacity:count];
+    NSMutableDictionary *positions = [NSMutableDictionary dictionaryWithCapacity:count];
+
+    // Cached properties stand for the current track without asking; if
+    // another has started since, its own prefetch supersedes this one.
+    if (![[currentProperties objectForKey:@"persistentID"] isEqualToString:persistentID]) {
+        return persistentIDs;
+    }
+
+    BOOL shuffle = [playlist shuffle];
+    [self countAppleEvents:1];
+
+    if (shuffle) {
+        [propertiesCache retainPropertiesForPersistentIDs:@[persistentID]];
+        return persistentIDs;
+    }
+
+    // Track indexes count from one; the element array counts from zero.
+    SBElementArray *playlistTracks = [playlist tracks];
+    NSUInteger nextIndex = [[currentProperties objectForKey:@"index"] unsignedIntegerValue];
+    NSUInteger trackCount = [playlistTracks count];
+
+    [self countAppleEvents:1];
+    for (NSUInteger i = nextIndex; i < nextIndex + count && i < trackCount; i++) {
+        SIITunesTrack *track = [playlistTracks objectAtIndex:i];
+        NSNumber *position = [NSNumber numberWithUnsignedInteger:i];
+        NSString *knownPersistentID = nil;
+
+        @synchronized (self) {
+            knownPersistentID = [[[upcomingPositions objectForKey:position] retain] autorelease];
+        }
+
+        NSDictionary *properties = knownPersistentID
+            ? [self propertiesOfTrack:track persistentID:knownPersistentID]
+            : [self fetchPropertiesOfTrack:track];
+        NSString *trackPersistentID = [properties objectForKey:@"persistentID"];
+
+        if (trackPersistentID) {
+            [persistentIDs addObject:trackPersistentID];
+            [tracks setObject:track forKey:trackPersistentID];
+            [positions setObject:trackPersistentID forKey:position];
+        }
+    }
+
+    [propertiesCache retainPropertiesForPersistentIDs:[persistentIDs arrayByAddingObject:persistentID]];
+
+    @synchronized (self) {
+        [upcomingTracks release];
+        upcomingTracks = [tracks copy];
+        [upcomingPositions release];
+        upcomingPositions = [positions copy];
+    }
+
+    return persistentIDs;
+}
+
+// Known once the track's properties have been fetched, as they are for the
+// tracks prefetched and any track whose artwork was.
+- (NSDate *)modificationDateOfTrackWithPersistentID:(NSString *)persistentID {
+    return [propertiesCache property:@"modificationDate" forPersistentID:persistentID];
+}
+
+- (NSTimeInterval)remainingTimeOfCurrentTrack {
+    SIITunesApplication *application = [self iTunes];
+
+    if (![application isRunning]) {
+        return 0;
+    }
+
+    NSDictionary *applicationProperties = [application properties];
+    [self countAppleEvents:1];
+
+    if ([[applicationProperties objectForKey:@"playerState"] unsignedIntValue] != SIITunesEPlSPlaying) {
+        return 0;
+    }
+
+    NSDictionary *trackProperties = [self fetchPropertiesOfTrack:[application currentTrack]];
+    NSTimeInterval remaining = [[trackProperties objectForKey:@"duration"] doubleValue]
+                             - [[applicationProperties objectForKey:@"playerPosition"] doubleValue];
+
+    return remaining > 0 ? remaining : 0;
+}
+
+// Prefetched tracks are reached through the references the last prefetch
+// resolved; anything else is the current track. Neither reference names a
+// track for good: the current track is whatever is playing when it is sent,
+// and a playlist position whatever sits there. So a properties request sent
+// after the artwork request checks the reference still named the track asked
+// for; a skip or a reordering in between refuses the artwork rather than
+// cache it under the wrong track.
+- (BOOL)getArtworkData:(NSData **)data
+      modificationDate:(NSDate **)modificationDate
+       appleEventCount:(unsigned long long *)appleEventCount
+       forPersistentID:(NSString *)persistentID {
+    SIITunesTrack *track = nil;
+
+    @synchronized (self) {
+        track = [[[upcomingTracks objectForKey:persistentID] retain] autorelease];
+    }
+
+    if (!track) {
+        track = [[self iTunes] currentTrack];
+    }
+
+    // The raw data of every artwork in one Apple Event.
+    NSArray *artworks = [[track artworks] arrayByApplyingSelector:@selector(rawData)];
+    [self countAppleEvents:1];
+
+    NSDictionary *properties = [self fetchPropertiesOfTrack:track];
+
+    // The artwork request and the properties request.
+    if (appleEventCount) {
+        *appleEventCount = 2;
+    }
+
+    if (![[properties objectForKey:@"persistentID"] isEqualToString:persistentID]) {
+        return NO;
+    }
+
+    id artwork = [artworks lastObject];
+
+    *data = [artwork isKindOfClass:[NSData class]] ? artwork : nil;
+
+    if (modificationDate) {
+        *modificationDate = [properties objectForKey:@"modificationDate"];
+    }
+
+    return YES;
+}
+
+@end
@@ -20,11 +20,14 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
-#import <Cocoa/Cocoa.h>
-#import <Growl/Growl.h>
-#import "SIITunes.h"
+#import "SIGrowlNotificationSink.h"
+#import "SINowPlayingService.h"
 
-@interface SIITunesNotifier : NSObject <NSApplicationDelegate, GrowlApplicationBridgeDelegate> {
+@interface SIITunesNotifier : NSObject {
+    SINowPlayingService *service;
+    SIGrowlNotificationSink *growlSink;
 }
 
+@property (nonatomic, readonly) SINowPlayingService *service;
+
 @end
@@ -20,11 +20,15 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
-#import <ScriptingBridge/ScriptingBridge.h>
 #import "SIITunesNotifier.h"
+#import "SIDistributedNotificationSource.h"
+#import "SIITunesMetadataProvider.h"
+#import "SIUserNotificationSink.h"
 
 @implementation SIITunesNotifier
 
+@synthesize service;
+
 - (id)init {
     self = [super init];
 
@@ -32,126 +36,32 @@
         return nil;
     }
 
-    [[NSDistributedNotificationCenter defaultCenter] addObserver:self
-                                                        selector:@selector(playerStateDidChange:)
-                                                            name:@"com.apple.iTunes.playerInfo"
-                                                          object:nil];
-
-    return self;
-}
-
-- (void)dealloc {
-    [[NSDistributedNotificationCenter defaultCenter] removeObserver:self];
+    SIITunesMetadataProvider *metadataProvider = [[[SIITunesMetadataProvider alloc] init] autorelease];
+    SIDistributedNotificationSource *eventSource = [[[SIDistributedNotificationSource alloc] init] autorelease];
 
-    [super dealloc];
-}
-
-- (void)applicationDidFinishLaunching:(id)sender {
-    if ([self applicationIsRunning]) {
-        [NSApp terminate:self];
+    service = [[SINowPlayingService alloc] initWithMetadataProvider:metadataProvider
+                                                        eventSource:eventSource
+                                                   artworkDirectory:[SIArtworkCache defaultDirectory]];
+    growlSink = [[SIGrowlNotificationSink alloc] initWithFallbackIcon:[service fallbackIcon]];
+    if ([service isSinkEnabled:@"Growl"]) {
+        [service addSink:growlSink name:@"Growl"];
     }
 
-    [GrowlApplicationBridge setGrowlDelegate:self];
-}
-
-- (BOOL)applicationIsRunning {
-    NSString *processName = [[NSProcessInfo processInfo] processName];
-    NSPredicate *duplicatesPredicate = [NSPredicate predicateWithFormat:@"localizedName==%@", processName];
-    NSWorkspace *sharedWorkspace = [NSWorkspace sharedWorkspace];
-    NSArray *runningApplications = [sharedWorkspace runningApplications];
-    NSArray *duplicateApplications = [runningApplications filteredArrayUsingPredicate:duplicatesPredicate];
-
-    if ([duplicateApplications count] > 1) {
-        return YES;
+    if ([service isSinkEnabled:@"NotificationCenter"]) {
+        [service addSink:[[[SIUserNotificationSink alloc] init] autorelease] name:@"NotificationCenter"];
     }
 
-    return NO;
-}
-
-- (NSDictionary *)registrationDictionaryForGrowl {
-    NSArray *notifications = @[@"Playing"];
-
-    return @{
-        GROWL_TICKET_VERSION        : @1,
-        GROWL_APP_ID                : @"itunesnotify",
-        GROWL_NOTIFICATIONS_ALL     : notifications,
-        GROWL_NOTIFICATIONS_DEFAULT : notifications
-    };
-}
-
-- (NSData *)applicationIconDataForGrowl {
-    NSString *iTunesPath = [[NSWorkspace sharedWorkspace] absolutePathForAppBundleWithIdentifier:@"com.apple.iTunes"];
-
-    if (iTunesPath) {
-      return [[[NSWorkspace sharedWorkspace] iconForFile:iTunesPath] TIFFRepresentation];
-    }
+    [service start];
 
-    return nil;
+    return self;
 }
 
-- (void)playerStateDidChange:(NSNotification *)notification {
-    if (!notification) {
-      return;
-    }
-
-    if (![[notification name] isEqual:@"com.apple.iTunes.playerInfo"]) {
-      return;
-    }
-
-    NSDictionary *userInfo = [notification userInfo];
-    if (!userInfo) {
-        return;
-    }
-
-    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
-    SIITunesApplication *iTunes = (SIITunesApplication *)[SBApplication applicationWithBundleIdentifier:@"com.apple.iTunes"];
-
-    if (![iTunes isRunning]) {
-        [pool drain];
-        return;
-    }
-
-    NSString *playerState = [userInfo objectForKey:@"Player State"];
-    if (![playerState isEqual:@"Playing"]) {
-        [pool drain];
-        return;
-    }
-
-    NSString *title = [userInfo objectForKey:@"Name"];
-    if (!title) {
-        title = @"";
-    }
-
-    NSString *artist = [userInfo objectForKey:@"Artist"];
-    if (!artist) {
-        artist = @"";
-    }
-
-    NSString *album = [userInfo objectForKey:@"Album"];
-    if (!album) {
-        album = @"";
-    }
-
-    NSString *description = [NSString stringWithFormat:@"%@\n%@", artist, album];
-    SIITunesTrack *track = [iTunes currentTrack];
-    NSArray *artworks = [[track artworks] get];
-    SIITunesArtwork *artwork = [artworks lastObject];
-    NSData *artworkData = [artwork rawData];
-
-    if (!artworkData) {
-        artworkData = [self applicationIconDataForGrowl];
-    }
-
-    [GrowlApplicationBridge notifyWithTitle:title
-                                description:description
-                           notificationName:@"Playing"
-                                   iconData:artworkData
-                                   priority:0
-                                   isSticky:NO
-                               clickContext:nil
-                                 identifier:@"Playing"];
+- (void)dealloc {
+    [service stop];
+    [service release];
+    [growlSink release];
 
-    [pool drain];
+    [super dealloc];
 }
 
 @end
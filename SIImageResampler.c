@@ -0,0 +1,205 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "SIImageResampler.h"
+
+#define SIImageChannelCount 4
+
+// The taps contributing to each destination pixel along one axis.
+typedef struct SIResampleKernel {
+    size_t tapCount;
+    size_t *firstTaps;
+    size_t *tapCounts;
+    float *weights;
+} SIResampleKernel;
+
+static double SIResampleFilterSupport(SIResampleFilter filter) {
+    return filter == SIResampleFilterLanczos3 ? 3.0 : 0.5;
+}
+
+static double SIResampleFilterWeight(SIResampleFilter filter, double x) {
+    if (filter == SIResampleFilterBox) {
+        return x >= -0.5 && x < 0.5 ? 1.0 : 0.0;
+    }
+
+    if (x == 0.0) {
+        return 1.0;
+    }
+
+    if (x <= -3.0 || x >= 3.0) {
+        return 0.0;
+    }
+
+    double px = M_PI * x;
+
+    return 3.0 * sin(px) * sin(px / 3.0) / (px * px);
+}
+
+static void SIResampleKernelFree(SIResampleKernel *kernel) {
+    free(kernel->firstTaps);
+    free(kernel->tapCounts);
+    free(kernel->weights);
+}
+
+static int SIResampleKernelCreate(SIResampleKernel *kernel,
+                                  size_t sourceLength,
+                                  size_t destinationLength,
+                                  SIResampleFilter filter) {
+    double scale = (double)destinationLength / (double)sourceLength;
+    double filterScale = scale < 1.0 ? scale : 1.0;
+    double support = SIResampleFilterSupport(filter) / filterScale;
+
+    kernel->tapCount = (size_t)ceil(support * 2.0) + 1;
+    kernel->firstTaps = calloc(destinationLength, sizeof(size_t));
+    kernel->tapCounts = calloc(destinationLength, sizeof(size_t));
+    kernel->weights = calloc(destinationLength * kernel->tapCount, sizeof(float));
+
+    if (!kernel->firstTaps || !kernel->tapCounts || !kernel->weights) {
+        SIResampleKernelFree(kernel);
+        return -1;
+    }
+
+    for (size_t i = 0; i < destinationLength; i++) {
+        double center = ((double)i + 0.5) / scale;
+        long first = (long)floor(center - support);
+        long last = (long)ceil(center + support);
+        float *weights = kernel->weights + i * kernel->tapCount;
+        double total = 0.0;
+
+        if (first < 0) {
+            first = 0;
+        }
+
+        if (last > (long)sourceLength) {
+            last = (long)sourceLength;
+        }
+
+        if (last - first > (long)kernel->tapCount) {
+            last = first + (long)kernel->tapCount;
+        }
+
+        for (long j = first; j < last; j++) {
+            double weight = SIResampleFilterWeight(filter, ((double)j + 0.5 - center) * filterScale);
+            weights[j - first] = (float)weight;
+            total += weight;
+        }
+
+        if (total != 0.0) {
+            for (long j = first; j < last; j++) {
+                weights[j - first] = (float)(weights[j - first] / total);
+            }
+        }
+
+        kernel->firstTaps[i] = (size_t)first;
+        kernel->tapCounts[i] = (size_t)(last - first);
+    }
+
+    return 0;
+}
+
+static inline uint8_t SIClampChannel(float value) {
+    if (value <= 0.0f) {
+        return 0;
+    }
+
+    if (value >= 255.0f) {
+        return 255;
+    }
+
+    return (uint8_t)(value + 0.5f);
+}
+
+int SIImageResample(const uint8_t *source,
+                    size_t sourceWidth,
+                    size_t sourceHeight,
+                    size_t sourceStride,
+                    uint8_t *destination,
+                    size_t destinationWidth,
+                    size_t destinationHeight,
+                    size_t destinationStride,
+                    SIResampleFilter filter) {
+    SIResampleKernel horizontal = {0};
+    SIResampleKernel vertical = {0};
+    size_t rowLength = destinationWidth * SIImageChannelCount;
+    float *scratch = malloc(rowLength * sourceHeight * sizeof(float));
+    float *accumulator = malloc(rowLength * sizeof(float));
+
+    if (!scratch
+        || !accumulator
+        || SIResampleKernelCreate(&horizontal, sourceWidth, destinationWidth, filter)
+        || SIResampleKernelCreate(&vertical, sourceHeight, destinationHeight, filter)) {
+        free(scratch);
+        free(accumulator);
+        SIResampleKernelFree(&horizontal);
+        SIResampleKernelFree(&vertical);
+        return -1;
+    }
+
+    for (size_t y = 0; y < sourceHeight; y++) {
+        const uint8_t *sourceRow = source + y * sourceStride;
+        float *scratchRow = scratch + y * rowLength;
+
+        for (size_t x = 0; x < destinationWidth; x++) {
+            const uint8_t *pixel = sourceRow + horizontal.firstTaps[x] * SIImageChannelCount;
+            const float *weights = horizontal.weights + x * horizontal.tapCount;
+            float sum[SIImageChannelCount] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+            for (size_t tap = 0; tap < horizontal.tapCounts[x]; tap++) {
+                for (size_t channel = 0; channel < SIImageChannelCount; channel++) {
+                    sum[channel] += weights[tap] * pixel[tap * SIImageChannelCount + channel];
+                }
+            }
+
+            memcpy(scratchRow + x * SIImageChannelCount, sum, sizeof(sum));
+        }
+    }
+
+    for (size_t y = 0; y < destinationHeight; y++) {
+        const float *weights = vertical.weights + y * vertical.tapCount;
+        uint8_t *destinationRow = destination + y * destinationStride;
+
+        memset(accumulator, 0, rowLength * sizeof(float));
+
+        for (size_t tap = 0; tap < vertical.tapCounts[y]; tap++) {
+            const float weight = weights[tap];
+            const float *scratchRow = scratch + (vertical.firstTaps[y] + tap) * rowLength;
+
+            for (size_t i = 0; i < rowLength; i++) {
+                accumulator[i] += weight * scratchRow[i];
+            }
+        }
+
+        for (size_t i = 0; i < rowLength; i++) {
+            destinationRow[i] = SIClampChannel(accumulator[i]);
+        }
+    }
+
+    free(scratch);
+    free(accumulator);
+    SIResampleKernelFree(&horizontal);
+    SIResampleKernelFree(&vertical);
+
+    return 0;
+}
@@ -0,0 +1,49 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef SIIMAGERESAMPLER_H
+#define SIIMAGERESAMPLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum SIResampleFilter {
+    SIResampleFilterBox,
+    SIResampleFilterLanczos3
+} SIResampleFilter;
+
+// Resamples an 8-bit, four-channel image (premultiplied RGBA or similar)
+// with a separable filter: a horizontal pass into a float scratch image,
+// then a vertical pass that accumulates whole rows, so that both inner loops
+// run over contiguous memory and vectorize. Strides are in bytes. Returns 0
+// on success and -1 if the scratch image cannot be allocated.
+int SIImageResample(const uint8_t *source,
+                    size_t sourceWidth,
+                    size_t sourceHeight,
+                    size_t sourceStride,
+                    uint8_t *destination,
+                    size_t destinationWidth,
+                    size_t destinationHeight,
+                    size_t destinationStride,
+                    SIResampleFilter filter);
+
+#endif
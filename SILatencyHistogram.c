@@ -0,0 +1,131 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include "SILatencyHistogram.h"
+
+static unsigned SILatencyHistogramBucketIndex(uint64_t value) {
+    if (value < 8) {
+        return (unsigned)value;
+    }
+
+    unsigned magnitude = 63 - (unsigned)__builtin_clzll(value);
+
+    return (magnitude - 2) * 8 + (unsigned)((value >> (magnitude - 3)) & 7);
+}
+
+static uint64_t SILatencyHistogramBucketUpperBound(unsigned bucketIndex) {
+    if (bucketIndex < 8) {
+        return bucketIndex;
+    }
+
+    unsigned magnitude = bucketIndex / 8 + 2;
+    uint64_t lowerBound = (uint64_t)(8 + bucketIndex % 8) << (magnitude - 3);
+
+    return lowerBound + (((uint64_t)1 << (magnitude - 3)) - 1);
+}
+
+void SILatencyHistogramReset(SILatencyHistogram *histogram) {
+    for (unsigned i = 0; i < SILatencyHistogramBucketCount; i++) {
+        atomic_store_explicit(&histogram->buckets[i], 0, memory_order_relaxed);
+    }
+
+    atomic_store_explicit(&histogram->count, 0, memory_order_relaxed);
+    atomic_store_explicit(&histogram->total, 0, memory_order_relaxed);
+    atomic_store_explicit(&histogram->maximum, 0, memory_order_relaxed);
+}
+
+void SILatencyHistogramRecord(SILatencyHistogram *histogram, uint64_t nanoseconds) {
+    atomic_fetch_add_explicit(&histogram->buckets[SILatencyHistogramBucketIndex(nanoseconds)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->total, nanoseconds, memory_order_relaxed);
+
+    uint64_t maximum = atomic_load_explicit(&histogram->maximum, memory_order_relaxed);
+    while (nanoseconds > maximum
+        && !atomic_compare_exchange_weak_explicit(&histogram->maximum, &maximum, nanoseconds,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+void SILatencyHistogramMerge(SILatencyHistogram *histogram, const SILatencyHistogram *other) {
+    for (unsigned i = 0; i < SILatencyHistogramBucketCount; i++) {
+        uint64_t bucketCount = atomic_load_explicit(&other->buckets[i], memory_order_relaxed);
+
+        if (bucketCount) {
+            atomic_fetch_add_explicit(&histogram->buckets[i], bucketCount, memory_order_relaxed);
+        }
+    }
+
+    atomic_fetch_add_explicit(&histogram->count, SILatencyHistogramCount(other), memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->total, atomic_load_explicit(&other->total, memory_order_relaxed), memory_order_relaxed);
+
+    uint64_t otherMaximum = SILatencyHistogramMaximum(other);
+    uint64_t maximum = atomic_load_explicit(&histogram->maximum, memory_order_relaxed);
+    while (otherMaximum > maximum
+        && !atomic_compare_exchange_weak_explicit(&histogram->maximum, &maximum, otherMaximum,
+                                                  memory_order_relaxed, memory_order_relaxed)) {
+    }
+}
+
+uint64_t SILatencyHistogramCount(const SILatencyHistogram *histogram) {
+    return atomic_load_explicit(&histogram->count, memory_order_relaxed);
+}
+
+uint64_t SILatencyHistogramMean(const SILatencyHistogram *histogram) {
+    uint64_t count = SILatencyHistogramCount(histogram);
+
+    if (!count) {
+        return 0;
+    }
+
+    return atomic_load_explicit(&histogram->total, memory_order_relaxed) / count;
+}
+
+uint64_t SILatencyHistogramMaximum(const SILatencyHistogram *histogram) {
+    return atomic_load_explicit(&histogram->maximum, memory_order_relaxed);
+}
+
+uint64_t SILatencyHistogramPercentile(const SILatencyHistogram *histogram, double percentile) {
+    uint64_t count = SILatencyHistogramCount(histogram);
+
+    if (!count) {
+        return 0;
+    }
+
+    uint64_t rank = (uint64_t)(percentile / 100.0 * (double)count + 0.5);
+    if (rank < 1) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < SILatencyHistogramBucketCount; i++) {
+        seen += atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+
+        if (seen >= rank) {
+            uint64_t upperBound = SILatencyHistogramBucketUpperBound(i);
+            uint64_t maximum = SILatencyHistogramMaximum(histogram);
+
+            return upperBound < maximum ? upperBound : maximum;
+        }
+    }
+
+    return SILatencyHistogramMaximum(histogram);
+}
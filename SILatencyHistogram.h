@@ -0,0 +1,54 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef SILATENCYHISTOGRAM_H
+#define SILATENCYHISTOGRAM_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+// Log-linear buckets: eight per power of two, exact below eight.
+#define SILatencyHistogramBucketCount 496
+
+// A lock-free latency histogram in nanoseconds with a relative error of at
+// most 12.5%. Recording is safe from any thread; reads are approximate
+// while writers are active.
+typedef struct SILatencyHistogram {
+    _Atomic uint64_t buckets[SILatencyHistogramBucketCount];
+    _Atomic uint64_t count;
+    _Atomic uint64_t total;
+    _Atomic uint64_t maximum;
+} SILatencyHistogram;
+
+void SILatencyHistogramReset(SILatencyHistogram *histogram);
+void SILatencyHistogramRecord(SILatencyHistogram *histogram, uint64_t nanoseconds);
+void SILatencyHistogramMerge(SILatencyHistogram *histogram, const SILatencyHistogram *other);
+
+uint64_t SILatencyHistogramCount(const SILatencyHistogram *histogram);
+uint64_t SILatencyHistogramMean(const SILatencyHistogram *histogram);
+uint64_t SILatencyHistogramMaximum(const SILatencyHistogram *histogram);
+
+// Returns the upper bound of the bucket holding the given percentile
+// (0 to 100), or zero when the histogram is empty.
+uint64_t SILatencyHistogramPercentile(const SILatencyHistogram *histogram, double percentile);
+
+#endif
@@ -0,0 +1,61 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Something holding memory it can give back, such as a cache.
+@protocol SIMemoryConsumer <NSObject>
+
+// Bytes held that eviction could give back.
+- (NSUInteger)memoryCost;
+
+// Gives back at least bytes if it can, least recently used first, and
+// returns how many it gave back.
+- (NSUInteger)evictMemory:(NSUInteger)bytes;
+
+@end
+
+// Holds the caches of the daemon to byteLimit bytes between them. Enforcing
+// the budget asks the consumers, in the order they were added, to give back
+// whatever is over the limit; it costs a lock per consumer when under it.
+// A byteLimit of zero is unlimited. Main thread only.
+@interface SIMemoryBudget : NSObject {
+    NSUInteger byteLimit;
+    NSMutableArray *consumers;
+    NSUInteger peakCost;
+    NSUInteger evictionCount;
+    unsigned long long evictedBytes;
+}
+
+@property (nonatomic, assign) NSUInteger byteLimit;
+@property (nonatomic, readonly) NSUInteger peakCost;
+@property (nonatomic, readonly) NSUInteger evictionCount;
+@property (nonatomic, readonly) unsigned long long evictedBytes;
+
+- (id)initWithByteLimit:(NSUInteger)aByteLimit;
+
+- (void)addConsumer:(id<SIMemoryConsumer>)consumer;
+
+- (NSUInteger)cost;
+- (void)enforce;
+
+- (NSString *)statisticsSummary;
+
+@end
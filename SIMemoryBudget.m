@@ -0,0 +1,107 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIMemoryBudget.h"
+
+@implementation SIMemoryBudget
+
+@synthesize byteLimit;
+@synthesize peakCost;
+@synthesize evictionCount;
+@synthesize evictedBytes;
+
+- (id)init {
+    return [self initWithByteLimit:0];
+}
+
+- (id)initWithByteLimit:(NSUInteger)aByteLimit {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    byteLimit = aByteLimit;
+    consumers = [[NSMutableArray alloc] init];
+
+    return self;
+}
+
+- (void)dealloc {
+    [consumers release];
+
+    [super dealloc];
+}
+
+- (void)addConsumer:(id<SIMemoryConsumer>)consumer {
+    if (consumer && ![consumers containsObject:consumer]) {
+        [consumers addObject:consumer];
+    }
+}
+
+- (NSUInteger)cost {
+    NSUInteger cost = 0;
+
+    for (id<SIMemoryConsumer> consumer in consumers) {
+        cost += [consumer memoryCost];
+    }
+
+    return cost;
+}
+
+- (void)enforce {
+    NSUInteger cost = [self cost];
+
+    if (cost > peakCost) {
+        peakCost = cost;
+    }
+
+    if (!byteLimit || cost <= byteLimit) {
+        return;
+    }
+
+    NSUInteger excess = cost - byteLimit;
+
+    for (id<SIMemoryConsumer> consumer in consumers) {
+        NSUInteger evicted = [consumer evictMemory:excess];
+
+        evictedBytes += evicted;
+        excess = evicted < excess ? excess - evicted : 0;
+
+        if (!excess) {
+            break;
+        }
+    }
+
+    evictionCount++;
+}
+
+- (NSString *)statisticsSummary {
+    return [NSString stringWithFormat:@"memory budget: %lu of %lu bytes, peak %lu; %lu evictions of %llu bytes",
+        (unsigned long)[self cost],
+        (unsigned long)byteLimit,
+        (unsigned long)peakCost,
+        (unsigned long)evictionCount,
+        evictedBytes];
+}
+
+@end
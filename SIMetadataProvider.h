@@ -0,0 +1,53 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIArtworkProvider.h"
+
+// Answers the questions the pipeline asks the media player about the
+// current track beyond what a playerInfo event carries.
+@protocol SIMetadataProvider <SIArtworkProvider>
+
+- (BOOL)isPlayerRunning;
+
+// Renders the player icon, which is shown when a track has no artwork. This
+// may be expensive; SIFallbackIcon keeps the result.
+- (NSData *)playerIconData;
+
+// Changes when the player icon does. Must be cheap.
+- (NSDate *)playerIconModificationDate;
+
+// Returns the persistent IDs of up to count tracks that will play after the
+// given one, or an empty array if that is not the current track or the order
+// is unpredictable, as when shuffling. The artwork provider methods must
+// accept these IDs. Called off the main thread.
+- (NSArray *)persistentIDsOfTracksFollowingPersistentID:(NSString *)persistentID count:(NSUInteger)count;
+
+// Returns the modification date of the track's content if it is known
+// without asking the player, or nil. Cached artwork older than it is fetched
+// again. Asked on every lookup, so must be cheap.
+- (NSDate *)modificationDateOfTrackWithPersistentID:(NSString *)persistentID;
+
+// Returns the seconds left in the current track: zero when nothing is
+// playing, negative when unknown.
+- (NSTimeInterval)remainingTimeOfCurrentTrack;
+
+@end
@@ -0,0 +1,250 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "SIMetrics.h"
+
+typedef struct SIMetricsTraceEvent {
+    uint64_t start;
+    uint64_t duration;
+    uint32_t stage;
+} SIMetricsTraceEvent;
+
+typedef struct SIMetricsThread {
+    struct SIMetricsThread *next;
+    atomic_bool inUse;
+    unsigned index;
+    SILatencyHistogram stages[SIMetricsStageCount];
+    _Atomic uint64_t counters[SIMetricsCounterCount];
+    _Atomic uint64_t traceCount;
+    SIMetricsTraceEvent trace[SIMetricsTraceCapacity];
+} SIMetricsThread;
+
+atomic_int SIMetricsLevel;
+
+static _Atomic(SIMetricsThread *) SIMetricsThreads;
+static atomic_uint SIMetricsThreadCount;
+static pthread_key_t SIMetricsThreadKey;
+static pthread_once_t SIMetricsThreadKeyOnce = PTHREAD_ONCE_INIT;
+static __thread SIMetricsThread *SIMetricsCurrentThread;
+
+static const char *const SIMetricsStageNames[SIMetricsStageCount] = {
+    "receive", "filter", "metadata", "artwork", "format", "post"
+};
+
+static const char *const SIMetricsCounterNames[SIMetricsCounterCount] = {
+    "events", "drops", "cache hits", "cache misses", "notifications"
+};
+
+static void SIMetricsThreadDidExit(void *value) {
+    SIMetricsThread *thread = value;
+
+    atomic_store_explicit(&thread->inUse, false, memory_order_release);
+}
+
+static void SIMetricsCreateThreadKey(void) {
+    pthread_key_create(&SIMetricsThreadKey, SIMetricsThreadDidExit);
+}
+
+static SIMetricsThread *SIMetricsThreadForCurrentThread(void) {
+    SIMetricsThread *thread = SIMetricsCurrentThread;
+
+    if (thread) {
+        return thread;
+    }
+
+    pthread_once(&SIMetricsThreadKeyOnce, SIMetricsCreateThreadKey);
+
+    for (thread = atomic_load_explicit(&SIMetricsThreads, memory_order_acquire); thread; thread = thread->next) {
+        bool inUse = false;
+
+        if (atomic_compare_exchange_strong_explicit(&thread->inUse, &inUse, true,
+                                                    memory_order_acquire, memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    if (!thread) {
+        thread = calloc(1, sizeof(SIMetricsThread));
+
+        if (!thread) {
+            return NULL;
+        }
+
+        atomic_store_explicit(&thread->inUse, true, memory_order_relaxed);
+        thread->index = atomic_fetch_add_explicit(&SIMetricsThreadCount, 1, memory_order_relaxed) + 1;
+
+        SIMetricsThread *head = atomic_load_explicit(&SIMetricsThreads, memory_order_relaxed);
+        do {
+            thread->next = head;
+        } while (!atomic_compare_exchange_weak_explicit(&SIMetricsThreads, &head, thread,
+                                                        memory_order_release, memory_order_relaxed));
+    }
+
+    pthread_setspecific(SIMetricsThreadKey, thread);
+    SIMetricsCurrentThread = thread;
+
+    return thread;
+}
+
+void SIMetricsSetLevel(int level) {
+    atomic_store_explicit(&SIMetricsLevel, level, memory_order_relaxed);
+}
+
+void SIMetricsRecord(SIMetricsStage stage, uint64_t start, uint64_t end) {
+    SIMetricsThread *thread = SIMetricsThreadForCurrentThread();
+
+    if (!thread || stage >= SIMetricsStageCount) {
+        return;
+    }
+
+    uint64_t duration = end > start ? end - start : 0;
+    SILatencyHistogramRecord(&thread->stages[stage], duration);
+
+    if (atomic_load_explicit(&SIMetricsLevel, memory_order_relaxed) == SIMetricsTracing) {
+        uint64_t traceCount = atomic_load_explicit(&thread->traceCount, memory_order_relaxed);
+        SIMetricsTraceEvent *event = &thread->trace[traceCount % SIMetricsTraceCapacity];
+
+        event->start = start;
+        event->duration = duration;
+        event->stage = stage;
+        atomic_store_explicit(&thread->traceCount, traceCount + 1, memory_order_release);
+    }
+}
+
+void SIMetricsAdd(SIMetricsCounter counter, uint64_t amount) {
+    SIMetricsThread *thread = SIMetricsThreadForCurrentThread();
+
+    if (!thread || counter >= SIMetricsCounterCount) {
+        return;
+    }
+
+    atomic_fetch_add_explicit(&thread->counters[counter], amount, memory_order_relaxed);
+}
+
+const char *SIMetricsStageName(SIMetricsStage stage) {
+    return stage < SIMetricsStageCount ? SIMetricsStageNames[stage] : "unknown";
+}
+
+const char *SIMetricsCounterName(SIMetricsCounter counter) {
+    return counter < SIMetricsCounterCount ? SIMetricsCounterNames[counter] : "unknown";
+}
+
+void SIMetricsCollect(SILatencyHistogram *stages, uint64_t *counters) {
+    for (unsigned i = 0; i < SIMetricsStageCount; i++) {
+        SILatencyHistogramReset(&stages[i]);
+    }
+
+    memset(counters, 0, sizeof(uint64_t) * SIMetricsCounterCount);
+
+    SIMetricsThread *thread = atomic_load_explicit(&SIMetricsThreads, memory_order_acquire);
+    for (; thread; thread = thread->next) {
+        for (unsigned i = 0; i < SIMetricsStageCount; i++) {
+            SILatencyHistogramMerge(&stages[i], &thread->stages[i]);
+        }
+
+        for (unsigned i = 0; i < SIMetricsCounterCount; i++) {
+            counters[i] += atomic_load_explicit(&thread->counters[i], memory_order_relaxed);
+        }
+    }
+}
+
+int SIMetricsFormat(char *buffer, size_t size) {
+    static const char *const levelNames[] = { "off", "on", "tracing" };
+    int level = atomic_load_explicit(&SIMetricsLevel, memory_order_relaxed);
+    SILatencyHistogram *stages = calloc(SIMetricsStageCount, sizeof(SILatencyHistogram));
+    uint64_t counters[SIMetricsCounterCount];
+
+    if (!stages) {
+        return snprintf(buffer, size, "metrics: out of memory\n");
+    }
+
+    SIMetricsCollect(stages, counters);
+
+    int written = snprintf(buffer, size, "metrics: %s\n",
+                           level >= SIMetricsOff && level <= SIMetricsTracing ? levelNames[level] : "unknown");
+    int total = written;
+
+    for (unsigned i = 0; i < SIMetricsStageCount && written >= 0; i++) {
+        written = snprintf(buffer + ((size_t)total < size ? (size_t)total : size),
+                           (size_t)total < size ? size - (size_t)total : 0,
+                           "%-8s n=%llu p50=%.3fms p99=%.3fms max=%.3fms\n",
+                           SIMetricsStageNames[i],
+                           (unsigned long long)SILatencyHistogramCount(&stages[i]),
+                           SILatencyHistogramPercentile(&stages[i], 50) / 1e6,
+                           SILatencyHistogramPercentile(&stages[i], 99) / 1e6,
+                           SILatencyHistogramMaximum(&stages[i]) / 1e6);
+        total += written;
+    }
+
+    for (unsigned i = 0; i < SIMetricsCounterCount && written >= 0; i++) {
+        written = snprintf(buffer + ((size_t)total < size ? (size_t)total : size),
+                           (size_t)total < size ? size - (size_t)total : 0,
+                           "%s%s=%llu%s",
+                           i ? " " : "",
+                           SIMetricsCounterNames[i],
+                           (unsigned long long)counters[i],
+                           i + 1 == SIMetricsCounterCount ? "\n" : "");
+        total += written;
+    }
+
+    free(stages);
+
+    return written < 0 ? written : total;
+}
+
+int SIMetricsWriteTrace(FILE *file) {
+    int processIdentifier = (int)getpid();
+    const char *separator = "";
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+
+    SIMetricsThread *thread = atomic_load_explicit(&SIMetricsThreads, memory_order_acquire);
+    for (; thread; thread = thread->next) {
+        uint64_t traceCount = atomic_load_explicit(&thread->traceCount, memory_order_acquire);
+        uint64_t first = traceCount > SIMetricsTraceCapacity ? traceCount - SIMetricsTraceCapacity : 0;
+
+        fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,"
+                      "\"args\":{\"name\":\"thread %u\"}}",
+                separator, processIdentifier, thread->index, thread->index);
+        separator = ",";
+
+        // Events being overwritten while this runs may come out mixed up;
+        // the dump is a diagnostic, not a record.
+        for (uint64_t i = first; i < traceCount; i++) {
+            const SIMetricsTraceEvent *event = &thread->trace[i % SIMetricsTraceCapacity];
+
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"itunesnotify\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,"
+                          "\"ts\":%.3f,\"dur\":%.3f}",
+                    SIMetricsStageName(event->stage), processIdentifier, thread->index,
+                    event->start / 1e3, event->duration / 1e3);
+        }
+    }
+
+    fputs("\n]}\n", file);
+
+    return fflush(file) == 0 && !ferror(file) ? 0 : -1;
+}
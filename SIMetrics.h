@@ -0,0 +1,109 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef SIMETRICS_H
+#define SIMETRICS_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "SIClock.h"
+#include "SILatencyHistogram.h"
+
+// The stages of handling a player event, in order.
+typedef enum SIMetricsStage {
+    SIMetricsStageReceive,
+    SIMetricsStageFilter,
+    SIMetricsStageMetadata,
+    SIMetricsStageArtwork,
+    SIMetricsStageFormat,
+    SIMetricsStagePost,
+    SIMetricsStageCount
+} SIMetricsStage;
+
+typedef enum SIMetricsCounter {
+    SIMetricsCounterEvents,
+    SIMetricsCounterDrops,
+    SIMetricsCounterCacheHits,
+    SIMetricsCounterCacheMisses,
+    SIMetricsCounterNotifications,
+    SIMetricsCounterCount
+} SIMetricsCounter;
+
+// The trace events kept per thread; older ones are overwritten.
+#define SIMetricsTraceCapacity 1024
+
+enum {
+    SIMetricsOff,
+    SIMetricsOn,
+    SIMetricsTracing
+};
+
+extern atomic_int SIMetricsLevel;
+
+// Every thread records into histograms and a trace ring of its own, so
+// recording takes no lock and shares no cache line. Thread records are
+// reused once their thread exits, keeping what they had recorded. While
+// metrics are off, a stage costs one relaxed load and a branch.
+void SIMetricsSetLevel(int level);
+
+// Returns the start of a stage, or zero while metrics are off.
+static inline uint64_t SIMetricsBegin(void) {
+    if (__builtin_expect(atomic_load_explicit(&SIMetricsLevel, memory_order_relaxed) == SIMetricsOff, 1)) {
+        return 0;
+    }
+
+    uint64_t now = SIMonotonicNanoseconds();
+
+    return now ? now : 1;
+}
+
+void SIMetricsRecord(SIMetricsStage stage, uint64_t start, uint64_t end);
+void SIMetricsAdd(SIMetricsCounter counter, uint64_t amount);
+
+// Ends a stage begun by SIMetricsBegin.
+static inline void SIMetricsEnd(SIMetricsStage stage, uint64_t start) {
+    if (__builtin_expect(start != 0, 0)) {
+        SIMetricsRecord(stage, start, SIMonotonicNanoseconds());
+    }
+}
+
+static inline void SIMetricsCount(SIMetricsCounter counter) {
+    if (__builtin_expect(atomic_load_explicit(&SIMetricsLevel, memory_order_relaxed) != SIMetricsOff, 0)) {
+        SIMetricsAdd(counter, 1);
+    }
+}
+
+const char *SIMetricsStageName(SIMetricsStage stage);
+const char *SIMetricsCounterName(SIMetricsCounter counter);
+
+// Sums every thread's records. Approximate while threads are recording.
+void SIMetricsCollect(SILatencyHistogram *stages, uint64_t *counters);
+
+// Writes one line per stage and one of counters, like snprintf.
+int SIMetricsFormat(char *buffer, size_t size);
+
+// Writes the trace events still held, in the Chrome trace event format that
+// chrome://tracing and Perfetto open. Returns zero, or -1 with errno set.
+int SIMetricsWriteTrace(FILE *file);
+
+#endif
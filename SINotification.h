@@ -0,0 +1,54 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SITrack.h"
+
+// A rendered "now playing" notification, ready to be handed to a sink.
+@interface SINotification : NSObject {
+    NSString *title;
+    NSString *body;
+    NSData *iconData;
+    NSString *identifier;
+    SITrack *track;
+    uint64_t receivedAt;
+}
+
+@property (nonatomic, copy) NSString *title;
+@property (nonatomic, copy) NSString *body;
+@property (nonatomic, retain) NSData *iconData;
+@property (nonatomic, copy) NSString *identifier;
+@property (nonatomic, retain) SITrack *track;
+
+// The SIMonotonicNanoseconds time the event behind the notification arrived.
+@property (nonatomic, assign) uint64_t receivedAt;
+
+// The text fields and track identity, for serializing to JSON.
+- (NSDictionary *)dictionaryRepresentation;
+
+@end
+
+// Delivers notifications to the user or to another process.
+@protocol SINotificationSink <NSObject>
+
+- (void)postNotification:(SINotification *)notification;
+
+@end
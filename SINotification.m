@@ -0,0 +1,59 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SINotification.h"
+
+@implementation SINotification
+
+@synthesize title;
+@synthesize body;
+@synthesize iconData;
+@synthesize identifier;
+@synthesize track;
+@synthesize receivedAt;
+
+- (void)dealloc {
+    [title release];
+    [body release];
+    [iconData release];
+    [identifier release];
+    [track release];
+
+    [super dealloc];
+}
+
+- (NSDictionary *)dictionaryRepresentation {
+    NSMutableDictionary *dictionary = [NSMutableDictionary dictionaryWithCapacity:8];
+
+    [dictionary setValue:title forKey:@"title"];
+    [dictionary setValue:body forKey:@"body"];
+    [dictionary setValue:identifier forKey:@"identifier"];
+    [dictionary setValue:[track persistentID] forKey:@"persistentID"];
+    [dictionary setValue:[track name] forKey:@"name"];
+    [dictionary setValue:[track artist] forKey:@"artist"];
+    [dictionary setValue:[track album] forKey:@"album"];
+    [dictionary setValue:[track playerState] forKey:@"playerState"];
+
+    return dictionary;
+}
+
+@end
@@ -0,0 +1,44 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SINotification.h"
+#import "SISinkQueue.h"
+
+// Fans each notification out to every registered sink, each behind its own
+// SISinkQueue. Sinks are added before the first notification is posted and
+// the dispatcher must be stopped before it is released.
+@interface SINotificationDispatcher : NSObject <SINotificationSink> {
+    NSMutableArray *queues;
+}
+
+- (SISinkQueue *)addSink:(id<SINotificationSink>)sink
+                    name:(NSString *)name
+                capacity:(NSUInteger)capacity
+                  policy:(SISinkQueuePolicy)policy;
+
+- (NSArray *)queues;
+
+- (void)stop;
+
+- (NSString *)statisticsSummary;
+
+@end
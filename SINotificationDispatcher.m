@@ -0,0 +1,84 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SINotificationDispatcher.h"
+
+@implementation SINotificationDispatcher
+
+- (id)init {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    queues = [[NSMutableArray alloc] init];
+
+    return self;
+}
+
+- (void)dealloc {
+    [queues release];
+
+    [super dealloc];
+}
+
+- (SISinkQueue *)addSink:(id<SINotificationSink>)sink
+                    name:(NSString *)name
+                capacity:(NSUInteger)capacity
+                  policy:(SISinkQueuePolicy)policy {
+    SISinkQueue *queue = [[[SISinkQueue alloc] initWithSink:sink name:name capacity:capacity policy:policy] autorelease];
+
+    if (queue) {
+        [queues addObject:queue];
+    }
+
+    return queue;
+}
+
+- (NSArray *)queues {
+    return [[queues copy] autorelease];
+}
+
+- (void)postNotification:(SINotification *)notification {
+    for (SISinkQueue *queue in queues) {
+        [queue enqueueNotification:notification];
+    }
+}
+
+- (void)stop {
+    for (SISinkQueue *queue in queues) {
+        [queue stop];
+    }
+}
+
+- (NSString *)statisticsSummary {
+    NSMutableArray *summaries = [NSMutableArray arrayWithCapacity:[queues count]];
+
+    for (SISinkQueue *queue in queues) {
+        [summaries addObject:[queue statisticsSummary]];
+    }
+
+    return [summaries componentsJoinedByString:@"\n"];
+}
+
+@end
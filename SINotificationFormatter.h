@@ -0,0 +1,67 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+typedef struct SIFormatSegment SIFormatSegment;
+
+// Renders notification text from a template such as "{artist} — {album}".
+// The template is compiled once into literal and field segments; fields name
+// playerInfo userInfo keys ("{Genre}"), or one of the shorthands name,
+// artist, album, genre, composer, year and stream, for the Stream Title.
+// "{{" and "}}" stand for literal braces.
+//
+// Rendering writes into a buffer the formatter owns and reuses, so once the
+// buffer has grown to fit the longest text no rendering allocates; a string
+// for a sink costs the one copy of the text. allocationCount counts the times
+// the buffer had to grow.
+@interface SINotificationFormatter : NSObject {
+    NSString *templateString;
+    SIFormatSegment *segments;
+    NSUInteger segmentCount;
+    unichar *literals;
+    NSMutableArray *fieldKeys;
+    unichar *buffer;
+    NSUInteger bufferCapacity;
+    NSUInteger length;
+    NSUInteger allocationCount;
+}
+
+@property (nonatomic, readonly) NSString *templateString;
+@property (nonatomic, readonly) NSUInteger allocationCount;
+
++ (id)formatterWithTemplate:(NSString *)aTemplateString;
+
+- (id)initWithTemplate:(NSString *)aTemplateString;
+
+// Renders the template into the buffer and returns the length of the text.
+// The characters stay valid until the next rendering.
+- (NSUInteger)renderUserInfo:(NSDictionary *)userInfo;
+- (const unichar *)characters;
+
+// Renders the template and copies the text into a new string for handing to
+// a sink.
+- (NSString *)stringForUserInfo:(NSDictionary *)userInfo;
+
+// Whether a field the template reads differs between the two, which is what
+// decides if their text differs, without rendering either.
+- (BOOL)rendersUserInfo:(NSDictionary *)userInfo differentlyFromUserInfo:(NSDictionary *)otherUserInfo;
+
+@end
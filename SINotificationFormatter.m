@@ -0,0 +1,225 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SINotificationFormatter.h"
+
+typedef enum SIFormatSegmentKind {
+    SIFormatSegmentKindLiteral,
+    SIFormatSegmentKindField
+} SIFormatSegmentKind;
+
+struct SIFormatSegment {
+    SIFormatSegmentKind kind;
+    NSUInteger offset;
+    NSUInteger length;
+    NSString *key;
+};
+
+static NSString *SIFormatFieldKey(NSString *field) {
+    NSDictionary *shorthands = @{
+        @"name"     : @"Name",
+        @"title"    : @"Name",
+        @"artist"   : @"Artist",
+        @"album"    : @"Album",
+        @"genre"    : @"Genre",
+        @"composer" : @"Composer",
+        @"year"     : @"Year",
+        @"stream"   : @"Stream Title"
+    };
+    NSString *key = [shorthands objectForKey:field];
+
+    return key ? key : field;
+}
+
+@implementation SINotificationFormatter
+
+@synthesize templateString;
+@synthesize allocationCount;
+
++ (id)formatterWithTemplate:(NSString *)aTemplateString {
+    return [[[self alloc] initWithTemplate:aTemplateString] autorelease];
+}
+
+- (id)init {
+    return [self initWithTemplate:@""];
+}
+
+- (id)initWithTemplate:(NSString *)aTemplateString {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    templateString = [aTemplateString copy];
+
+    NSUInteger templateLength = [templateString length];
+    unichar *characters = malloc((templateLength + 1) * sizeof(unichar));
+    [templateString getCharacters:characters range:NSMakeRange(0, templateLength)];
+
+    segments = calloc(templateLength + 1, sizeof(SIFormatSegment));
+    literals = malloc((templateLength + 1) * sizeof(unichar));
+    fieldKeys = [[NSMutableArray alloc] init];
+
+    NSUInteger literalLength = 0;
+    NSUInteger i = 0;
+
+    while (i < templateLength) {
+        unichar character = characters[i];
+        BOOL escaped = (character == '{' || character == '}') && i + 1 < templateLength && characters[i + 1] == character;
+
+        if (character == '{' && !escaped) {
+            NSUInteger end = i + 1;
+
+            while (end < templateLength && characters[end] != '}') {
+                end++;
+            }
+
+            if (end < templateLength) {
+                NSString *field = [NSString stringWithCharacters:characters + i + 1 length:end - i - 1];
+                NSString *key = SIFormatFieldKey(field);
+
+                [fieldKeys addObject:key];
+                segments[segmentCount].kind = SIFormatSegmentKindField;
+                segments[segmentCount].key = key;
+                segmentCount++;
+                i = end + 1;
+                continue;
+            }
+        }
+
+        if (segmentCount == 0 || segments[segmentCount - 1].kind != SIFormatSegmentKindLiteral) {
+            segments[segmentCount].kind = SIFormatSegmentKindLiteral;
+            segments[segmentCount].offset = literalLength;
+            segmentCount++;
+        }
+
+        literals[literalLength++] = character;
+        segments[segmentCount - 1].length++;
+        i += escaped ? 2 : 1;
+    }
+
+    free(characters);
+
+    return self;
+}
+
+- (void)dealloc {
+    [templateString release];
+    [fieldKeys release];
+    free(segments);
+    free(literals);
+    free(buffer);
+
+    [super dealloc];
+}
+
+- (void)reserveCapacity:(NSUInteger)capacity {
+    if (capacity <= bufferCapacity) {
+        return;
+    }
+
+    NSUInteger newCapacity = MAX(capacity, MAX(bufferCapacity * 2, (NSUInteger)64));
+    buffer = realloc(buffer, newCapacity * sizeof(unichar));
+    bufferCapacity = newCapacity;
+    allocationCount++;
+}
+
+- (void)appendCharacters:(const unichar *)characters length:(NSUInteger)count {
+    [self reserveCapacity:length + count];
+    memcpy(buffer + length, characters, count * sizeof(unichar));
+    length += count;
+}
+
+- (void)appendValue:(id)value {
+    if ([value isKindOfClass:[NSString class]]) {
+        NSUInteger valueLength = [value length];
+
+        [self reserveCapacity:length + valueLength];
+        [value getCharacters:buffer + length range:NSMakeRange(0, valueLength)];
+        length += valueLength;
+        return;
+    }
+
+    if ([value isKindOfClass:[NSNumber class]]) {
+        long long number = [value longLongValue];
+        unsigned long long magnitude = number < 0 ? 0ULL - (unsigned long long)number : (unsigned long long)number;
+        unichar digits[21];
+        NSUInteger digitCount = 0;
+
+        do {
+            digits[sizeof(digits) / sizeof(digits[0]) - ++digitCount] = (unichar)('0' + magnitude % 10);
+            magnitude /= 10;
+        } while (magnitude);
+
+        if (number < 0) {
+            digits[sizeof(digits) / sizeof(digits[0]) - ++digitCount] = '-';
+        }
+
+        [self appendCharacters:digits + sizeof(digits) / sizeof(digits[0]) - digitCount length:digitCount];
+    }
+}
+
+- (NSUInteger)renderUserInfo:(NSDictionary *)userInfo {
+    length = 0;
+
+    for (NSUInteger i = 0; i < segmentCount; i++) {
+        SIFormatSegment *segment = &segments[i];
+
+        if (segment->kind == SIFormatSegmentKindLiteral) {
+            [self appendCharacters:literals + segment->offset length:segment->length];
+        } else {
+            [self appendValue:[userInfo objectForKey:segment->key]];
+        }
+    }
+
+    return length;
+}
+
+- (const unichar *)characters {
+    return buffer;
+}
+
+- (NSString *)stringForUserInfo:(NSDictionary *)userInfo {
+    NSUInteger renderedLength = [self renderUserInfo:userInfo];
+
+    return [[[NSString alloc] initWithCharacters:buffer length:renderedLength] autorelease];
+}
+
+- (BOOL)rendersUserInfo:(NSDictionary *)userInfo differentlyFromUserInfo:(NSDictionary *)otherUserInfo {
+    for (NSUInteger i = 0; i < segmentCount; i++) {
+        if (segments[i].kind != SIFormatSegmentKindField) {
+            continue;
+        }
+
+        id value = [userInfo objectForKey:segments[i].key];
+        id otherValue = [otherUserInfo objectForKey:segments[i].key];
+
+        if (value != otherValue && ![value isEqual:otherValue]) {
+            return YES;
+        }
+    }
+
+    return NO;
+}
+
+@end
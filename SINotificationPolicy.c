@@ -0,0 +1,103 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdio.h>
+#include "SINotificationPolicy.h"
+
+static uint64_t SINanosecondsFromSeconds(double seconds) {
+    return seconds > 0 ? (uint64_t)(seconds * 1e9) : 0;
+}
+
+void SINotificationPolicyCompile(SINotificationPolicy *policy, const SINotificationPolicyRules *rules, uint64_t now) {
+    policy->duplicateInterval = SINanosecondsFromSeconds(rules->duplicateInterval);
+    policy->streamTitleInterval = SINanosecondsFromSeconds(rules->streamTitleInterval);
+
+    if (rules->notificationsPerMinute > 0) {
+        policy->tokenCost = SINanosecondsFromSeconds(60 / rules->notificationsPerMinute);
+        policy->bucketCapacity = policy->tokenCost * (uint64_t)(rules->notificationsPerMinute < 1 ? 1 : rules->notificationsPerMinute);
+    } else {
+        policy->tokenCost = 0;
+        policy->bucketCapacity = 0;
+    }
+
+    policy->credit = policy->bucketCapacity;
+    policy->creditUpdatedAt = now;
+}
+
+SINotificationPolicyVerdict SINotificationPolicyEvaluate(SINotificationPolicy *policy,
+                                                         uint64_t track,
+                                                         uint64_t streamTitle,
+                                                         uint64_t now) {
+    SINotificationPolicyVerdict verdict = SINotificationPolicyAllow;
+
+    if (policy->track && track == policy->track) {
+        if (streamTitle == policy->streamTitle) {
+            if (now - policy->seenAt < policy->duplicateInterval) {
+                verdict = SINotificationPolicySuppressDuplicate;
+            }
+        } else if (now - policy->notifiedAt < policy->streamTitleInterval) {
+            verdict = SINotificationPolicySuppressStreamTitle;
+        }
+
+        policy->seenAt = now;
+    }
+
+    if (verdict == SINotificationPolicyAllow && policy->tokenCost) {
+        uint64_t credit = policy->credit + (now - policy->creditUpdatedAt);
+
+        policy->credit = credit < policy->bucketCapacity ? credit : policy->bucketCapacity;
+        policy->creditUpdatedAt = now;
+
+        if (policy->credit < policy->tokenCost) {
+            verdict = SINotificationPolicySuppressRate;
+        } else {
+            policy->credit -= policy->tokenCost;
+        }
+    }
+
+    if (verdict == SINotificationPolicyAllow) {
+        policy->track = track;
+        policy->streamTitle = streamTitle;
+        policy->notifiedAt = now;
+        policy->seenAt = now;
+    }
+
+    policy->counts[verdict]++;
+
+    return verdict;
+}
+
+const char *SINotificationPolicyVerdictName(SINotificationPolicyVerdict verdict) {
+    static const char *names[SINotificationPolicyVerdictCount] = {
+        "allowed", "duplicate", "rate", "stream title"
+    };
+
+    return verdict < SINotificationPolicyVerdictCount ? names[verdict] : "unknown";
+}
+
+int SINotificationPolicyFormat(const SINotificationPolicy *policy, char *buffer, size_t size) {
+    return snprintf(buffer, size, "policy: %llu allowed; suppressed %llu duplicate, %llu rate, %llu stream title",
+                    (unsigned long long)policy->counts[SINotificationPolicyAllow],
+                    (unsigned long long)policy->counts[SINotificationPolicySuppressDuplicate],
+                    (unsigned long long)policy->counts[SINotificationPolicySuppressRate],
+                    (unsigned long long)policy->counts[SINotificationPolicySuppressStreamTitle]);
+}
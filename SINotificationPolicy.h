@@ -0,0 +1,85 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef SINOTIFICATIONPOLICY_H
+#define SINOTIFICATIONPOLICY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// What the policy decided for an event: post it, or the rule that
+// suppressed it.
+typedef enum SINotificationPolicyVerdict {
+    SINotificationPolicyAllow,
+    SINotificationPolicySuppressDuplicate,
+    SINotificationPolicySuppressRate,
+    SINotificationPolicySuppressStreamTitle,
+    SINotificationPolicyVerdictCount
+} SINotificationPolicyVerdict;
+
+// The rules as configured; a zero turns a rule off.
+typedef struct SINotificationPolicyRules {
+    // Seconds after the last event for the notified track during which it
+    // is not notified again, which swallows pauses, resumes and seeks.
+    double duplicateInterval;
+    // Notifications allowed per minute, in bursts of up to as many.
+    double notificationsPerMinute;
+    // Seconds after notifying a stream during which a new stream title for
+    // it is not notified.
+    double streamTitleInterval;
+} SINotificationPolicyRules;
+
+// Rules compiled to nanoseconds, and the little state they need. A token
+// costs tokenCost nanoseconds of credit, which accrues with time up to the
+// bucket capacity, so the bucket needs no timer and no division per event.
+typedef struct SINotificationPolicy {
+    uint64_t duplicateInterval;
+    uint64_t tokenCost;
+    uint64_t bucketCapacity;
+    uint64_t streamTitleInterval;
+    uint64_t track;
+    uint64_t streamTitle;
+    uint64_t notifiedAt;
+    uint64_t seenAt;
+    uint64_t credit;
+    uint64_t creditUpdatedAt;
+    uint64_t counts[SINotificationPolicyVerdictCount];
+} SINotificationPolicy;
+
+// Compiles the rules into a zeroed or already compiled policy, keeping its
+// counts and last notified track and refilling the bucket.
+void SINotificationPolicyCompile(SINotificationPolicy *policy, const SINotificationPolicyRules *rules, uint64_t now);
+
+// Decides on a playing event. Tracks and stream titles are identified by
+// nonzero keys, such as hashes; a zero stream title means none. Constant
+// time, and allocates nothing. Not thread safe.
+SINotificationPolicyVerdict SINotificationPolicyEvaluate(SINotificationPolicy *policy,
+                                                         uint64_t track,
+                                                         uint64_t streamTitle,
+                                                         uint64_t now);
+
+const char *SINotificationPolicyVerdictName(SINotificationPolicyVerdict verdict);
+
+// Writes a one-line summary of the counts, like snprintf.
+int SINotificationPolicyFormat(const SINotificationPolicy *policy, char *buffer, size_t size);
+
+#endif
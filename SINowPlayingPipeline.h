@@ -0,0 +1,136 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIArtworkCache.h"
+#import "SIArtworkFetchOperation.h"
+#import "SIArtworkPrefetcher.h"
+#import "SIClock.h"
+#import "SIEventSource.h"
+#import "SIFallbackIcon.h"
+#import "SILatencyHistogram.h"
+#import "SIMemoryBudget.h"
+#import "SIMetadataProvider.h"
+#import "SINotification.h"
+#import "SINotificationFormatter.h"
+#import "SINotificationPolicy.h"
+#import "SINowPlayingPublisher.h"
+#import "SIPlayHistory.h"
+
+// Turns playerInfo events into "now playing" notifications: filters them,
+// resolves artwork through the cache and posts the result to a sink. Every
+// event, including pauses, is handed to the publisher and the play history
+// first; playing events then go through the notification policy.
+//
+// A stream changing its title while it is the track already notified updates
+// the notification in place: the text is rendered again only if a field it
+// shows changed, and the artwork posted is reused without touching the cache
+// or the player. Any other playing event the policy lets through, such as the
+// same track played again, is notified anew.
+//
+// Each event is handled inside an autorelease pool and the thread's arena,
+// both emptied once it is done, after which the memory budget, if any, is
+// enforced.
+//
+// Artwork cache misses are fetched on a worker queue. The pipeline waits for
+// the fetch at most artworkLatencyBudget seconds; past that it posts the
+// notification with the fallback icon and updates it in place once the artwork
+// arrives. A track change cancels the fetch for the previous one.
+@interface SINowPlayingPipeline : NSObject <SIEventSourceDelegate, SIArtworkFetchOperationDelegate> {
+    id<SIMetadataProvider> metadataProvider;
+    SIArtworkCache *artworkCache;
+    SIFallbackIcon *fallbackIcon;
+    id<SINotificationSink> sink;
+    SINowPlayingPublisher *publisher;
+    SIArtworkPrefetcher *prefetcher;
+    SIPlayHistory *history;
+    SIMemoryBudget *memoryBudget;
+    SINotificationFormatter *titleFormatter;
+    SINotificationFormatter *bodyFormatter;
+    SINotificationFormatter *streamBodyFormatter;
+    NSOperationQueue *artworkQueue;
+    NSTimeInterval artworkLatencyBudget;
+    SIArtworkFetchOperation *pendingFetch;
+    SITrack *pendingTrack;
+    uint64_t pendingReceivedAt;
+    SITrack *postedTrack;
+    NSData *postedIconData;
+    NSUInteger updateCount;
+    NSUInteger unchangedUpdateCount;
+    SILatencyHistogram *firstNotificationLatency;
+    SILatencyHistogram *artworkLatency;
+    SINotificationPolicy *policy;
+    SINotificationPolicyRules policyRules;
+    SIClockFunction policyClock;
+    NSUInteger appleEventTrackCount;
+    unsigned long long appleEventCount;
+    unsigned long long maximumAppleEventsPerTrack;
+}
+
+@property (nonatomic, retain) id<SINotificationSink> sink;
+@property (nonatomic, retain) SINowPlayingPublisher *publisher;
+@property (nonatomic, retain) SIArtworkPrefetcher *prefetcher;
+@property (nonatomic, retain) SIPlayHistory *history;
+@property (nonatomic, retain) SIMemoryBudget *memoryBudget;
+@property (nonatomic, retain) SINotificationFormatter *titleFormatter;
+@property (nonatomic, retain) SINotificationFormatter *bodyFormatter;
+// The body for streams, which have no artist or album but a song title.
+@property (nonatomic, retain) SINotificationFormatter *streamBodyFormatter;
+@property (nonatomic, assign) NSTimeInterval artworkLatencyBudget;
+// The clock the policy measures its intervals by, SIMonotonicNanoseconds
+// unless a replay substitutes the time of its trace. Setting it compiles the
+// rules again, refilling the bucket on the new clock.
+@property (nonatomic, assign) SIClockFunction policyClock;
+
+- (id)initWithMetadataProvider:(id<SIMetadataProvider>)aMetadataProvider
+                  artworkCache:(SIArtworkCache *)anArtworkCache
+                  fallbackIcon:(SIFallbackIcon *)aFallbackIcon;
+
+- (void)processPlayerInfo:(NSDictionary *)userInfo;
+
+// Time from receiving an event to posting its first notification, and to
+// posting it with its artwork.
+- (const SILatencyHistogram *)firstNotificationLatency;
+- (const SILatencyHistogram *)artworkLatency;
+- (NSString *)latencySummary;
+
+// Replaces the rules that decide which playing events are notified. The
+// counts of events each rule suppressed are kept.
+- (void)setPolicyRules:(const SINotificationPolicyRules *)rules;
+- (const SINotificationPolicy *)policy;
+- (NSString *)policySummary;
+
+// Events for the track already notified that updated the notification in
+// place, and those that changed nothing it shows.
+- (NSUInteger)updateCount;
+- (NSUInteger)unchangedUpdateCount;
+- (NSString *)updateSummary;
+
+// Apple Events sent to resolve the artwork of each track notified, counted
+// once its artwork is known; cache hits send none.
+- (unsigned long long)maximumAppleEventsPerTrack;
+- (NSString *)appleEventSummary;
+
+// The number of times the formatters had to grow their buffers; constant in
+// steady state.
+- (NSUInteger)formattingAllocationCount;
+
+@end
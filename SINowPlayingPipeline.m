@@ -0,0 +1,387 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SINowPlayingPipeline.h"
+#import "SIArena.h"
+#import "SIClock.h"
+#import "SIContentHash.h"
+#import "SIMetrics.h"
+
+static NSString *SILatencyHistogramSummary(const SILatencyHistogram *histogram) {
+    return [NSString stringWithFormat:@"n=%llu p50=%.2fms p99=%.2fms max=%.2fms",
+        (unsigned long long)SILatencyHistogramCount(histogram),
+        SILatencyHistogramPercentile(histogram, 50) / 1e6,
+        SILatencyHistogramPercentile(histogram, 99) / 1e6,
+        SILatencyHistogramMaximum(histogram) / 1e6];
+}
+
+// Identifies a string to the policy by the hash of all its UTF-8 bytes,
+// converted a stack buffer at a time, so that strings of any length stay
+// apart without allocating.
+static uint64_t SIPolicyKeyForString(NSString *string) {
+    NSUInteger length = [string length];
+    NSRange remainingRange = NSMakeRange(0, length);
+    SIContentHashState state;
+    char buffer[256];
+
+    if (!length) {
+        return 0;
+    }
+
+    SIContentHashBegin(&state, length);
+
+    while (remainingRange.length) {
+        NSUInteger usedLength = 0;
+
+        [string getBytes:buffer
+               maxLength:sizeof(buffer)
+              usedLength:&usedLength
+                encoding:NSUTF8StringEncoding
+                 options:0
+                   range:remainingRange
+          remainingRange:&remainingRange];
+
+        if (!usedLength) {
+            break;
+        }
+
+        SIContentHashUpdate(&state, buffer, usedLength);
+    }
+
+    uint64_t key = SIContentHashEnd(&state);
+
+    return key ? key : 1;
+}
+
+@implementation SINowPlayingPipeline
+
+@synthesize sink;
+@synthesize publisher;
+@synthesize prefetcher;
+@synthesize history;
+@synthesize memoryBudget;
+@synthesize titleFormatter;
+@synthesize bodyFormatter;
+@synthesize streamBodyFormatter;
+@synthesize artworkLatencyBudget;
+@synthesize policyClock;
+
+- (id)initWithMetadataProvider:(id<SIMetadataProvider>)aMetadataProvider
+                  artworkCache:(SIArtworkCache *)anArtworkCache
+                  fallbackIcon:(SIFallbackIcon *)aFallbackIcon {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    metadataProvider = [aMetadataProvider retain];
+    artworkCache = [anArtworkCache retain];
+    fallbackIcon = [aFallbackIcon retain];
+    artworkQueue = [[NSOperationQueue alloc] init];
+    [artworkQueue setMaxConcurrentOperationCount:1];
+    titleFormatter = [[SINotificationFormatter alloc] initWithTemplate:@"{name}"];
+    bodyFormatter = [[SINotificationFormatter alloc] initWithTemplate:@"{artist}\n{album}"];
+    streamBodyFormatter = [[SINotificationFormatter alloc] initWithTemplate:@"{stream}"];
+    artworkLatencyBudget = 0.05;
+    firstNotificationLatency = calloc(1, sizeof(SILatencyHistogram));
+    artworkLatency = calloc(1, sizeof(SILatencyHistogram));
+    policy = calloc(1, sizeof(SINotificationPolicy));
+    policyClock = SIMonotonicNanoseconds;
+
+    return self;
+}
+
+- (void)dealloc {
+    [pendingFetch setDelegate:nil];
+    [artworkQueue cancelAllOperations];
+    [artworkQueue waitUntilAllOperationsAreFinished];
+    [artworkQueue release];
+    [pendingFetch release];
+    [pendingTrack release];
+    [postedTrack release];
+    [postedIconData release];
+    [metadataProvider release];
+    [artworkCache release];
+    [fallbackIcon release];
+    [sink release];
+    [publisher release];
+    [prefetcher release];
+    [history release];
+    [memoryBudget release];
+    [titleFormatter release];
+    [bodyFormatter release];
+    [streamBodyFormatter release];
+    free(firstNotificationLatency);
+    free(artworkLatency);
+    free(policy);
+
+    [super dealloc];
+}
+
+- (const SILatencyHistogram *)firstNotificationLatency {
+    return firstNotificationLatency;
+}
+
+- (const SILatencyHistogram *)artworkLatency {
+    return artworkLatency;
+}
+
+- (NSString *)latencySummary {
+    return [NSString stringWithFormat:@"first notification: %@; artwork: %@",
+        SILatencyHistogramSummary(firstNotificationLatency),
+        SILatencyHistogramSummary(artworkLatency)];
+}
+
+- (void)setPolicyRules:(const SINotificationPolicyRules *)rules {
+    policyRules = *rules;
+    SINotificationPolicyCompile(policy, &policyRules, policyClock());
+}
+
+- (void)setPolicyClock:(SIClockFunction)aPolicyClock {
+    policyClock = aPolicyClock;
+    SINotificationPolicyCompile(policy, &policyRules, policyClock());
+}
+
+- (const SINotificationPolicy *)policy {
+    return policy;
+}
+
+- (NSString *)policySummary {
+    char summary[256];
+    SINotificationPolicyFormat(policy, summary, sizeof(summary));
+
+    return [NSString stringWithUTF8String:summary];
+}
+
+- (NSUInteger)updateCount {
+    return updateCount;
+}
+
+- (NSUInteger)unchangedUpdateCount {
+    return unchangedUpdateCount;
+}
+
+- (NSString *)updateSummary {
+    return [NSString stringWithFormat:@"updates in place: %lu posted, %lu unchanged",
+        (unsigned long)updateCount,
+        (unsigned long)unchangedUpdateCount];
+}
+
+- (void)recordAppleEvents:(unsigned long long)count {
+    appleEventTrackCount++;
+    appleEventCount += count;
+
+    if (count > maximumAppleEventsPerTrack) {
+        maximumAppleEventsPerTrack = count;
+    }
+}
+
+- (unsigned long long)maximumAppleEventsPerTrack {
+    return maximumAppleEventsPerTrack;
+}
+
+- (NSString *)appleEventSummary {
+    return [NSString stringWithFormat:@"apple events: %llu for %lu tracks, %.2f per track, at most %llu",
+        appleEventCount,
+        (unsigned long)appleEventTrackCount,
+        appleEventTrackCount ? (double)appleEventCount / appleEventTrackCount : 0.0,
+        maximumAppleEventsPerTrack];
+}
+
+- (NSUInteger)formattingAllocationCount {
+    return [titleFormatter allocationCount] + [bodyFormatter allocationCount] + [streamBodyFormatter allocationCount];
+}
+
+- (SINotificationFormatter *)bodyFormatterForTrack:(SITrack *)track {
+    return [track isStream] ? streamBodyFormatter : bodyFormatter;
+}
+
+- (void)eventSource:(id<SIEventSource>)eventSource didReceivePlayerInfo:(NSDictionary *)userInfo {
+    [self processPlayerInfo:userInfo];
+}
+
+- (void)cancelPendingFetch {
+    [pendingFetch setDelegate:nil];
+    [pendingFetch cancel];
+    [pendingFetch release];
+    pendingFetch = nil;
+    [pendingTrack release];
+    pendingTrack = nil;
+}
+
+- (void)postNotificationForTrack:(SITrack *)track iconData:(NSData *)iconData receivedAt:(uint64_t)receivedAt {
+    if (!iconData) {
+        iconData = [fallbackIcon iconData];
+    }
+
+    uint64_t stageStart = SIMetricsBegin();
+    SINotification *notification = [[[SINotification alloc] init] autorelease];
+    [notification setTitle:[titleFormatter stringForUserInfo:[track userInfo]]];
+    [notification setBody:[[self bodyFormatterForTrack:track] stringForUserInfo:[track userInfo]]];
+    SIMetricsEnd(SIMetricsStageFormat, stageStart);
+    [notification setIconData:iconData];
+    [notification setIdentifier:@"Playing"];
+    [notification setTrack:track];
+    [notification setReceivedAt:receivedAt];
+    [sink postNotification:notification];
+
+    [postedTrack autorelease];
+    postedTrack = [track retain];
+    [postedIconData autorelease];
+    postedIconData = [iconData retain];
+}
+
+- (void)updateNotificationForTrack:(SITrack *)track receivedAt:(uint64_t)receivedAt {
+    // A fetch still running for the track posts the latest text with its
+    // artwork.
+    if (pendingTrack) {
+        [pendingTrack autorelease];
+        pendingTrack = [track retain];
+    }
+
+    SINotificationFormatter *trackBodyFormatter = [self bodyFormatterForTrack:track];
+
+    if (trackBodyFormatter == [self bodyFormatterForTrack:postedTrack]
+        && ![titleFormatter rendersUserInfo:[track userInfo] differentlyFromUserInfo:[postedTrack userInfo]]
+        && ![trackBodyFormatter rendersUserInfo:[track userInfo] differentlyFromUserInfo:[postedTrack userInfo]]) {
+        unchangedUpdateCount++;
+        return;
+    }
+
+    [self postNotificationForTrack:track iconData:postedIconData receivedAt:receivedAt];
+    SILatencyHistogramRecord(firstNotificationLatency, SIMonotonicNanoseconds() - receivedAt);
+    updateCount++;
+}
+
+// Every path out of here ends back in processPlayerInfo:, which frees what
+// the event left behind in one place.
+- (void)processTrack:(SITrack *)track receivedAt:(uint64_t)receivedAt {
+    uint64_t stageStart = SIMetricsBegin();
+
+    [publisher publishTrack:track];
+    [history observeTrack:track];
+
+    if (![metadataProvider isPlayerRunning] || ![track isPlaying]) {
+        SIMetricsEnd(SIMetricsStageFilter, stageStart);
+        return;
+    }
+
+    if (SINotificationPolicyEvaluate(policy,
+                                     SIPolicyKeyForString([track persistentID]),
+                                     SIPolicyKeyForString([track streamTitle]),
+                                     policyClock()) != SINotificationPolicyAllow) {
+        // Artwork still on its way for a track that is no longer playing
+        // would post a stale notification.
+        if (pendingTrack && ![[track persistentID] isEqualToString:[pendingTrack persistentID]]) {
+            [self cancelPendingFetch];
+        }
+
+        SIMetricsEnd(SIMetricsStageFilter, stageStart);
+        return;
+    }
+
+    SIMetricsEnd(SIMetricsStageFilter, stageStart);
+
+    if ([track isStream]
+        && [[track persistentID] isEqualToString:[postedTrack persistentID]]
+        && ![[track streamTitle] isEqualToString:[postedTrack streamTitle]]) {
+        [self updateNotificationForTrack:track receivedAt:receivedAt];
+        return;
+    }
+
+    [self cancelPendingFetch];
+    [prefetcher trackDidStart:track];
+
+    NSData *artworkData = nil;
+    NSDate *modificationDate = [metadataProvider modificationDateOfTrackWithPersistentID:[track persistentID]];
+    if ([artworkCache getCachedArtworkData:&artworkData forPersistentID:[track persistentID] modificationDate:modificationDate]) {
+        [self postNotificationForTrack:track iconData:artworkData receivedAt:receivedAt];
+        [self recordAppleEvents:0];
+
+        uint64_t latency = SIMonotonicNanoseconds() - receivedAt;
+        SILatencyHistogramRecord(firstNotificationLatency, latency);
+        SILatencyHistogramRecord(artworkLatency, latency);
+        return;
+    }
+
+    SIArtworkFetchOperation *fetch = [[[SIArtworkFetchOperation alloc] initWithPersistentID:[track persistentID]
+                                                                                artworkCache:artworkCache
+                                                                                    provider:metadataProvider] autorelease];
+    [fetch setDelegate:self];
+    [artworkQueue addOperation:fetch];
+
+    if ([fetch waitUntilFetchedBeforeDate:[NSDate dateWithTimeIntervalSinceNow:artworkLatencyBudget]]) {
+        [self postNotificationForTrack:track iconData:[fetch artworkData] receivedAt:receivedAt];
+        [self recordAppleEvents:[fetch appleEventCount]];
+
+        uint64_t latency = SIMonotonicNanoseconds() - receivedAt;
+        SILatencyHistogramRecord(firstNotificationLatency, latency);
+        SILatencyHistogramRecord(artworkLatency, latency);
+        return;
+    }
+
+    [self postNotificationForTrack:track iconData:nil receivedAt:receivedAt];
+    SILatencyHistogramRecord(firstNotificationLatency, SIMonotonicNanoseconds() - receivedAt);
+
+    pendingFetch = [fetch retain];
+    pendingTrack = [track retain];
+    pendingReceivedAt = receivedAt;
+}
+
+- (void)processPlayerInfo:(NSDictionary *)userInfo {
+    if (!userInfo) {
+        return;
+    }
+
+    uint64_t receivedAt = SIMonotonicNanoseconds();
+    NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+    [self processTrack:[SITrack trackWithUserInfo:userInfo] receivedAt:receivedAt];
+
+    [pool drain];
+
+    SIArena *arena = SIThreadArena();
+    if (arena) {
+        SIArenaReset(arena);
+    }
+
+    [memoryBudget enforce];
+}
+
+- (void)artworkFetchOperationDidFinish:(SIArtworkFetchOperation *)operation {
+    if (operation != pendingFetch) {
+        return;
+    }
+
+    NSData *artworkData = [operation artworkData];
+    [self recordAppleEvents:[operation appleEventCount]];
+
+    if (artworkData) {
+        [self postNotificationForTrack:pendingTrack iconData:artworkData receivedAt:pendingReceivedAt];
+        SILatencyHistogramRecord(artworkLatency, SIMonotonicNanoseconds() - pendingReceivedAt);
+    }
+
+    [self cancelPendingFetch];
+}
+
+@end
@@ -0,0 +1,59 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SINowPlayingSnapshot.h"
+#import "SITrack.h"
+#import "SIUnixSocketServer.h"
+
+// Publishes the state of every player event, playing or not, so other tools
+// need not ask iTunes themselves: into a memory-mapped snapshot that readers
+// poll without locking, and as a JSON line to every subscriber of a UNIX
+// socket, who is sent the current state as soon as it connects.
+@interface SINowPlayingPublisher : NSObject {
+    NSString *snapshotPath;
+    SINowPlayingSnapshot *snapshot;
+    SINowPlayingState state;
+    uint64_t generation;
+    SIUnixSocketServer *server;
+    NSFileHandle *listeningHandle;
+    NSData *currentLine;
+}
+
+@property (nonatomic, readonly) NSString *snapshotPath;
+@property (nonatomic, readonly) SIUnixSocketServer *server;
+
+// Either path may be nil to publish only the other way.
+- (id)initWithSnapshotPath:(NSString *)aSnapshotPath
+                socketPath:(NSString *)aSocketPath
+                     error:(NSError **)error;
+
+// Main thread only.
+- (void)publishTrack:(SITrack *)track;
+
+// The number of states published, carried over in the snapshot file across
+// restarts.
+- (uint64_t)generation;
+
+// The last state published.
+- (const SINowPlayingState *)state;
+
+@end
@@ -0,0 +1,171 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <errno.h>
+#import "SINowPlayingPublisher.h"
+
+static void SICopyField(NSString *string, char *buffer, size_t size) {
+    NSUInteger usedLength = 0;
+
+    [string getBytes:buffer
+           maxLength:size - 1
+          usedLength:&usedLength
+            encoding:NSUTF8StringEncoding
+             options:0
+               range:NSMakeRange(0, [string length])
+      remainingRange:NULL];
+    buffer[usedLength] = '\0';
+}
+
+static NSString *SIStringField(const char *buffer) {
+    return [NSString stringWithUTF8String:buffer];
+}
+
+@implementation SINowPlayingPublisher
+
+@synthesize snapshotPath;
+@synthesize server;
+
+- (id)init {
+    return [self initWithSnapshotPath:nil socketPath:nil error:NULL];
+}
+
+- (id)initWithSnapshotPath:(NSString *)aSnapshotPath
+                socketPath:(NSString *)aSocketPath
+                     error:(NSError **)error {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    snapshotPath = [aSnapshotPath copy];
+    memset(&state, 0, sizeof(state));
+
+    if (snapshotPath) {
+        snapshot = SINowPlayingSnapshotMap([snapshotPath fileSystemRepresentation], 1);
+        if (!snapshot) {
+            if (error) {
+                *error = SIPOSIXError(errno);
+            }
+
+            [self release];
+            return nil;
+        }
+    }
+
+    if (aSocketPath) {
+        server = [[SIUnixSocketServer alloc] initWithPath:aSocketPath error:error];
+        if (!server) {
+            [self release];
+            return nil;
+        }
+
+        listeningHandle = [[NSFileHandle alloc] initWithFileDescriptor:[server fileDescriptor] closeOnDealloc:NO];
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(clientsDidConnect:)
+                                                     name:NSFileHandleDataAvailableNotification
+                                                   object:listeningHandle];
+        [listeningHandle waitForDataInBackgroundAndNotify];
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    [listeningHandle release];
+    [server close];
+    [server release];
+    SINowPlayingSnapshotUnmap(snapshot);
+    [snapshotPath release];
+    [currentLine release];
+
+    [super dealloc];
+}
+
+- (uint64_t)generation {
+    return generation;
+}
+
+- (const SINowPlayingState *)state {
+    return &state;
+}
+
+- (NSData *)currentStateLine {
+    NSDictionary *dictionary = @{
+        @"generation"   : @(generation),
+        @"updatedAt"    : @(state.updatedAt),
+        @"totalTime"    : @(state.totalTime),
+        @"persistentID" : SIStringField(state.persistentID),
+        @"playerState"  : SIStringField(state.playerState),
+        @"name"         : SIStringField(state.name),
+        @"artist"       : SIStringField(state.artist),
+        @"album"        : SIStringField(state.album)
+    };
+    NSMutableData *line = [NSMutableData dataWithData:[NSJSONSerialization dataWithJSONObject:dictionary
+                                                                                      options:0
+                                                                                        error:NULL]];
+    [line appendBytes:"\n" length:1];
+
+    return line;
+}
+
+- (void)publishTrack:(SITrack *)track {
+    state.updatedAt = (uint64_t)([[NSDate date] timeIntervalSince1970] * 1000);
+    state.totalTime = [[[track userInfo] objectForKey:@"Total Time"] unsignedLongLongValue];
+    SICopyField([track persistentID], state.persistentID, sizeof(state.persistentID));
+    SICopyField([track playerState], state.playerState, sizeof(state.playerState));
+    SICopyField([track name], state.name, sizeof(state.name));
+    SICopyField([track artist], state.artist, sizeof(state.artist));
+    SICopyField([track album], state.album, sizeof(state.album));
+
+    if (snapshot) {
+        SINowPlayingSnapshotWrite(snapshot, &state);
+        generation = atomic_load(&snapshot->sequence) / 2;
+    } else {
+        generation++;
+    }
+
+    if (server) {
+        [currentLine release];
+        currentLine = [[self currentStateLine] retain];
+        [server acceptPendingClients];
+        [server broadcastData:currentLine];
+    }
+}
+
+- (void)clientsDidConnect:(NSNotification *)notification {
+    NSIndexSet *clientSockets = [server acceptPendingClients];
+
+    if (currentLine) {
+        NSUInteger clientSocket = [clientSockets firstIndex];
+        while (clientSocket != NSNotFound) {
+            [server sendData:currentLine toClient:(int)clientSocket];
+            clientSocket = [clientSockets indexGreaterThanIndex:clientSocket];
+        }
+    }
+
+    [listeningHandle waitForDataInBackgroundAndNotify];
+}
+
+@end
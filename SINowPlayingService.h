@@ -0,0 +1,101 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIArtworkCache.h"
+#import "SIArtworkNormalizer.h"
+#import "SIEventCoalescer.h"
+#import "SIFallbackIcon.h"
+#import "SIMemoryBudget.h"
+#import "SIMetadataProvider.h"
+#import "SINotificationDispatcher.h"
+#import "SINowPlayingPipeline.h"
+#import "SIPlayHistory.h"
+#import "SISingleInstance.h"
+
+// Assembles the stages every notifier shares from the user defaults: the
+// artwork normalizer, cache and fallback icon, the pipeline, and the
+// coalescer in front of the event source, the dispatcher that fans
+// notifications out to the sinks, and the memory budget the caches share.
+// Notifiers supply the metadata provider, the
+// event source and their platform sinks; the socket and log sinks are added
+// here when they are named in the Sinks default.
+@interface SINowPlayingService : NSObject <SISingleInstanceDelegate> {
+    id<SIMetadataProvider> metadataProvider;
+    SIArtworkNormalizer *artworkNormalizer;
+    SIArtworkCache *artworkCache;
+    SIFallbackIcon *fallbackIcon;
+    SINowPlayingPipeline *pipeline;
+    SIEventCoalescer *eventCoalescer;
+    SINotificationDispatcher *dispatcher;
+    SINowPlayingPublisher *publisher;
+    SIArtworkPrefetcher *prefetcher;
+    SIPlayHistory *history;
+    SIMemoryBudget *memoryBudget;
+    NSFileHandle *dumpSignalHandle;
+    BOOL startupProfiled;
+}
+
+@property (nonatomic, readonly) id<SIMetadataProvider> metadataProvider;
+@property (nonatomic, readonly) SIArtworkCache *artworkCache;
+@property (nonatomic, readonly) SIFallbackIcon *fallbackIcon;
+@property (nonatomic, readonly) SINowPlayingPipeline *pipeline;
+@property (nonatomic, readonly) SIEventCoalescer *eventCoalescer;
+@property (nonatomic, readonly) SINotificationDispatcher *dispatcher;
+@property (nonatomic, readonly) SINowPlayingPublisher *publisher;
+@property (nonatomic, readonly) SIArtworkPrefetcher *prefetcher;
+@property (nonatomic, readonly) SIPlayHistory *history;
+@property (nonatomic, readonly) SIMemoryBudget *memoryBudget;
+
+// Artwork is cached on disk under artworkDirectory, or only in memory when it
+// is nil.
+- (id)initWithMetadataProvider:(id<SIMetadataProvider>)aMetadataProvider
+                   eventSource:(id<SIEventSource>)anEventSource
+              artworkDirectory:(NSString *)anArtworkDirectory;
+
+// Applies the settings that can change while running: the coalescing
+// interval, the artwork latency budget, the title and body formats and the
+// prefetch, history, metrics and memory budget settings.
+- (void)reloadDefaults;
+
+// The current track and the statistics, as printed by a second launch given
+// "status". A second launch may also send "reload" to reread the user
+// defaults, and -Key value pairs to override them as on the command line.
+- (NSString *)statusDescription;
+
+// The stage timings and counters, as printed by a second launch given
+// "metrics" and logged on SIGUSR1. Writes the trace to MetricsTracePath
+// when it is set.
+- (NSString *)metricsDescription;
+
+// Whether the sink called name is enabled by the Sinks default.
+- (BOOL)isSinkEnabled:(NSString *)name;
+
+// Queues notifications for sink on its own thread, sized by the SinkQueues
+// entry for name or else by SinkQueueCapacity and SinkQueuePolicy.
+- (SISinkQueue *)addSink:(id<SINotificationSink>)sink name:(NSString *)name;
+
+// The first start marks the process ready in the startup profile, and idle
+// a few seconds later.
+- (void)start;
+- (void)stop;
+
+@end
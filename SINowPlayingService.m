@@ -0,0 +1,460 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <errno.h>
+#import <fcntl.h>
+#import <signal.h>
+#import <string.h>
+#import <unistd.h>
+#import "SINowPlayingService.h"
+#import "SIDefaults.h"
+#import "SIEventRecorder.h"
+#import "SIFileLogNotificationSink.h"
+#import "SIMetrics.h"
+#import "SISocketNotificationSink.h"
+#import "SIStartupProfile.h"
+
+static const NSTimeInterval SIStartupSettleInterval = 5;
+
+// SIGUSR1 only writes a byte here; the run loop does the dumping.
+static int SIDumpSignalPipe[2] = { -1, -1 };
+
+static void SIDumpSignalHandler(int signalNumber) {
+    int savedErrno = errno;
+    char byte = 0;
+
+    write(SIDumpSignalPipe[1], &byte, 1);
+    errno = savedErrno;
+}
+
+@implementation SINowPlayingService
+
+@synthesize metadataProvider;
+@synthesize artworkCache;
+@synthesize fallbackIcon;
+@synthesize pipeline;
+@synthesize eventCoalescer;
+@synthesize dispatcher;
+@synthesize publisher;
+@synthesize prefetcher;
+@synthesize history;
+@synthesize memoryBudget;
+
+- (id)initWithMetadataProvider:(id<SIMetadataProvider>)aMetadataProvider
+                   eventSource:(id<SIEventSource>)anEventSource
+              artworkDirectory:(NSString *)anArtworkDirectory {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    SIRegisterDefaults();
+    NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+
+    metadataProvider = [aMetadataProvider retain];
+
+    artworkNormalizer = [[SIArtworkNormalizer alloc] initWithIconSize:[userDefaults integerForKey:@"ArtworkIconSize"]
+                                                           byteBudget:[userDefaults integerForKey:@"ArtworkByteBudget"]];
+    artworkCache = [[SIArtworkCache alloc] initWithProvider:metadataProvider
+                                                  directory:anArtworkDirectory
+                                                   capacity:64];
+    [artworkCache setNormalizer:artworkNormalizer];
+    fallbackIcon = [[SIFallbackIcon alloc] initWithMetadataProvider:metadataProvider
+                                                         normalizer:artworkNormalizer];
+
+    pipeline = [[SINowPlayingPipeline alloc] initWithMetadataProvider:metadataProvider
+                                                         artworkCache:artworkCache
+                                                         fallbackIcon:fallbackIcon];
+
+    memoryBudget = [[SIMemoryBudget alloc] init];
+    [memoryBudget addConsumer:artworkCache];
+    [pipeline setMemoryBudget:memoryBudget];
+
+    NSString *recordingPath = [[userDefaults stringForKey:@"RecordEventsPath"] stringByExpandingTildeInPath];
+    if ([recordingPath length]) {
+        NSError *recordingError = nil;
+        SIEventRecorder *eventRecorder = [[[SIEventRecorder alloc] initWithEventSource:anEventSource
+                                                                                   path:recordingPath
+                                                                                  error:&recordingError] autorelease];
+        if (eventRecorder) {
+            anEventSource = eventRecorder;
+        } else {
+            NSLog(@"Cannot record events to %@: %@", recordingPath, recordingError);
+        }
+    }
+
+    prefetcher = [[SIArtworkPrefetcher alloc] initWithMetadataProvider:metadataProvider
+                                                          artworkCache:artworkCache];
+    [pipeline setPrefetcher:prefetcher];
+
+    NSString *historyDirectory = [[userDefaults stringForKey:@"HistoryDirectory"] stringByExpandingTildeInPath];
+    if ([historyDirectory length]) {
+        NSError *historyError = nil;
+        SIPlayJournal *journal = [[[SIPlayJournal alloc] initWithDirectory:historyDirectory error:&historyError] autorelease];
+
+        if (journal) {
+            history = [[SIPlayHistory alloc] initWithJournal:journal];
+            [pipeline setHistory:history];
+        } else {
+            NSLog(@"Cannot keep the play history in %@: %@", historyDirectory, historyError);
+        }
+
+        NSString *scrobbleURL = [userDefaults stringForKey:@"ScrobbleURL"];
+        if (journal && [scrobbleURL length]) {
+            SIScrobbleQueue *scrobbleQueue = [[[SIScrobbleQueue alloc] initWithJournal:journal
+                                                                                   URL:[NSURL URLWithString:scrobbleURL]
+                                                                            cursorPath:[historyDirectory stringByAppendingPathComponent:@"Scrobble.cursor"]] autorelease];
+            [history setScrobbleQueue:scrobbleQueue];
+        }
+    }
+
+    eventCoalescer = [[SIEventCoalescer alloc] initWithEventSource:anEventSource
+                                                     quietInterval:[userDefaults doubleForKey:@"CoalescingInterval"]];
+    [eventCoalescer setDelegate:pipeline];
+
+    dispatcher = [[SINotificationDispatcher alloc] init];
+    [pipeline setSink:dispatcher];
+    [self reloadDefaults];
+    [self installDumpSignalHandler];
+    [history compact];
+
+    NSError *error = nil;
+
+    NSString *snapshotPath = [[userDefaults stringForKey:@"NowPlayingSnapshotPath"] stringByExpandingTildeInPath];
+    NSString *nowPlayingSocketPath = [[userDefaults stringForKey:@"NowPlayingSocketPath"] stringByExpandingTildeInPath];
+    if ([snapshotPath length] || [nowPlayingSocketPath length]) {
+        publisher = [[SINowPlayingPublisher alloc] initWithSnapshotPath:([snapshotPath length] ? snapshotPath : nil)
+                                                             socketPath:([nowPlayingSocketPath length] ? nowPlayingSocketPath : nil)
+                                                                  error:&error];
+        if (publisher) {
+            [pipeline setPublisher:publisher];
+        } else {
+            NSLog(@"Cannot publish now playing state: %@", error);
+        }
+    }
+
+    if ([self isSinkEnabled:@"Socket"]) {
+        NSString *socketPath = [[userDefaults stringForKey:@"SocketPath"] stringByExpandingTildeInPath];
+        SISocketNotificationSink *socketSink = [[[SISocketNotificationSink alloc] initWithPath:socketPath
+                                                                                         error:&error] autorelease];
+        if (socketSink) {
+            [self addSink:socketSink name:@"Socket"];
+        } else {
+            NSLog(@"Cannot listen on %@: %@", socketPath, error);
+        }
+    }
+
+    if ([self isSinkEnabled:@"Log"]) {
+        NSString *logPath = [[userDefaults stringForKey:@"LogPath"] stringByExpandingTildeInPath];
+        SIFileLogNotificationSink *logSink = [[[SIFileLogNotificationSink alloc] initWithPath:logPath
+                                                                                        error:&error] autorelease];
+        if (logSink) {
+            [self addSink:logSink name:@"Log"];
+        } else {
+            NSLog(@"Cannot open %@: %@", logPath, error);
+        }
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    [dumpSignalHandle release];
+    [eventCoalescer stop];
+    [eventCoalescer release];
+    [dispatcher stop];
+    [dispatcher release];
+    [pipeline release];
+    [publisher release];
+    [prefetcher cancel];
+    [prefetcher release];
+    [history stop];
+    [[history scrobbleQueue] stop];
+    [history release];
+    [memoryBudget release];
+    [fallbackIcon release];
+    [artworkCache release];
+    [artworkNormalizer release];
+    [metadataProvider release];
+
+    [super dealloc];
+}
+
+- (void)reloadDefaults {
+    NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+
+    [eventCoalescer setQuietInterval:[userDefaults doubleForKey:@"CoalescingInterval"]];
+    [eventCoalescer setMaximumDelay:[userDefaults doubleForKey:@"CoalescingMaximumDelay"]];
+    [pipeline setArtworkLatencyBudget:[userDefaults doubleForKey:@"ArtworkLatencyBudget"]];
+    [pipeline setTitleFormatter:[SINotificationFormatter formatterWithTemplate:[userDefaults stringForKey:@"TitleFormat"]]];
+    [pipeline setBodyFormatter:[SINotificationFormatter formatterWithTemplate:[userDefaults stringForKey:@"BodyFormat"]]];
+    [pipeline setStreamBodyFormatter:[SINotificationFormatter formatterWithTemplate:[userDefaults stringForKey:@"StreamBodyFormat"]]];
+
+    SINotificationPolicyRules policyRules = {
+        .duplicateInterval = [userDefaults doubleForKey:@"DuplicateInterval"],
+        .notificationsPerMinute = [userDefaults doubleForKey:@"NotificationsPerMinute"],
+        .streamTitleInterval = [userDefaults doubleForKey:@"StreamTitleInterval"]
+    };
+    [pipeline setPolicyRules:&policyRules];
+
+    [prefetcher setTrackCount:[userDefaults integerForKey:@"PrefetchTrackCount"]];
+    [prefetcher setDelay:[userDefaults doubleForKey:@"PrefetchDelay"]];
+    [prefetcher setByteLimit:[userDefaults integerForKey:@"PrefetchByteLimit"]];
+    [history setSynchronizeBatchSize:[userDefaults integerForKey:@"HistorySyncBatchSize"]];
+    [history setSynchronizeInterval:[userDefaults doubleForKey:@"HistorySyncInterval"]];
+    [history setRetentionInterval:[userDefaults doubleForKey:@"HistoryRetentionDays"] * 24 * 60 * 60];
+    [[history scrobbleQueue] setBatchSize:[userDefaults integerForKey:@"ScrobbleBatchSize"]];
+    [[history scrobbleQueue] setFlushInterval:[userDefaults doubleForKey:@"ScrobbleInterval"]];
+    [memoryBudget setByteLimit:[userDefaults integerForKey:@"MemoryBudget"]];
+
+    if ([[userDefaults stringForKey:@"MetricsTracePath"] length]) {
+        SIMetricsSetLevel(SIMetricsTracing);
+    } else {
+        SIMetricsSetLevel([userDefaults boolForKey:@"Metrics"] ? SIMetricsOn : SIMetricsOff);
+    }
+}
+
+- (void)installDumpSignalHandler {
+    if (SIDumpSignalPipe[0] < 0) {
+        if (pipe(SIDumpSignalPipe) != 0) {
+            NSLog(@"Cannot dump metrics on SIGUSR1: %s", strerror(errno));
+            return;
+        }
+
+        for (int i = 0; i < 2; i++) {
+            fcntl(SIDumpSignalPipe[i], F_SETFL, fcntl(SIDumpSignalPipe[i], F_GETFL) | O_NONBLOCK);
+            fcntl(SIDumpSignalPipe[i], F_SETFD, FD_CLOEXEC);
+        }
+
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = SIDumpSignalHandler;
+        action.sa_flags = SA_RESTART;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGUSR1, &action, NULL);
+    }
+
+    dumpSignalHandle = [[NSFileHandle alloc] initWithFileDescriptor:SIDumpSignalPipe[0] closeOnDealloc:NO];
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(dumpSignalDidArrive:)
+                                                 name:NSFileHandleDataAvailableNotification
+                                               object:dumpSignalHandle];
+    [dumpSignalHandle waitForDataInBackgroundAndNotify];
+}
+
+- (void)dumpSignalDidArrive:(NSNotification *)notification {
+    char bytes[64];
+
+    while (read(SIDumpSignalPipe[0], bytes, sizeof(bytes)) > 0) {
+    }
+
+    fputs([[self metricsDescription] UTF8String], stderr);
+    [dumpSignalHandle waitForDataInBackgroundAndNotify];
+}
+
+- (NSString *)metricsDescription {
+    char buffer[2048];
+    SIMetricsFormat(buffer, sizeof(buffer));
+
+    NSMutableString *description = [NSMutableString stringWithUTF8String:buffer];
+    NSString *tracePath = [[[NSUserDefaults standardUserDefaults] stringForKey:@"MetricsTracePath"] stringByExpandingTildeInPath];
+
+    if ([tracePath length]) {
+        FILE *file = fopen([tracePath fileSystemRepresentation], "w");
+
+        if (file && SIMetricsWriteTrace(file) == 0) {
+            [description appendFormat:@"trace written to %@\n", tracePath];
+        } else {
+            [description appendFormat:@"cannot write trace to %@: %s\n", tracePath, strerror(errno)];
+        }
+
+        if (file) {
+            fclose(file);
+        }
+    }
+
+    return description;
+}
+
+- (NSString *)statusDescription {
+    NSMutableString *status = [NSMutableString stringWithFormat:@"pid %d\n", (int)getpid()];
+
+    if ([publisher generation]) {
+        const SINowPlayingState *state = [publisher state];
+        [status appendFormat:@"%s: %s - %s\n", state->playerState, state->artist, state->name];
+    }
+
+    char profile[512];
+    SIStartupProfileFormat(profile, sizeof(profile));
+    [status appendFormat:@"%s\n", profile];
+
+    [status appendFormat:@"events: %lu received, %lu delivered, %lu merged, %lu dropped\n",
+        (unsigned long)[eventCoalescer receivedCount],
+        (unsigned long)[eventCoalescer deliveredCount],
+        (unsigned long)[eventCoalescer mergedCount],
+        (unsigned long)[eventCoalescer droppedCount]];
+    [status appendFormat:@"%@\n", [pipeline policySummary]];
+    [status appendFormat:@"%@\n", [pipeline updateSummary]];
+    [status appendFormat:@"%@\n", [pipeline latencySummary]];
+    [status appendFormat:@"%@\n", [prefetcher statisticsSummary]];
+    [status appendFormat:@"%@\n", [[artworkCache store] statisticsSummary]];
+    [status appendFormat:@"%@\n", [pipeline appleEventSummary]];
+    [status appendFormat:@"%@\n", [memoryBudget statisticsSummary]];
+
+    if (history) {
+        [status appendFormat:@"%@\n", [history statisticsSummary]];
+    }
+
+    if ([history scrobbleQueue]) {
+        [status appendFormat:@"%@\n", [[history scrobbleQueue] statisticsSummary]];
+    }
+
+    if ([[dispatcher queues] count]) {
+        [status appendFormat:@"%@\n", [dispatcher statisticsSummary]];
+    }
+
+    return status;
+}
+
+- (NSString *)singleInstance:(SISingleInstance *)singleInstance replyToArguments:(NSArray *)arguments {
+    NSMutableDictionary *settings = [NSMutableDictionary dictionary];
+    NSMutableArray *commands = [NSMutableArray array];
+
+    // -Key value pairs are applied as if the daemon had been started with them.
+    for (NSUInteger i = 0; i < [arguments count]; i++) {
+        NSString *argument = [[arguments objectAtIndex:i] description];
+
+        if (![argument hasPrefix:@"-"]) {
+            [commands addObject:argument];
+        } else if ([argument length] > 1 && i + 1 < [arguments count]) {
+            NSString *value = [[arguments objectAtIndex:++i] description];
+            id propertyList = nil;
+
+            @try {
+                propertyList = [value propertyList];
+            } @catch (NSException *exception) {
+            }
+
+            [settings setObject:(propertyList ? propertyList : value) forKey:[argument substringFromIndex:1]];
+        }
+    }
+
+    if ([settings count]) {
+        NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+        NSMutableDictionary *argumentDomain = [NSMutableDictionary dictionaryWithDictionary:[userDefaults volatileDomainForName:NSArgumentDomain]];
+
+        [argumentDomain addEntriesFromDictionary:settings];
+        [userDefaults removeVolatileDomainForName:NSArgumentDomain];
+        [userDefaults setVolatileDomain:argumentDomain forName:NSArgumentDomain];
+        [self reloadDefaults];
+    }
+
+    NSString *command = [commands count] ? [commands objectAtIndex:0] : nil;
+
+    if ([command isEqualToString:@"reload"]) {
+        [[NSUserDefaults standardUserDefaults] synchronize];
+        [self reloadDefaults];
+        return @"reloaded\n";
+    }
+
+    if ([command isEqualToString:@"status"]) {
+        return [self statusDescription];
+    }
+
+    if ([command isEqualToString:@"metrics"]) {
+        return [self metricsDescription];
+    }
+
+    if (command) {
+        return [NSString stringWithFormat:@"unknown command: %@ (try status, metrics or reload)\n", command];
+    }
+
+    if ([settings count]) {
+        return @"reloaded\n";
+    }
+
+    return [NSString stringWithFormat:@"already running as pid %d\n", (int)getpid()];
+}
+
+- (BOOL)isSinkEnabled:(NSString *)name {
+    return [[[NSUserDefaults standardUserDefaults] arrayForKey:@"Sinks"] containsObject:name];
+}
+
+- (SISinkQueue *)addSink:(id<SINotificationSink>)sink name:(NSString *)name {
+    NSUserDefaults *userDefaults = [NSUserDefaults standardUserDefaults];
+    NSDictionary *settings = [[userDefaults dictionaryForKey:@"SinkQueues"] objectForKey:name];
+    id capacity = [settings objectForKey:@"Capacity"];
+    id policy = [settings objectForKey:@"Policy"];
+
+    if (!capacity) {
+        capacity = [userDefaults objectForKey:@"SinkQueueCapacity"];
+    }
+
+    if (!policy) {
+        policy = [userDefaults stringForKey:@"SinkQueuePolicy"];
+    }
+
+    return [dispatcher addSink:sink
+                          name:name
+                      capacity:[capacity unsignedIntegerValue]
+                        policy:SISinkQueuePolicyFromString(policy)];
+}
+
+- (void)start {
+    [eventCoalescer start];
+
+    if (!startupProfiled) {
+        startupProfiled = YES;
+        SIStartupProfileMark("ready");
+        [self performSelector:@selector(startupDidSettle) withObject:nil afterDelay:SIStartupSettleInterval];
+    }
+}
+
+// Records the idle footprint once startup work has died down. With
+// ProfileStartup set, prints the profile and exits, for timing launches.
+- (void)startupDidSettle {
+    char profile[512];
+
+    SIStartupProfileMark("idle");
+    SIStartupProfileFormat(profile, sizeof(profile));
+
+    if ([[NSUserDefaults standardUserDefaults] boolForKey:@"ProfileStartup"]) {
+        printf("%s\n", profile);
+        exit(0);
+    }
+
+    NSLog(@"%s", profile);
+}
+
+- (void)stop {
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(startupDidSettle) object:nil];
+    [eventCoalescer stop];
+    [prefetcher cancel];
+    [history stop];
+    [[history scrobbleQueue] flush];
+    [[history scrobbleQueue] waitUntilIdle];
+    [dispatcher stop];
+}
+
+@end
@@ -0,0 +1,135 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "SINowPlayingSnapshot.h"
+
+SINowPlayingSnapshot *SINowPlayingSnapshotMap(const char *path, int writable) {
+    int flags = (writable ? O_RDWR | O_CREAT : O_RDONLY) | O_NOFOLLOW | O_CLOEXEC;
+    int fileDescriptor = open(path, flags, 0644);
+    struct stat status;
+
+    if (fileDescriptor < 0) {
+        return NULL;
+    }
+
+    if (fstat(fileDescriptor, &status) != 0) {
+        int error = errno;
+        close(fileDescriptor);
+        errno = error;
+        return NULL;
+    }
+
+    if (!S_ISREG(status.st_mode) || status.st_uid != geteuid() || status.st_nlink != 1) {
+        close(fileDescriptor);
+        errno = EPERM;
+        return NULL;
+    }
+
+    if (writable && ftruncate(fileDescriptor, sizeof(SINowPlayingSnapshot)) != 0) {
+        int error = errno;
+        close(fileDescriptor);
+        errno = error;
+        return NULL;
+    }
+
+    if (writable) {
+        status.st_size = sizeof(SINowPlayingSnapshot);
+    }
+
+    if ((size_t)status.st_size < sizeof(SINowPlayingSnapshot)) {
+        close(fileDescriptor);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    SINowPlayingSnapshot *snapshot = mmap(NULL, sizeof(SINowPlayingSnapshot),
+                                          writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                                          MAP_SHARED, fileDescriptor, 0);
+    int error = errno;
+    close(fileDescriptor);
+
+    if (snapshot == MAP_FAILED) {
+        errno = error;
+        return NULL;
+    }
+
+    if (writable && (snapshot->magic != SINowPlayingSnapshotMagic
+                     || snapshot->version != SINowPlayingSnapshotVersion)) {
+        memset(snapshot, 0, sizeof(SINowPlayingSnapshot));
+        snapshot->magic = SINowPlayingSnapshotMagic;
+        snapshot->version = SINowPlayingSnapshotVersion;
+    } else if (snapshot->magic != SINowPlayingSnapshotMagic
+               || snapshot->version != SINowPlayingSnapshotVersion) {
+        munmap(snapshot, sizeof(SINowPlayingSnapshot));
+        errno = EINVAL;
+        return NULL;
+    }
+
+    return snapshot;
+}
+
+void SINowPlayingSnapshotUnmap(SINowPlayingSnapshot *snapshot) {
+    if (snapshot) {
+        munmap(snapshot, sizeof(SINowPlayingSnapshot));
+    }
+}
+
+void SINowPlayingSnapshotWrite(SINowPlayingSnapshot *snapshot, const SINowPlayingState *state) {
+    uint64_t sequence = atomic_load_explicit(&snapshot->sequence, memory_order_relaxed);
+
+    // A writer that died mid-update leaves sequence odd; start a fresh one.
+    sequence &= ~(uint64_t)1;
+
+    atomic_store_explicit(&snapshot->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(&snapshot->state, state, sizeof(SINowPlayingState));
+    atomic_store_explicit(&snapshot->sequence, sequence + 2, memory_order_release);
+}
+
+int SINowPlayingSnapshotRead(const SINowPlayingSnapshot *snapshot, SINowPlayingState *state, uint64_t *generation) {
+    SINowPlayingSnapshot *shared = (SINowPlayingSnapshot *)snapshot;
+
+    for (int attempt = 0; attempt < SINowPlayingSnapshotReadAttempts; attempt++) {
+        uint64_t before = atomic_load_explicit(&shared->sequence, memory_order_acquire);
+        memcpy(state, &shared->state, sizeof(SINowPlayingState));
+        atomic_thread_fence(memory_order_acquire);
+        uint64_t after = atomic_load_explicit(&shared->sequence, memory_order_relaxed);
+
+        if (!(before & 1) && before == after) {
+            if (generation) {
+                *generation = before / 2;
+            }
+
+            return 0;
+        }
+    }
+
+    errno = EAGAIN;
+
+    return -1;
+}
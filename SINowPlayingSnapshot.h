@@ -0,0 +1,75 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef SINOWPLAYINGSNAPSHOT_H
+#define SINOWPLAYINGSNAPSHOT_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define SINowPlayingSnapshotMagic 0x504e5349u
+#define SINowPlayingSnapshotVersion 1
+
+// The current track, as published. Strings are NUL-terminated UTF-8,
+// truncated at a character boundary; times are in milliseconds.
+typedef struct SINowPlayingState {
+    uint64_t updatedAt;
+    uint64_t totalTime;
+    char persistentID[24];
+    char playerState[24];
+    char name[256];
+    char artist[256];
+    char album[256];
+} SINowPlayingState;
+
+// The layout of the snapshot file. The writer makes sequence odd while it
+// copies state in and even again when it is done, so readers retry instead
+// of ever blocking it; sequence / 2 counts the updates published so far.
+typedef struct SINowPlayingSnapshot {
+    uint32_t magic;
+    uint32_t version;
+    _Atomic uint64_t sequence;
+    SINowPlayingState state;
+} SINowPlayingSnapshot;
+
+// How many times a read copies the state before giving up on a writer that
+// never finishes, as when it died mid-update.
+#define SINowPlayingSnapshotReadAttempts 65536
+
+// Maps the snapshot file at path, creating it when writable. Returns NULL and
+// sets errno on failure, or if a read-only file has an unknown layout. The
+// path may not be a symbolic link, and the file must be a regular file this
+// user owns, so that a file planted in a shared temporary directory is
+// neither written through nor trusted.
+SINowPlayingSnapshot *SINowPlayingSnapshotMap(const char *path, int writable);
+void SINowPlayingSnapshotUnmap(SINowPlayingSnapshot *snapshot);
+
+// Single writer only.
+void SINowPlayingSnapshotWrite(SINowPlayingSnapshot *snapshot, const SINowPlayingState *state);
+
+// Copies a consistent state out and stores its generation, if asked for;
+// zero means nothing has been published yet. Returns 0, or -1 with errno
+// set to EAGAIN if no consistent copy came out of
+// SINowPlayingSnapshotReadAttempts tries.
+int SINowPlayingSnapshotRead(const SINowPlayingSnapshot *snapshot, SINowPlayingState *state, uint64_t *generation);
+
+#endif
@@ -0,0 +1,69 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIPlayJournal.h"
+#import "SIScrobbleQueue.h"
+#import "SITrack.h"
+
+// Turns player events into plays. A play starts when a track starts playing
+// and ends when another track starts or the player stops; pauses do not end
+// it, and only the time spent playing counts. Plays are appended to the
+// journal as they end, which only buffers them; the journal is synchronized
+// on a background queue once synchronizeBatchSize plays are buffered or
+// every synchronizeInterval, and compacted there on start and daily, keeping
+// retentionInterval of history and whatever is not yet scrobbled. Main
+// thread only.
+@interface SIPlayHistory : NSObject {
+    SIPlayJournal *journal;
+    SIScrobbleQueue *scrobbleQueue;
+    NSOperationQueue *journalQueue;
+    NSTimer *synchronizeTimer;
+    NSTimer *compactionTimer;
+    NSUInteger synchronizeBatchSize;
+    NSTimeInterval synchronizeInterval;
+    NSTimeInterval retentionInterval;
+    SITrack *currentTrack;
+    uint64_t currentStartedAt;
+    uint64_t currentPlayedTime;
+    uint64_t currentResumedAt;
+}
+
+@property (nonatomic, readonly) SIPlayJournal *journal;
+@property (nonatomic, retain) SIScrobbleQueue *scrobbleQueue;
+@property (nonatomic, assign) NSUInteger synchronizeBatchSize;
+@property (nonatomic, assign) NSTimeInterval synchronizeInterval;
+@property (nonatomic, assign) NSTimeInterval retentionInterval;
+
+- (id)initWithJournal:(SIPlayJournal *)aJournal;
+
+// Called for every player event, playing or not.
+- (void)observeTrack:(SITrack *)track;
+
+// Queues a compaction; one also runs every day.
+- (void)compact;
+
+// Ends the current play, synchronizes and waits for the journal queue.
+- (void)stop;
+
+- (NSString *)statisticsSummary;
+
+@end
@@ -0,0 +1,237 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <stdlib.h>
+#import "SIPlayHistory.h"
+#import "SIClock.h"
+
+static const NSTimeInterval SIPlayHistoryCompactionInterval = 24 * 60 * 60;
+
+static uint64_t SIMillisecondsSince1970(void) {
+    return (uint64_t)([[NSDate date] timeIntervalSince1970] * 1000);
+}
+
+@implementation SIPlayHistory
+
+@synthesize journal;
+@synthesize scrobbleQueue;
+@synthesize synchronizeBatchSize;
+@synthesize synchronizeInterval;
+@synthesize retentionInterval;
+
+- (id)init {
+    return [self initWithJournal:nil];
+}
+
+- (id)initWithJournal:(SIPlayJournal *)aJournal {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    journal = [aJournal retain];
+    journalQueue = [[NSOperationQueue alloc] init];
+    [journalQueue setMaxConcurrentOperationCount:1];
+    synchronizeBatchSize = 32;
+
+    compactionTimer = [[NSTimer scheduledTimerWithTimeInterval:SIPlayHistoryCompactionInterval
+                                                        target:self
+                                                      selector:@selector(compactionTimerDidFire:)
+                                                      userInfo:nil
+                                                       repeats:YES] retain];
+
+    return self;
+}
+
+- (void)dealloc {
+    [synchronizeTimer invalidate];
+    [synchronizeTimer release];
+    [compactionTimer invalidate];
+    [compactionTimer release];
+    [journalQueue waitUntilAllOperationsAreFinished];
+    [journalQueue release];
+    [journal release];
+    [scrobbleQueue release];
+    [currentTrack release];
+
+    [super dealloc];
+}
+
+- (void)setSynchronizeInterval:(NSTimeInterval)aSynchronizeInterval {
+    synchronizeInterval = aSynchronizeInterval;
+
+    [synchronizeTimer invalidate];
+    [synchronizeTimer release];
+    synchronizeTimer = nil;
+
+    if (synchronizeInterval > 0) {
+        synchronizeTimer = [[NSTimer scheduledTimerWithTimeInterval:synchronizeInterval
+                                                             target:self
+                                                           selector:@selector(synchronizeTimerDidFire:)
+                                                           userInfo:nil
+                                                            repeats:YES] retain];
+    }
+}
+
+#pragma mark - Plays
+
+- (void)finishCurrentPlayAt:(uint64_t)now {
+    if (!currentTrack) {
+        return;
+    }
+
+    if (currentResumedAt) {
+        currentPlayedTime += now - currentResumedAt;
+    }
+
+    // Rounded up, so that no play that happened is taken for none.
+    uint64_t playedTime = (currentPlayedTime + 999999) / 1000000;
+
+    if (playedTime) {
+        NSUInteger pendingCount = [journal appendPlayWithPersistentID:strtoull([[currentTrack persistentID] UTF8String], NULL, 16)
+                                                                 name:[currentTrack name]
+                                                               artist:[currentTrack artist]
+                                                                album:[currentTrack album]
+                                                            startedAt:currentStartedAt
+                                                           playedTime:(uint32_t)MIN(playedTime, (uint64_t)UINT32_MAX)];
+
+        if (pendingCount >= synchronizeBatchSize) {
+            [self synchronize];
+        }
+    }
+
+    [currentTrack release];
+    currentTrack = nil;
+}
+
+- (void)observeTrack:(SITrack *)track {
+    uint64_t now = SIMonotonicNanoseconds();
+
+    if (currentTrack && [[track persistentID] isEqualToString:[currentTrack persistentID]]) {
+        if ([track isPlaying]) {
+            if (!currentResumedAt) {
+                currentResumedAt = now;
+            }
+
+            return;
+        }
+
+        if ([[track playerState] isEqualToString:@"Paused"]) {
+            if (currentResumedAt) {
+                currentPlayedTime += now - currentResumedAt;
+                currentResumedAt = 0;
+            }
+
+            return;
+        }
+    }
+
+    [self finishCurrentPlayAt:now];
+
+    if ([track isPlaying] && [track persistentID]) {
+        currentTrack = [track retain];
+        currentStartedAt = SIMillisecondsSince1970();
+        currentPlayedTime = 0;
+        currentResumedAt = now;
+    }
+}
+
+#pragma mark - Journal queue
+
+- (void)synchronizeJournal {
+    NSError *error = nil;
+
+    if (![journal synchronize:&error]) {
+        NSLog(@"Cannot write the play history to %@: %@", [journal directory], error);
+        return;
+    }
+
+    [scrobbleQueue journalDidSynchronize];
+}
+
+- (void)compactJournalRemovingPlaysBefore:(NSNumber *)startedAt {
+    NSError *error = nil;
+    uint64_t exportedSequence = scrobbleQueue ? [scrobbleQueue exportedSequence] : UINT64_MAX;
+
+    if (![journal compactRemovingPlaysBefore:[startedAt unsignedLongLongValue]
+                   keepingPlaysAfterSequence:exportedSequence
+                                       error:&error]) {
+        NSLog(@"Cannot compact the play history in %@: %@", [journal directory], error);
+    }
+}
+
+- (void)synchronize {
+    // A synchronization still waiting to run will pick these plays up.
+    if ([journalQueue operationCount] > 1) {
+        return;
+    }
+
+    [journalQueue addOperation:[[[NSInvocationOperation alloc] initWithTarget:self
+                                                                     selector:@selector(synchronizeJournal)
+                                                                       object:nil] autorelease]];
+}
+
+- (void)compact {
+    if (retentionInterval <= 0) {
+        return;
+    }
+
+    NSNumber *startedAt = [NSNumber numberWithUnsignedLongLong:SIMillisecondsSince1970() - (uint64_t)(retentionInterval * 1000)];
+
+    [journalQueue addOperation:[[[NSInvocationOperation alloc] initWithTarget:self
+                                                                     selector:@selector(compactJournalRemovingPlaysBefore:)
+                                                                       object:startedAt] autorelease]];
+}
+
+- (void)synchronizeTimerDidFire:(NSTimer *)timer {
+    if ([journal pendingPlayCount]) {
+        [self synchronize];
+    }
+}
+
+- (void)compactionTimerDidFire:(NSTimer *)timer {
+    [self compact];
+}
+
+- (void)stop {
+    [self finishCurrentPlayAt:SIMonotonicNanoseconds()];
+    [self setSynchronizeInterval:0];
+    [compactionTimer invalidate];
+    [compactionTimer release];
+    compactionTimer = nil;
+
+    [journalQueue addOperation:[[[NSInvocationOperation alloc] initWithTarget:self
+                                                                     selector:@selector(synchronizeJournal)
+                                                                       object:nil] autorelease]];
+    [journalQueue waitUntilAllOperationsAreFinished];
+}
+
+- (NSString *)statisticsSummary {
+    return [NSString stringWithFormat:@"history: %lu plays, %lu waiting to be written, %lu strings, %llu writes",
+        (unsigned long)[journal playCount],
+        (unsigned long)[journal pendingPlayCount],
+        (unsigned long)[journal stringCount],
+        [journal synchronizeCount]];
+}
+
+@end
@@ -0,0 +1,109 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#define SIPlayJournalMagic 0x4c4e524a59414c50ULL
+#define SIPlayJournalVersion 1
+
+// One play, as stored. Strings are IDs into the journal's string table, zero
+// for none; times are in milliseconds, startedAt since 1970. The checksum
+// covers the bytes before it, so a record torn by a crash is recognised.
+typedef struct SIPlayRecord {
+    uint64_t sequence;
+    uint64_t persistentID;
+    uint64_t startedAt;
+    uint32_t playedTime;
+    uint32_t nameID;
+    uint32_t artistID;
+    uint32_t albumID;
+    uint32_t reserved;
+    uint32_t checksum;
+} SIPlayRecord;
+
+// An append-only history of plays. Records are fixed-size and numbered by a
+// sequence that only grows; names, artists and albums are interned in a
+// string table beside them, so a play costs 48 bytes however long its
+// strings are.
+//
+// Appending only buffers the play; synchronize writes everything buffered
+// with one write per file and one fsync each, string table first, so a
+// crash loses at most the plays since the last synchronize and never leaves
+// a record naming a string that is not on disk. Torn records at the end of
+// either file are cut off when the journal is opened.
+//
+// Compaction rewrites both files without old plays and the strings only
+// they used. The string table is named by a generation recorded in the
+// journal header, and the journal is renamed into place last, so a crash
+// during compaction leaves either the old pair or the new one. All methods
+// are thread-safe.
+@interface SIPlayJournal : NSObject {
+    NSString *directory;
+    int journalDescriptor;
+    int stringsDescriptor;
+    uint32_t generation;
+    unsigned long long journalLength;
+    unsigned long long stringsLength;
+    NSMutableArray *strings;
+    NSMutableDictionary *stringIDs;
+    NSMutableData *pendingRecords;
+    NSMutableData *pendingStrings;
+    uint64_t nextSequence;
+    NSUInteger durablePlayCount;
+    unsigned long long synchronizeCount;
+    NSLock *lock;
+    NSLock *fileLock;
+}
+
+@property (nonatomic, readonly) NSString *directory;
+
+- (id)initWithDirectory:(NSString *)aDirectory error:(NSError **)error;
+
+// Buffers a play and returns how many plays are buffered.
+- (NSUInteger)appendPlayWithPersistentID:(uint64_t)persistentID
+                                    name:(NSString *)name
+                                  artist:(NSString *)artist
+                                   album:(NSString *)album
+                               startedAt:(uint64_t)startedAt
+                              playedTime:(uint32_t)playedTime;
+
+- (BOOL)synchronize:(NSError **)error;
+
+// Up to limit synchronized plays after sequence, oldest first, as
+// dictionaries with the keys sequence, persistentID (hexadecimal, as in
+// SITrack), name, artist, album, startedAt and playedTime.
+- (NSArray *)playsAfterSequence:(uint64_t)sequence limit:(NSUInteger)limit;
+
+// The sequence of the last play appended, buffered or not; zero for none.
+- (uint64_t)lastSequence;
+
+- (NSUInteger)playCount;
+- (NSUInteger)pendingPlayCount;
+- (NSUInteger)stringCount;
+- (unsigned long long)synchronizeCount;
+
+// Drops the plays that started before startedAt, keeping those after
+// sequence, which have yet to be exported. Synchronizes first; appends wait
+// until it is done.
+- (BOOL)compactRemovingPlaysBefore:(uint64_t)startedAt
+         keepingPlaysAfterSequence:(uint64_t)sequence
+                             error:(NSError **)error;
+
+@end
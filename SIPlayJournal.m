@@ -0,0 +1,727 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <errno.h>
+#import <fcntl.h>
+#import <stddef.h>
+#import <sys/stat.h>
+#import <unistd.h>
+#import "SIPlayJournal.h"
+#import "SIContentHash.h"
+#import "SIUnixSocketServer.h"
+
+#define SIPlayStringsMagic 0x53474e5259414c50ULL
+
+static NSString *const SIPlayJournalFileName = @"History.journal";
+static NSString *const SIPlayStringsFilePrefix = @"History-";
+static NSString *const SIPlayStringsFileExtension = @"strings";
+
+// nextSequence carries the sequence over a compaction that drops the last
+// plays, so that sequences are never reused.
+typedef struct SIPlayJournalHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t generation;
+    uint64_t nextSequence;
+} SIPlayJournalHeader;
+
+// Each string in the table: this header, then length bytes of UTF-8.
+typedef struct SIPlayStringHeader {
+    uint32_t length;
+    uint32_t checksum;
+} SIPlayStringHeader;
+
+static uint32_t SIPlayChecksum(const void *bytes, size_t length) {
+    return (uint32_t)SIContentHash64(bytes, length, 0);
+}
+
+static void SIPlayRecordSeal(SIPlayRecord *record) {
+    record->checksum = SIPlayChecksum(record, offsetof(SIPlayRecord, checksum));
+}
+
+static BOOL SIPlayRecordIsIntact(const SIPlayRecord *record) {
+    return record->checksum == SIPlayChecksum(record, offsetof(SIPlayRecord, checksum));
+}
+
+static BOOL SIPlayWrite(int fileDescriptor, const void *bytes, size_t length, off_t offset) {
+    const char *cursor = bytes;
+
+    while (length > 0) {
+        ssize_t written = pwrite(fileDescriptor, cursor, length, offset);
+
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            return NO;
+        }
+
+        cursor += written;
+        length -= (size_t)written;
+        offset += written;
+    }
+
+    return YES;
+}
+
+static int SIPlayOpen(NSString *path, int flags) {
+    int fileDescriptor = open([path fileSystemRepresentation], flags, 0644);
+
+    if (fileDescriptor >= 0) {
+        fcntl(fileDescriptor, F_SETFD, FD_CLOEXEC);
+    }
+
+    return fileDescriptor;
+}
+
+@implementation SIPlayJournal
+
+@synthesize directory;
+
+- (id)init {
+    return [self initWithDirectory:nil error:NULL];
+}
+
+- (id)initWithDirectory:(NSString *)aDirectory error:(NSError **)error {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    directory = [aDirectory copy];
+    journalDescriptor = -1;
+    stringsDescriptor = -1;
+    strings = [[NSMutableArray alloc] initWithObjects:@"", nil];
+    stringIDs = [[NSMutableDictionary alloc] init];
+    pendingRecords = [[NSMutableData alloc] init];
+    pendingStrings = [[NSMutableData alloc] init];
+    nextSequence = 1;
+    lock = [[NSLock alloc] init];
+    fileLock = [[NSLock alloc] init];
+
+    NSError *openError = nil;
+    if (![[NSFileManager defaultManager] createDirectoryAtPath:directory
+                                   withIntermediateDirectories:YES
+                                                    attributes:nil
+                                                         error:&openError]
+        || ![self openJournal:&openError]
+        || ![self openStrings:&openError]) {
+        if (error) {
+            *error = openError;
+        }
+
+        [self release];
+        return nil;
+    }
+
+    [self removeStaleFiles];
+
+    return self;
+}
+
+- (void)dealloc {
+    if (journalDescriptor >= 0) {
+        close(journalDescriptor);
+    }
+
+    if (stringsDescriptor >= 0) {
+        close(stringsDescriptor);
+    }
+
+    [directory release];
+    [strings release];
+    [stringIDs release];
+    [pendingRecords release];
+    [pendingStrings release];
+    [lock release];
+    [fileLock release];
+
+    [super dealloc];
+}
+
+#pragma mark - Files
+
+- (NSString *)journalPath {
+    return [directory stringByAppendingPathComponent:SIPlayJournalFileName];
+}
+
+- (NSString *)stringsPathForGeneration:(uint32_t)aGeneration {
+    NSString *name = [NSString stringWithFormat:@"%@%u", SIPlayStringsFilePrefix, aGeneration];
+
+    return [directory stringByAppendingPathComponent:[name stringByAppendingPathExtension:SIPlayStringsFileExtension]];
+}
+
+- (NSError *)corruptFileErrorForPath:(NSString *)path {
+    return [NSError errorWithDomain:NSCocoaErrorDomain
+                               code:NSFileReadCorruptFileError
+                           userInfo:@{NSFilePathErrorKey : path}];
+}
+
+// Reads the records back, cutting the file off at the first one that is
+// torn or out of sequence.
+- (BOOL)openJournal:(NSError **)error {
+    NSString *path = [self journalPath];
+    SIPlayJournalHeader header;
+    struct stat status;
+
+    journalDescriptor = SIPlayOpen(path, O_RDWR | O_CREAT);
+    if (journalDescriptor < 0 || fstat(journalDescriptor, &status) != 0) {
+        *error = SIPOSIXError(errno);
+        return NO;
+    }
+
+    if (status.st_size < (off_t)sizeof(header)) {
+        header.magic = SIPlayJournalMagic;
+        header.version = SIPlayJournalVersion;
+        header.generation = 1;
+        header.nextSequence = 1;
+
+        if (ftruncate(journalDescriptor, 0) != 0
+            || !SIPlayWrite(journalDescriptor, &header, sizeof(header), 0)
+            || fsync(journalDescriptor) != 0) {
+            *error = SIPOSIXError(errno);
+            return NO;
+        }
+
+        generation = header.generation;
+        journalLength = sizeof(header);
+        return YES;
+    }
+
+    if (pread(journalDescriptor, &header, sizeof(header), 0) != sizeof(header)
+        || header.magic != SIPlayJournalMagic
+        || header.version != SIPlayJournalVersion) {
+        *error = [self corruptFileErrorForPath:path];
+        return NO;
+    }
+
+    generation = header.generation;
+
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:error];
+    if (!data) {
+        return NO;
+    }
+
+    const SIPlayRecord *records = (const SIPlayRecord *)((const char *)[data bytes] + sizeof(header));
+    NSUInteger recordCount = ([data length] - sizeof(header)) / sizeof(SIPlayRecord);
+    uint64_t lastSequence = 0;
+    NSUInteger intactCount = 0;
+
+    while (intactCount < recordCount) {
+        SIPlayRecord record;
+        memcpy(&record, &records[intactCount], sizeof(record));
+
+        if (!SIPlayRecordIsIntact(&record) || record.sequence <= lastSequence) {
+            break;
+        }
+
+        lastSequence = record.sequence;
+        intactCount++;
+    }
+
+    journalLength = sizeof(header) + (unsigned long long)intactCount * sizeof(SIPlayRecord);
+    durablePlayCount = intactCount;
+    nextSequence = MAX(lastSequence + 1, header.nextSequence);
+
+    if (journalLength < (unsigned long long)status.st_size && ftruncate(journalDescriptor, (off_t)journalLength) != 0) {
+        *error = SIPOSIXError(errno);
+        return NO;
+    }
+
+    return YES;
+}
+
+- (BOOL)openStrings:(NSError **)error {
+    NSString *path = [self stringsPathForGeneration:generation];
+    uint64_t magic = SIPlayStringsMagic;
+    struct stat status;
+
+    stringsDescriptor = SIPlayOpen(path, O_RDWR | O_CREAT);
+    if (stringsDescriptor < 0 || fstat(stringsDescriptor, &status) != 0) {
+        *error = SIPOSIXError(errno);
+        return NO;
+    }
+
+    if (status.st_size < (off_t)sizeof(magic)) {
+        if (ftruncate(stringsDescriptor, 0) != 0
+            || !SIPlayWrite(stringsDescriptor, &magic, sizeof(magic), 0)
+            || fsync(stringsDescriptor) != 0) {
+            *error = SIPOSIXError(errno);
+            return NO;
+        }
+
+        stringsLength = sizeof(magic);
+        return YES;
+    }
+
+    NSData *data = [NSData dataWithContentsOfFile:path options:NSDataReadingMappedIfSafe error:error];
+    if (!data) {
+        return NO;
+    }
+
+    const char *bytes = [data bytes];
+    NSUInteger length = [data length];
+    NSUInteger offset = sizeof(magic);
+
+    memcpy(&magic, bytes, sizeof(magic));
+    if (magic != SIPlayStringsMagic) {
+        *error = [self corruptFileErrorForPath:path];
+        return NO;
+    }
+
+    while (offset + sizeof(SIPlayStringHeader) <= length) {
+        SIPlayStringHeader header;
+        memcpy(&header, bytes + offset, sizeof(header));
+
+        const char *stringBytes = bytes + offset + sizeof(header);
+        if (header.length > length - offset - sizeof(header)
+            || header.checksum != SIPlayChecksum(stringBytes, header.length)) {
+            break;
+        }
+
+        NSString *string = [[[NSString alloc] initWithBytes:stringBytes
+                                                     length:header.length
+                                                   encoding:NSUTF8StringEncoding] autorelease];
+        if (!string) {
+            break;
+        }
+
+        [stringIDs setObject:[NSNumber numberWithUnsignedInteger:[strings count]] forKey:string];
+        [strings addObject:string];
+        offset += sizeof(header) + header.length;
+    }
+
+    stringsLength = offset;
+
+    if (offset < length && ftruncate(stringsDescriptor, (off_t)offset) != 0) {
+        *error = SIPOSIXError(errno);
+        return NO;
+    }
+
+    return YES;
+}
+
+// Compaction leaves the previous string table behind if it is interrupted
+// after the new journal is in place.
+- (void)removeStaleFiles {
+    NSFileManager *fileManager = [NSFileManager defaultManager];
+    NSString *current = [[self stringsPathForGeneration:generation] lastPathComponent];
+
+    for (NSString *name in [fileManager contentsOfDirectoryAtPath:directory error:NULL]) {
+        BOOL staleStrings = [name hasPrefix:SIPlayStringsFilePrefix]
+            && [[name pathExtension] isEqualToString:SIPlayStringsFileExtension]
+            && ![name isEqualToString:current];
+        BOOL staleJournal = [name isEqualToString:[SIPlayJournalFileName stringByAppendingPathExtension:@"compact"]];
+
+        if (staleStrings || staleJournal) {
+            [fileManager removeItemAtPath:[directory stringByAppendingPathComponent:name] error:NULL];
+        }
+    }
+}
+
+#pragma mark - Appending
+
+- (uint32_t)internString:(NSString *)string {
+    if (![string length]) {
+        return 0;
+    }
+
+    NSNumber *stringID = [stringIDs objectForKey:string];
+    if (stringID) {
+        return (uint32_t)[stringID unsignedIntegerValue];
+    }
+
+    NSData *bytes = [string dataUsingEncoding:NSUTF8StringEncoding];
+    SIPlayStringHeader header = { (uint32_t)[bytes length], SIPlayChecksum([bytes bytes], [bytes length]) };
+    uint32_t newID = (uint32_t)[strings count];
+
+    [pendingStrings appendBytes:&header length:sizeof(header)];
+    [pendingStrings appendData:bytes];
+    [strings addObject:string];
+    [stringIDs setObject:[NSNumber numberWithUnsignedInt:newID] forKey:string];
+
+    return newID;
+}
+
+- (NSUInteger)appendPlayWithPersistentID:(uint64_t)persistentID
+                                    name:(NSString *)name
+                                  artist:(NSString *)artist
+                                   album:(NSString *)album
+                               startedAt:(uint64_t)startedAt
+                              playedTime:(uint32_t)playedTime {
+    SIPlayRecord record;
+    memset(&record, 0, sizeof(record));
+
+    [lock lock];
+    record.sequence = nextSequence++;
+    record.persistentID = persistentID;
+    record.startedAt = startedAt;
+    record.playedTime = playedTime;
+    record.nameID = [self internString:name];
+    record.artistID = [self internString:artist];
+    record.albumID = [self internString:album];
+    SIPlayRecordSeal(&record);
+
+    [pendingRecords appendBytes:&record length:sizeof(record)];
+    NSUInteger pendingCount = [pendingRecords length] / sizeof(SIPlayRecord);
+    [lock unlock];
+
+    return pendingCount;
+}
+
+- (void)restorePendingRecords:(NSMutableData *)records strings:(NSMutableData *)newStrings {
+    [lock lock];
+    [records appendData:pendingRecords];
+    [pendingRecords setData:records];
+
+    if (newStrings) {
+        [newStrings appendData:pendingStrings];
+        [pendingStrings setData:newStrings];
+    }
+    [lock unlock];
+}
+
+// The caller holds fileLock. Appends go on while the files are written.
+- (BOOL)synchronizeHoldingFileLock:(NSError **)error {
+    [lock lock];
+    NSMutableData *records = [[pendingRecords retain] autorelease];
+    NSMutableData *newStrings = [[pendingStrings retain] autorelease];
+    [pendingRecords release];
+    pendingRecords = [[NSMutableData alloc] init];
+    [pendingStrings release];
+    pendingStrings = [[NSMutableData alloc] init];
+    [lock unlock];
+
+    if (![records length] && ![newStrings length]) {
+        return YES;
+    }
+
+    if ([newStrings length]) {
+        if (!SIPlayWrite(stringsDescriptor, [newStrings bytes], [newStrings length], (off_t)stringsLength)
+            || fsync(stringsDescriptor) != 0) {
+            int writeError = errno;
+
+            ftruncate(stringsDescriptor, (off_t)stringsLength);
+            [self restorePendingRecords:records strings:newStrings];
+
+            if (error) {
+                *error = SIPOSIXError(writeError);
+            }
+
+            return NO;
+        }
+
+        stringsLength += [newStrings length];
+    }
+
+    if ([records length]) {
+        if (!SIPlayWrite(journalDescriptor, [records bytes], [records length], (off_t)journalLength)
+            || fsync(journalDescriptor) != 0) {
+            int writeError = errno;
+
+            ftruncate(journalDescriptor, (off_t)journalLength);
+            [self restorePendingRecords:records strings:nil];
+
+            if (error) {
+                *error = SIPOSIXError(writeError);
+            }
+
+            return NO;
+        }
+
+        journalLength += [records length];
+    }
+
+    [lock lock];
+    durablePlayCount += [records length] / sizeof(SIPlayRecord);
+    synchronizeCount++;
+    [lock unlock];
+
+    return YES;
+}
+
+- (BOOL)synchronize:(NSError **)error {
+    [fileLock lock];
+    BOOL synchronized = [self synchronizeHoldingFileLock:error];
+    [fileLock unlock];
+
+    return synchronized;
+}
+
+#pragma mark - Reading
+
+// The caller holds fileLock.
+- (NSUInteger)durableRecordCount {
+    return (NSUInteger)((journalLength - sizeof(SIPlayJournalHeader)) / sizeof(SIPlayRecord));
+}
+
+- (BOOL)readRecords:(SIPlayRecord *)records inRange:(NSRange)range {
+    size_t length = range.length * sizeof(SIPlayRecord);
+    off_t offset = (off_t)(sizeof(SIPlayJournalHeader) + range.location * sizeof(SIPlayRecord));
+
+    return pread(journalDescriptor, records, length, offset) == (ssize_t)length;
+}
+
+- (NSString *)stringWithID:(uint32_t)stringID {
+    return stringID < [strings count] ? [strings objectAtIndex:stringID] : @"";
+}
+
+- (NSArray *)playsAfterSequence:(uint64_t)sequence limit:(NSUInteger)limit {
+    [fileLock lock];
+
+    NSUInteger low = 0;
+    NSUInteger high = [self durableRecordCount];
+
+    while (low < high) {
+        NSUInteger middle = low + (high - low) / 2;
+        SIPlayRecord record;
+
+        if (![self readRecords:&record inRange:NSMakeRange(middle, 1)]) {
+            high = low;
+            break;
+        }
+
+        if (record.sequence <= sequence) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    NSUInteger count = MIN(limit, [self durableRecordCount] - low);
+    NSMutableData *buffer = [NSMutableData dataWithLength:count * sizeof(SIPlayRecord)];
+
+    if (count && ![self readRecords:[buffer mutableBytes] inRange:NSMakeRange(low, count)]) {
+        count = 0;
+    }
+
+    [fileLock unlock];
+
+    const SIPlayRecord *records = [buffer bytes];
+    NSMutableArray *plays = [NSMutableArray arrayWithCapacity:count];
+
+    [lock lock];
+    for (NSUInteger i = 0; i < count; i++) {
+        [plays addObject:@{
+            @"sequence"     : @(records[i].sequence),
+            @"persistentID" : [NSString stringWithFormat:@"%016llX", (unsigned long long)records[i].persistentID],
+            @"name"         : [self stringWithID:records[i].nameID],
+            @"artist"       : [self stringWithID:records[i].artistID],
+            @"album"        : [self stringWithID:records[i].albumID],
+            @"startedAt"    : @(records[i].startedAt),
+            @"playedTime"   : @(records[i].playedTime)
+        }];
+    }
+    [lock unlock];
+
+    return plays;
+}
+
+- (uint64_t)lastSequence {
+    [lock lock];
+    uint64_t sequence = nextSequence - 1;
+    [lock unlock];
+
+    return sequence;
+}
+
+- (NSUInteger)playCount {
+    [lock lock];
+    NSUInteger count = durablePlayCount + [pendingRecords length] / sizeof(SIPlayRecord);
+    [lock unlock];
+
+    return count;
+}
+
+- (NSUInteger)pendingPlayCount {
+    [lock lock];
+    NSUInteger count = [pendingRecords length] / sizeof(SIPlayRecord);
+    [lock unlock];
+
+    return count;
+}
+
+- (NSUInteger)stringCount {
+    [lock lock];
+    NSUInteger count = [strings count] - 1;
+    [lock unlock];
+
+    return count;
+}
+
+- (unsigned long long)synchronizeCount {
+    [lock lock];
+    unsigned long long count = synchronizeCount;
+    [lock unlock];
+
+    return count;
+}
+
+#pragma mark - Compaction
+
+- (uint32_t)remapStringID:(uint32_t)stringID
+                toStrings:(NSMutableArray *)newStrings
+                      IDs:(NSMutableDictionary *)newStringIDs
+                     data:(NSMutableData *)data {
+    NSString *string = [self stringWithID:stringID];
+
+    if (![string length]) {
+        return 0;
+    }
+
+    NSNumber *newID = [newStringIDs objectForKey:string];
+    if (newID) {
+        return (uint32_t)[newID unsignedIntegerValue];
+    }
+
+    NSData *bytes = [string dataUsingEncoding:NSUTF8StringEncoding];
+    SIPlayStringHeader header = { (uint32_t)[bytes length], SIPlayChecksum([bytes bytes], [bytes length]) };
+    uint32_t assignedID = (uint32_t)[newStrings count];
+
+    [data appendBytes:&header length:sizeof(header)];
+    [data appendData:bytes];
+    [newStrings addObject:string];
+    [newStringIDs setObject:[NSNumber numberWithUnsignedInt:assignedID] forKey:string];
+
+    return assignedID;
+}
+
+// Works from the strings in memory and the records both on disk and
+// buffered, so what was buffered ends up in the new files too. The caller
+// holds both locks.
+- (BOOL)compactHoldingLocksRemovingPlaysBefore:(uint64_t)startedAt
+                     keepingPlaysAfterSequence:(uint64_t)sequence
+                                         error:(NSError **)error {
+    NSUInteger durableCount = [self durableRecordCount];
+    NSMutableData *oldRecords = [NSMutableData dataWithLength:durableCount * sizeof(SIPlayRecord)];
+
+    if (durableCount && ![self readRecords:[oldRecords mutableBytes] inRange:NSMakeRange(0, durableCount)]) {
+        if (error) {
+            *error = SIPOSIXError(errno);
+        }
+
+        return NO;
+    }
+
+    [oldRecords appendData:pendingRecords];
+
+    uint64_t stringsMagic = SIPlayStringsMagic;
+    SIPlayJournalHeader header = { SIPlayJournalMagic, SIPlayJournalVersion, generation + 1, nextSequence };
+    NSMutableArray *newStrings = [NSMutableArray arrayWithObject:@""];
+    NSMutableDictionary *newStringIDs = [NSMutableDictionary dictionary];
+    NSMutableData *stringsData = [NSMutableData dataWithBytes:&stringsMagic length:sizeof(stringsMagic)];
+    NSMutableData *journalData = [NSMutableData dataWithBytes:&header length:sizeof(header)];
+    const SIPlayRecord *records = [oldRecords bytes];
+    NSUInteger recordCount = [oldRecords length] / sizeof(SIPlayRecord);
+    NSUInteger keptCount = 0;
+
+    for (NSUInteger i = 0; i < recordCount; i++) {
+        SIPlayRecord record = records[i];
+
+        if (record.startedAt < startedAt && record.sequence <= sequence) {
+            continue;
+        }
+
+        record.nameID = [self remapStringID:record.nameID toStrings:newStrings IDs:newStringIDs data:stringsData];
+        record.artistID = [self remapStringID:record.artistID toStrings:newStrings IDs:newStringIDs data:stringsData];
+        record.albumID = [self remapStringID:record.albumID toStrings:newStrings IDs:newStringIDs data:stringsData];
+        SIPlayRecordSeal(&record);
+        [journalData appendBytes:&record length:sizeof(record)];
+        keptCount++;
+    }
+
+    NSString *newStringsPath = [self stringsPathForGeneration:header.generation];
+    NSString *compactPath = [[self journalPath] stringByAppendingPathExtension:@"compact"];
+    int newStringsDescriptor = SIPlayOpen(newStringsPath, O_RDWR | O_CREAT | O_TRUNC);
+    int newJournalDescriptor = SIPlayOpen(compactPath, O_RDWR | O_CREAT | O_TRUNC);
+    BOOL written = newStringsDescriptor >= 0
+        && newJournalDescriptor >= 0
+        && SIPlayWrite(newStringsDescriptor, [stringsData bytes], [stringsData length], 0)
+        && fsync(newStringsDescriptor) == 0
+        && SIPlayWrite(newJournalDescriptor, [journalData bytes], [journalData length], 0)
+        && fsync(newJournalDescriptor) == 0
+        && rename([compactPath fileSystemRepresentation], [[self journalPath] fileSystemRepresentation]) == 0;
+
+    if (!written) {
+        int writeError = errno;
+
+        if (newStringsDescriptor >= 0) {
+            close(newStringsDescriptor);
+        }
+
+        if (newJournalDescriptor >= 0) {
+            close(newJournalDescriptor);
+        }
+
+        unlink([newStringsPath fileSystemRepresentation]);
+        unlink([compactPath fileSystemRepresentation]);
+
+        if (error) {
+            *error = SIPOSIXError(writeError);
+        }
+
+        return NO;
+    }
+
+    int directoryDescriptor = open([directory fileSystemRepresentation], O_RDONLY);
+    if (directoryDescriptor >= 0) {
+        fsync(directoryDescriptor);
+        close(directoryDescriptor);
+    }
+
+    NSString *oldStringsPath = [self stringsPathForGeneration:generation];
+    close(journalDescriptor);
+    close(stringsDescriptor);
+    unlink([oldStringsPath fileSystemRepresentation]);
+
+    journalDescriptor = newJournalDescriptor;
+    stringsDescriptor = newStringsDescriptor;
+    journalLength = [journalData length];
+    stringsLength = [stringsData length];
+    generation = header.generation;
+    durablePlayCount = keptCount;
+    [strings setArray:newStrings];
+    [stringIDs setDictionary:newStringIDs];
+    [pendingRecords setLength:0];
+    [pendingStrings setLength:0];
+    synchronizeCount++;
+
+    return YES;
+}
+
+- (BOOL)compactRemovingPlaysBefore:(uint64_t)startedAt
+         keepingPlaysAfterSequence:(uint64_t)sequence
+                             error:(NSError **)error {
+    [fileLock lock];
+    [lock lock];
+    BOOL compacted = [self compactHoldingLocksRemovingPlaysBefore:startedAt
+                                        keepingPlaysAfterSequence:sequence
+                                                            error:error];
+    [lock unlock];
+    [fileLock unlock];
+
+    return compacted;
+}
+
+@end
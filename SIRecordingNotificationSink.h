@@ -0,0 +1,43 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SINotification.h"
+
+// Stands in for a real notification sink. Keeps the most recent
+// notifications up to its capacity; with a capacity of zero it only counts
+// them and acts as a null sink.
+@interface SIRecordingNotificationSink : NSObject <SINotificationSink> {
+    NSUInteger capacity;
+    NSMutableArray *notifications;
+    NSUInteger postedCount;
+    BOOL logsNotifications;
+}
+
+@property (nonatomic, readonly) NSUInteger postedCount;
+@property (nonatomic, assign) BOOL logsNotifications;
+
+- (id)initWithCapacity:(NSUInteger)aCapacity;
+
+- (NSArray *)notifications;
+- (void)reset;
+
+@end
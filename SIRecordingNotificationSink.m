@@ -0,0 +1,80 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIRecordingNotificationSink.h"
+
+@implementation SIRecordingNotificationSink
+
+@synthesize postedCount;
+@synthesize logsNotifications;
+
+- (id)init {
+    return [self initWithCapacity:0];
+}
+
+- (id)initWithCapacity:(NSUInteger)aCapacity {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    capacity = aCapacity;
+    notifications = [[NSMutableArray alloc] initWithCapacity:capacity];
+
+    return self;
+}
+
+- (void)dealloc {
+    [notifications release];
+
+    [super dealloc];
+}
+
+- (NSArray *)notifications {
+    return [[notifications copy] autorelease];
+}
+
+- (void)reset {
+    [notifications removeAllObjects];
+    postedCount = 0;
+}
+
+- (void)postNotification:(SINotification *)notification {
+    postedCount++;
+
+    if (logsNotifications) {
+        NSLog(@"%@: %@", [notification title], [notification body]);
+    }
+
+    if (!capacity) {
+        return;
+    }
+
+    if ([notifications count] == capacity) {
+        [notifications removeObjectAtIndex:0];
+    }
+
+    [notifications addObject:notification];
+}
+
+@end
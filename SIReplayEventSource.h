@@ -0,0 +1,57 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIEventSource.h"
+#import "SIEventTrace.h"
+
+// Plays a trace back through the run loop, at its recorded pace scaled by
+// speed or, with a speed of zero, as fast as the delegate takes events. Flat
+// out it still returns to the run loop every few events so that work the
+// pipeline schedules there keeps up. A repeat count plays the trace again
+// that many times once it ends, for soaking the pipeline in a long run from
+// a short trace.
+@interface SIReplayEventSource : NSObject <SIEventSource> {
+    SIEventTrace *trace;
+    id<SIEventSourceDelegate> delegate;
+    double speed;
+    NSUInteger nextIndex;
+    NSUInteger repeatCount;
+    NSUInteger completedPassCount;
+    uint64_t startedAt;
+    BOOL running;
+}
+
+@property (nonatomic, readonly) SIEventTrace *trace;
+@property (nonatomic, readonly) double speed;
+@property (nonatomic, assign) NSUInteger repeatCount;
+
+- (id)initWithTrace:(SIEventTrace *)aTrace speed:(double)aSpeed;
+
+- (NSUInteger)replayedCount;
+
+// The offset of the event last replayed, in nanoseconds, running on across
+// repeats as if each pass followed the last a second later. Flat out, it
+// stands in for the clock of whatever should see the pace of the trace.
+- (uint64_t)traceNanoseconds;
+- (BOOL)isFinished;
+
+@end
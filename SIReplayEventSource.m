@@ -0,0 +1,142 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIClock.h"
+#import "SIReplayEventSource.h"
+
+static const NSUInteger SIReplayBatchSize = 64;
+
+@implementation SIReplayEventSource
+
+@synthesize trace;
+@synthesize speed;
+@synthesize repeatCount;
+
+- (id)init {
+    return [self initWithTrace:nil speed:1];
+}
+
+- (id)initWithTrace:(SIEventTrace *)aTrace speed:(double)aSpeed {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    trace = [aTrace retain];
+    speed = aSpeed;
+
+    return self;
+}
+
+- (void)dealloc {
+    [NSObject cancelPreviousPerformRequestsWithTarget:self];
+    [trace release];
+
+    [super dealloc];
+}
+
+- (void)setDelegate:(id<SIEventSourceDelegate>)aDelegate {
+    delegate = aDelegate;
+}
+
+- (NSUInteger)replayedCount {
+    return completedPassCount * [trace count] + nextIndex;
+}
+
+- (uint64_t)traceNanoseconds {
+    NSUInteger count = [trace count];
+
+    if (!count) {
+        return 0;
+    }
+
+    NSTimeInterval passLength = [trace offsetAtIndex:count - 1] + 1;
+    NSTimeInterval offset = nextIndex ? [trace offsetAtIndex:nextIndex - 1] : 0;
+
+    return (uint64_t)((completedPassCount * passLength + offset) * 1e9);
+}
+
+- (BOOL)isFinished {
+    return nextIndex >= [trace count] && completedPassCount >= repeatCount;
+}
+
+- (void)rewindAfterPass {
+    if (nextIndex < [trace count] || completedPassCount >= repeatCount) {
+        return;
+    }
+
+    nextIndex = 0;
+    completedPassCount++;
+    startedAt = SIMonotonicNanoseconds() - (speed > 0 ? (uint64_t)([trace offsetAtIndex:0] / speed * 1e9) : 0);
+}
+
+- (void)start {
+    if (running || [self isFinished]) {
+        return;
+    }
+
+    running = YES;
+    startedAt = SIMonotonicNanoseconds() - (speed > 0 ? (uint64_t)([trace offsetAtIndex:nextIndex] / speed * 1e9) : 0);
+    [self scheduleNextEvent];
+}
+
+- (void)stop {
+    running = NO;
+    [NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(replayEvents) object:nil];
+}
+
+- (NSTimeInterval)delayUntilNextEvent {
+    if (speed <= 0) {
+        return 0;
+    }
+
+    double due = [trace offsetAtIndex:nextIndex] / speed;
+    double elapsed = (SIMonotonicNanoseconds() - startedAt) / 1e9;
+
+    return due > elapsed ? due - elapsed : 0;
+}
+
+- (void)scheduleNextEvent {
+    if (!running || [self isFinished]) {
+        running = NO;
+        return;
+    }
+
+    [self performSelector:@selector(replayEvents) withObject:nil afterDelay:[self delayUntilNextEvent]];
+}
+
+- (void)replayEvents {
+    NSUInteger batchCount = 0;
+
+    do {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        NSDictionary *userInfo = [trace userInfoAtIndex:nextIndex++];
+        [delegate eventSource:self didReceivePlayerInfo:userInfo];
+        [self rewindAfterPass];
+        [pool drain];
+    } while (running && ![self isFinished] && ++batchCount < SIReplayBatchSize && [self delayUntilNextEvent] <= 0);
+
+    [self scheduleNextEvent];
+}
+
+@end
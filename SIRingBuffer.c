@@ -0,0 +1,93 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdlib.h>
+#include "SIRingBuffer.h"
+
+bool SIRingBufferInit(SIRingBuffer *ringBuffer, size_t capacity) {
+    size_t roundedCapacity = 1;
+
+    while (roundedCapacity < capacity) {
+        roundedCapacity <<= 1;
+    }
+
+    ringBuffer->slots = calloc(roundedCapacity, sizeof(*ringBuffer->slots));
+    if (!ringBuffer->slots) {
+        return false;
+    }
+
+    ringBuffer->mask = roundedCapacity - 1;
+    atomic_init(&ringBuffer->head, 0);
+    atomic_init(&ringBuffer->tail, 0);
+
+    return true;
+}
+
+void SIRingBufferDestroy(SIRingBuffer *ringBuffer) {
+    free((void *)ringBuffer->slots);
+    ringBuffer->slots = NULL;
+}
+
+bool SIRingBufferPush(SIRingBuffer *ringBuffer, void *value) {
+    size_t head = atomic_load_explicit(&ringBuffer->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ringBuffer->tail, memory_order_acquire);
+
+    if (head - tail > ringBuffer->mask) {
+        return false;
+    }
+
+    atomic_store_explicit(&ringBuffer->slots[head & ringBuffer->mask], value, memory_order_relaxed);
+    atomic_store_explicit(&ringBuffer->head, head + 1, memory_order_release);
+
+    return true;
+}
+
+bool SIRingBufferPop(SIRingBuffer *ringBuffer, void **value) {
+    size_t tail = atomic_load_explicit(&ringBuffer->tail, memory_order_relaxed);
+
+    for (;;) {
+        size_t head = atomic_load_explicit(&ringBuffer->head, memory_order_acquire);
+
+        if (tail == head) {
+            return false;
+        }
+
+        void *candidate = atomic_load_explicit(&ringBuffer->slots[tail & ringBuffer->mask], memory_order_relaxed);
+
+        if (atomic_compare_exchange_weak_explicit(&ringBuffer->tail, &tail, tail + 1,
+                                                  memory_order_acq_rel, memory_order_relaxed)) {
+            *value = candidate;
+            return true;
+        }
+    }
+}
+
+size_t SIRingBufferCount(SIRingBuffer *ringBuffer) {
+    size_t head = atomic_load_explicit(&ringBuffer->head, memory_order_acquire);
+    size_t tail = atomic_load_explicit(&ringBuffer->tail, memory_order_acquire);
+
+    return head - tail;
+}
+
+size_t SIRingBufferCapacity(const SIRingBuffer *ringBuffer) {
+    return ringBuffer->mask + 1;
+}
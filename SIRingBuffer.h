@@ -0,0 +1,53 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef SIRINGBUFFER_H
+#define SIRINGBUFFER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// A bounded lock-free queue of pointers for one producer thread. Any thread
+// may pop, including the producer, which lets it drop the oldest entry when
+// the queue is full.
+typedef struct SIRingBuffer {
+    _Atomic size_t head;
+    _Atomic size_t tail;
+    size_t mask;
+    void *_Atomic *slots;
+} SIRingBuffer;
+
+// Rounds capacity up to a power of two. Returns false if out of memory.
+bool SIRingBufferInit(SIRingBuffer *ringBuffer, size_t capacity);
+void SIRingBufferDestroy(SIRingBuffer *ringBuffer);
+
+// Producer only. Returns false when the queue is full.
+bool SIRingBufferPush(SIRingBuffer *ringBuffer, void *value);
+
+// Returns false when the queue is empty.
+bool SIRingBufferPop(SIRingBuffer *ringBuffer, void **value);
+
+size_t SIRingBufferCount(SIRingBuffer *ringBuffer);
+size_t SIRingBufferCapacity(const SIRingBuffer *ringBuffer);
+
+#endif
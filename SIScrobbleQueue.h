@@ -0,0 +1,75 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIPlayJournal.h"
+
+// Exports the plays in the journal to a scrobbling endpoint in batches:
+// each HTTP POST carries up to batchSize plays as {"plays": [...]}, with the
+// keys SIPlayJournal uses. The sequence of the last play accepted is saved
+// to the cursor file, so every play is sent at least once across restarts
+// and failures. A batch goes out as soon as batchSize synchronized plays are
+// waiting, and a partial one every flushInterval. Requests run one at a time
+// on the queue's own thread.
+@interface SIScrobbleQueue : NSObject {
+    SIPlayJournal *journal;
+    NSURL *URL;
+    NSString *cursorPath;
+    NSOperationQueue *operationQueue;
+    NSTimer *flushTimer;
+    NSUInteger batchSize;
+    NSTimeInterval flushInterval;
+    NSTimeInterval timeout;
+    uint64_t exportedSequence;
+    unsigned long long postedPlayCount;
+    unsigned long long postedBatchCount;
+    unsigned long long failedBatchCount;
+    BOOL failing;
+    NSLock *lock;
+}
+
+@property (nonatomic, readonly) NSURL *URL;
+@property (assign) NSUInteger batchSize;
+@property (assign) NSTimeInterval timeout;
+
+// Set from the main thread; zero flushes partial batches only when asked.
+@property (nonatomic, assign) NSTimeInterval flushInterval;
+
+- (id)initWithJournal:(SIPlayJournal *)aJournal URL:(NSURL *)aURL cursorPath:(NSString *)aCursorPath;
+
+// Sends the full batches waiting. Any thread.
+- (void)journalDidSynchronize;
+
+// Sends everything waiting, the last batch partial. Any thread.
+- (void)flush;
+
+- (void)waitUntilIdle;
+- (void)stop;
+
+// The sequence of the last play the endpoint accepted.
+- (uint64_t)exportedSequence;
+
+- (unsigned long long)postedPlayCount;
+- (unsigned long long)postedBatchCount;
+- (unsigned long long)failedBatchCount;
+- (NSString *)statisticsSummary;
+
+@end
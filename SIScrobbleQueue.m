@@ -0,0 +1,227 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIScrobbleQueue.h"
+
+@implementation SIScrobbleQueue
+
+@synthesize URL;
+@synthesize batchSize;
+@synthesize timeout;
+@synthesize flushInterval;
+
+- (id)init {
+    return [self initWithJournal:nil URL:nil cursorPath:nil];
+}
+
+- (id)initWithJournal:(SIPlayJournal *)aJournal URL:(NSURL *)aURL cursorPath:(NSString *)aCursorPath {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    journal = [aJournal retain];
+    URL = [aURL copy];
+    cursorPath = [aCursorPath copy];
+    operationQueue = [[NSOperationQueue alloc] init];
+    [operationQueue setMaxConcurrentOperationCount:1];
+    batchSize = 50;
+    timeout = 10;
+    lock = [[NSLock alloc] init];
+
+    NSString *cursor = [NSString stringWithContentsOfFile:cursorPath encoding:NSUTF8StringEncoding error:NULL];
+    exportedSequence = (uint64_t)[cursor longLongValue];
+
+    return self;
+}
+
+- (void)dealloc {
+    [flushTimer invalidate];
+    [flushTimer release];
+    [operationQueue cancelAllOperations];
+    [operationQueue waitUntilAllOperationsAreFinished];
+    [operationQueue release];
+    [journal release];
+    [URL release];
+    [cursorPath release];
+    [lock release];
+
+    [super dealloc];
+}
+
+- (void)setFlushInterval:(NSTimeInterval)aFlushInterval {
+    flushInterval = aFlushInterval;
+
+    [flushTimer invalidate];
+    [flushTimer release];
+    flushTimer = nil;
+
+    if (flushInterval > 0) {
+        flushTimer = [[NSTimer scheduledTimerWithTimeInterval:flushInterval
+                                                       target:self
+                                                     selector:@selector(flushTimerDidFire:)
+                                                     userInfo:nil
+                                                      repeats:YES] retain];
+    }
+}
+
+- (void)flushTimerDidFire:(NSTimer *)timer {
+    [self flush];
+}
+
+- (void)stop {
+    [self setFlushInterval:0];
+    [operationQueue cancelAllOperations];
+}
+
+- (void)waitUntilIdle {
+    [operationQueue waitUntilAllOperationsAreFinished];
+}
+
+- (void)exportPlaysAllowingPartialBatch:(BOOL)partial {
+    NSInvocationOperation *operation = [[[NSInvocationOperation alloc] initWithTarget:self
+                                                                             selector:@selector(exportPlays:)
+                                                                               object:[NSNumber numberWithBool:partial]] autorelease];
+    [operationQueue addOperation:operation];
+}
+
+- (void)journalDidSynchronize {
+    // An export already waiting sends everything it finds when it runs.
+    if ([operationQueue operationCount] > 1) {
+        return;
+    }
+
+    [self exportPlaysAllowingPartialBatch:NO];
+}
+
+- (void)flush {
+    [self exportPlaysAllowingPartialBatch:YES];
+}
+
+#pragma mark - Export
+
+- (BOOL)postPlays:(NSArray *)plays {
+    NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:URL
+                                                           cachePolicy:NSURLRequestReloadIgnoringLocalCacheData
+                                                       timeoutInterval:[self timeout]];
+    [request setHTTPMethod:@"POST"];
+    [request setValue:@"application/json" forHTTPHeaderField:@"Content-Type"];
+    [request setHTTPBody:[NSJSONSerialization dataWithJSONObject:@{@"plays" : plays} options:0 error:NULL]];
+
+    NSURLResponse *response = nil;
+    NSError *error = nil;
+    [NSURLConnection sendSynchronousRequest:request returningResponse:&response error:&error];
+
+    NSInteger statusCode = [response isKindOfClass:[NSHTTPURLResponse class]] ? [(NSHTTPURLResponse *)response statusCode] : 0;
+    BOOL posted = statusCode >= 200 && statusCode < 300;
+
+    // Log the first failure of a run of them only; the endpoint may be down
+    // for hours.
+    if (!posted && !failing) {
+        NSLog(@"Cannot scrobble to %@: %@", URL, error ? [error localizedDescription] : [NSString stringWithFormat:@"HTTP %ld", (long)statusCode]);
+    }
+
+    failing = !posted;
+
+    return posted;
+}
+
+- (void)exportPlays:(NSNumber *)partial {
+    for (;;) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+        NSUInteger currentBatchSize = MAX([self batchSize], (NSUInteger)1);
+        NSArray *plays = [journal playsAfterSequence:[self exportedSequence] limit:currentBatchSize];
+
+        if (![plays count] || ([plays count] < currentBatchSize && ![partial boolValue])) {
+            [pool drain];
+            break;
+        }
+
+        if (![self postPlays:plays]) {
+            [lock lock];
+            failedBatchCount++;
+            [lock unlock];
+            [pool drain];
+            break;
+        }
+
+        uint64_t sequence = [[[plays lastObject] objectForKey:@"sequence"] unsignedLongLongValue];
+        [[NSString stringWithFormat:@"%llu\n", (unsigned long long)sequence] writeToFile:cursorPath
+                                                                              atomically:YES
+                                                                                encoding:NSUTF8StringEncoding
+                                                                                   error:NULL];
+
+        [lock lock];
+        exportedSequence = sequence;
+        postedPlayCount += [plays count];
+        postedBatchCount++;
+        [lock unlock];
+
+        [pool drain];
+    }
+}
+
+#pragma mark - Statistics
+
+- (uint64_t)exportedSequence {
+    [lock lock];
+    uint64_t sequence = exportedSequence;
+    [lock unlock];
+
+    return sequence;
+}
+
+- (unsigned long long)postedPlayCount {
+    [lock lock];
+    unsigned long long count = postedPlayCount;
+    [lock unlock];
+
+    return count;
+}
+
+- (unsigned long long)postedBatchCount {
+    [lock lock];
+    unsigned long long count = postedBatchCount;
+    [lock unlock];
+
+    return count;
+}
+
+- (unsigned long long)failedBatchCount {
+    [lock lock];
+    unsigned long long count = failedBatchCount;
+    [lock unlock];
+
+    return count;
+}
+
+- (NSString *)statisticsSummary {
+    [lock lock];
+    NSString *summary = [NSString stringWithFormat:@"scrobble: %llu plays in %llu batches, %llu failed, exported through %llu",
+        postedPlayCount, postedBatchCount, failedBatchCount, (unsigned long long)exportedSequence];
+    [lock unlock];
+
+    return summary;
+}
+
+@end
@@ -0,0 +1,71 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIUnixSocketServer.h"
+
+@class SISingleInstance;
+
+@protocol SISingleInstanceDelegate <NSObject>
+
+// Handles the arguments another launch handed over; the reply is printed by
+// that launch before it exits.
+- (NSString *)singleInstance:(SISingleInstance *)singleInstance replyToArguments:(NSArray *)arguments;
+
+@end
+
+// Keeps one instance running per user. The first instance holds an advisory
+// lock on a pidfile for its lifetime and listens on a control socket; later
+// launches fail to take the lock and hand their arguments to it over the
+// socket instead. The kernel drops the lock when its holder exits, so a
+// crashed instance never blocks the next one. Both files live in a shared
+// temporary directory: a pidfile that is a symbolic link or not this user's
+// own is refused, and either end of the socket talks only to a process
+// running as the same user.
+@interface SISingleInstance : NSObject {
+    NSString *lockPath;
+    NSString *socketPath;
+    int lockFileDescriptor;
+    SIUnixSocketServer *server;
+    NSFileHandle *listeningHandle;
+    id<SISingleInstanceDelegate> delegate;
+}
+
+@property (nonatomic, readonly) NSString *lockPath;
+@property (nonatomic, readonly) NSString *socketPath;
+@property (nonatomic, assign) id<SISingleInstanceDelegate> delegate;
+
+// Places the pidfile and socket, named after name and the user, in the
+// temporary directory.
+- (id)initWithName:(NSString *)name;
+- (id)initWithLockPath:(NSString *)aLockPath socketPath:(NSString *)aSocketPath;
+
+// Returns YES if this is the only instance, which then starts listening for
+// the others.
+- (BOOL)acquire;
+
+// Sends arguments to the instance holding the lock and returns its reply.
+- (NSString *)sendArguments:(NSArray *)arguments error:(NSError **)error;
+
+// The process holding the lock, as recorded in the pidfile, or zero.
+- (pid_t)ownerProcessIdentifier;
+
+@end
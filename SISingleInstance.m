@@ -0,0 +1,309 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <errno.h>
+#import <fcntl.h>
+#import <sys/file.h>
+#import <sys/socket.h>
+#import <sys/stat.h>
+#import <sys/un.h>
+#import <unistd.h>
+#import "SISingleInstance.h"
+#import "SIPeerCredentials.h"
+
+static const NSTimeInterval SISingleInstanceConnectTimeout = 1;
+static const NSTimeInterval SISingleInstanceReplyTimeout = 2;
+static const NSUInteger SISingleInstanceMaximumRequestLength = 64 * 1024;
+
+// Opens the pidfile, which lives in a directory other users may write to.
+// Like the now-playing snapshot, it may not be a symbolic link and must be a
+// regular file this user owns with no other links, so that a planted file is
+// neither written through nor trusted.
+static int SIOpenPidfile(const char *path, int flags) {
+    int fileDescriptor = open(path, flags | O_NOFOLLOW | O_CLOEXEC, 0644);
+    struct stat status;
+
+    if (fileDescriptor < 0) {
+        return -1;
+    }
+
+    if (fstat(fileDescriptor, &status) != 0) {
+        int statError = errno;
+        close(fileDescriptor);
+        errno = statError;
+        return -1;
+    }
+
+    if (!S_ISREG(status.st_mode) || status.st_uid != geteuid() || status.st_nlink != 1) {
+        close(fileDescriptor);
+        errno = EPERM;
+        return -1;
+    }
+
+    return fileDescriptor;
+}
+
+// Whether the process at the other end of the socket runs as this user.
+static BOOL SIIsPeerThisUser(int socketDescriptor) {
+    uid_t userID;
+
+    return SIPeerUserID(socketDescriptor, &userID) == 0 && userID == geteuid();
+}
+
+@implementation SISingleInstance
+
+@synthesize lockPath;
+@synthesize socketPath;
+@synthesize delegate;
+
+- (id)init {
+    return [self initWithName:[[NSProcessInfo processInfo] processName]];
+}
+
+- (id)initWithName:(NSString *)name {
+    NSString *baseName = [NSString stringWithFormat:@"%@-%@", name, NSUserName()];
+    NSString *directory = NSTemporaryDirectory();
+
+    return [self initWithLockPath:[directory stringByAppendingPathComponent:[baseName stringByAppendingPathExtension:@"pid"]]
+                       socketPath:[directory stringByAppendingPathComponent:[baseName stringByAppendingPathExtension:@"sock"]]];
+}
+
+- (id)initWithLockPath:(NSString *)aLockPath socketPath:(NSString *)aSocketPath {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    lockPath = [aLockPath copy];
+    socketPath = [aSocketPath copy];
+    lockFileDescriptor = -1;
+
+    return self;
+}
+
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+    [listeningHandle release];
+    [server close];
+    [server release];
+
+    // The pidfile stays: unlinking it would let a launch that opened it just
+    // before lock it alongside one that creates a new file.
+    if (lockFileDescriptor >= 0) {
+        close(lockFileDescriptor);
+    }
+
+    [lockPath release];
+    [socketPath release];
+
+    [super dealloc];
+}
+
+- (BOOL)acquire {
+    if (lockFileDescriptor >= 0) {
+        return YES;
+    }
+
+    int fileDescriptor = SIOpenPidfile([lockPath fileSystemRepresentation], O_RDWR | O_CREAT);
+    if (fileDescriptor < 0) {
+        NSLog(@"Cannot open %@: %s", lockPath, strerror(errno));
+        return YES;
+    }
+
+    if (flock(fileDescriptor, LOCK_EX | LOCK_NB) != 0) {
+        close(fileDescriptor);
+        return NO;
+    }
+
+    lockFileDescriptor = fileDescriptor;
+
+    char pid[32];
+    int length = snprintf(pid, sizeof(pid), "%d\n", (int)getpid());
+    if (ftruncate(lockFileDescriptor, 0) != 0 || pwrite(lockFileDescriptor, pid, (size_t)length, 0) != length) {
+        NSLog(@"Cannot write %@: %s", lockPath, strerror(errno));
+    }
+
+    // Only the lock holder gets here, so replacing the socket cannot pull it
+    // out from under another instance.
+    NSError *error = nil;
+    server = [[SIUnixSocketServer alloc] initWithPath:socketPath error:&error];
+    if (!server) {
+        NSLog(@"Cannot listen on %@: %@", socketPath, error);
+        return YES;
+    }
+
+    listeningHandle = [[NSFileHandle alloc] initWithFileDescriptor:[server fileDescriptor] closeOnDealloc:NO];
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(clientsDidConnect:)
+                                                 name:NSFileHandleDataAvailableNotification
+                                               object:listeningHandle];
+    [listeningHandle waitForDataInBackgroundAndNotify];
+
+    return YES;
+}
+
+- (pid_t)ownerProcessIdentifier {
+    int fileDescriptor = SIOpenPidfile([lockPath fileSystemRepresentation], O_RDONLY);
+    char contents[32];
+    ssize_t length = 0;
+
+    if (fileDescriptor < 0) {
+        return 0;
+    }
+
+    length = pread(fileDescriptor, contents, sizeof(contents) - 1, 0);
+    close(fileDescriptor);
+
+    if (length <= 0) {
+        return 0;
+    }
+
+    contents[length] = '\0';
+
+    return (pid_t)atoi(contents);
+}
+
+- (void)clientsDidConnect:(NSNotification *)notification {
+    NSIndexSet *clientSockets = [server acceptPendingClients];
+    NSUInteger clientSocket = [clientSockets firstIndex];
+
+    while (clientSocket != NSNotFound) {
+        NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+
+        // Another user's request is dropped unread.
+        NSData *request = SIIsPeerThisUser((int)clientSocket)
+            ? [server readLineFromClient:(int)clientSocket
+                           maximumLength:SISingleInstanceMaximumRequestLength
+                                 timeout:0.1]
+            : nil;
+        NSArray *arguments = request ? [NSJSONSerialization JSONObjectWithData:request options:0 error:NULL] : nil;
+
+        if ([arguments isKindOfClass:[NSArray class]]) {
+            NSString *reply = [delegate singleInstance:self replyToArguments:arguments];
+            [server sendData:[reply dataUsingEncoding:NSUTF8StringEncoding] toClient:(int)clientSocket];
+        }
+
+        [server disconnectClient:(int)clientSocket];
+        [pool drain];
+
+        clientSocket = [clientSockets indexGreaterThanIndex:clientSocket];
+    }
+
+    [listeningHandle waitForDataInBackgroundAndNotify];
+}
+
+- (int)connectBeforeDate:(NSDate *)deadline error:(NSError **)error {
+    struct sockaddr_un address;
+    const char *fileSystemPath = [socketPath fileSystemRepresentation];
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, fileSystemPath, sizeof(address.sun_path) - 1);
+
+    // The holder of the lock may not be listening yet if it has only just
+    // started.
+    while (YES) {
+        int clientSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        if (clientSocket < 0) {
+            break;
+        }
+
+        // A socket another user listens on gets no arguments.
+        if (connect(clientSocket, (struct sockaddr *)&address, sizeof(address)) == 0) {
+            if (SIIsPeerThisUser(clientSocket)) {
+                return clientSocket;
+            }
+
+            close(clientSocket);
+            errno = EPERM;
+            break;
+        }
+
+        int connectError = errno;
+        close(clientSocket);
+
+        if ((connectError != ENOENT && connectError != ECONNREFUSED) || [deadline timeIntervalSinceNow] <= 0) {
+            errno = connectError;
+            break;
+        }
+
+        usleep(10000);
+    }
+
+    if (error) {
+        *error = SIPOSIXError(errno);
+    }
+
+    return -1;
+}
+
+- (NSString *)sendArguments:(NSArray *)arguments error:(NSError **)error {
+    int clientSocket = [self connectBeforeDate:[NSDate dateWithTimeIntervalSinceNow:SISingleInstanceConnectTimeout]
+                                         error:error];
+    if (clientSocket < 0) {
+        return nil;
+    }
+
+    struct timeval timeout = {(time_t)SISingleInstanceReplyTimeout, 0};
+    setsockopt(clientSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    NSMutableData *request = [NSMutableData dataWithData:[NSJSONSerialization dataWithJSONObject:arguments
+                                                                                         options:0
+                                                                                           error:NULL]];
+    [request appendBytes:"\n" length:1];
+
+    if (write(clientSocket, [request bytes], [request length]) != (ssize_t)[request length]) {
+        if (error) {
+            *error = SIPOSIXError(errno);
+        }
+
+        close(clientSocket);
+        return nil;
+    }
+
+    shutdown(clientSocket, SHUT_WR);
+
+    NSMutableData *reply = [NSMutableData data];
+    char buffer[4096];
+    ssize_t received;
+
+    while ((received = read(clientSocket, buffer, sizeof(buffer))) > 0) {
+        [reply appendBytes:buffer length:(NSUInteger)received];
+    }
+
+    int readError = errno;
+    close(clientSocket);
+
+    if (received < 0) {
+        if (error) {
+            *error = SIPOSIXError(readError);
+        }
+
+        return nil;
+    }
+
+    return [[[NSString alloc] initWithData:reply encoding:NSUTF8StringEncoding] autorelease];
+}
+
+@end
@@ -0,0 +1,84 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SILatencyHistogram.h"
+#import "SINotification.h"
+#import "SIRingBuffer.h"
+
+typedef enum SISinkQueuePolicy {
+    SISinkQueuePolicyDropNewest,
+    SISinkQueuePolicyDropOldest,
+    SISinkQueuePolicyBlock
+} SISinkQueuePolicy;
+
+// Parses "DropNewest", "DropOldest" or "Block"; anything else is DropOldest.
+extern SISinkQueuePolicy SISinkQueuePolicyFromString(NSString *string);
+
+// Feeds one sink from its own worker thread through a bounded lock-free
+// queue, so that a slow sink delays neither the others nor the main thread.
+// When the queue is full the policy decides: drop the new notification, drop
+// the oldest queued one, or block the producer for up to blockTimeout
+// seconds before dropping the new one.
+//
+// Enqueueing is for a single producer thread.
+@interface SISinkQueue : NSObject {
+    id<SINotificationSink> sink;
+    NSString *name;
+    SISinkQueuePolicy policy;
+    NSTimeInterval blockTimeout;
+    SIRingBuffer ringBuffer;
+    NSCondition *condition;
+    BOOL pending;
+    BOOL stopping;
+    BOOL finished;
+    _Atomic(unsigned long long) enqueuedCount;
+    _Atomic(unsigned long long) postedCount;
+    _Atomic(unsigned long long) droppedCount;
+    SILatencyHistogram *latency;
+}
+
+@property (nonatomic, readonly) id<SINotificationSink> sink;
+@property (nonatomic, readonly) NSString *name;
+@property (nonatomic, readonly) SISinkQueuePolicy policy;
+@property (nonatomic, assign) NSTimeInterval blockTimeout;
+
+- (id)initWithSink:(id<SINotificationSink>)aSink
+              name:(NSString *)aName
+          capacity:(NSUInteger)capacity
+            policy:(SISinkQueuePolicy)aPolicy;
+
+// Returns NO if the notification, or an older one, was dropped.
+- (BOOL)enqueueNotification:(SINotification *)notification;
+
+// Posts what is queued, then stops the worker and waits for it to exit.
+- (void)stop;
+
+- (unsigned long long)enqueuedCount;
+- (unsigned long long)postedCount;
+- (unsigned long long)droppedCount;
+
+// Time from receiving the event to the sink returning from posting it.
+- (const SILatencyHistogram *)latency;
+
+- (NSString *)statisticsSummary;
+
+@end
@@ -0,0 +1,228 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SISinkQueue.h"
+#import "SIClock.h"
+#import "SIMetrics.h"
+
+SISinkQueuePolicy SISinkQueuePolicyFromString(NSString *string) {
+    if ([string isEqual:@"DropNewest"]) {
+        return SISinkQueuePolicyDropNewest;
+    }
+
+    if ([string isEqual:@"Block"]) {
+        return SISinkQueuePolicyBlock;
+    }
+
+    return SISinkQueuePolicyDropOldest;
+}
+
+@implementation SISinkQueue
+
+@synthesize sink;
+@synthesize name;
+@synthesize policy;
+@synthesize blockTimeout;
+
+- (id)initWithSink:(id<SINotificationSink>)aSink
+              name:(NSString *)aName
+          capacity:(NSUInteger)capacity
+            policy:(SISinkQueuePolicy)aPolicy {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    if (!SIRingBufferInit(&ringBuffer, capacity > 0 ? capacity : 1)) {
+        [self release];
+        return nil;
+    }
+
+    sink = [aSink retain];
+    name = [aName copy];
+    policy = aPolicy;
+    blockTimeout = 1;
+    condition = [[NSCondition alloc] init];
+    latency = calloc(1, sizeof(SILatencyHistogram));
+
+    [NSThread detachNewThreadSelector:@selector(run) toTarget:self withObject:nil];
+
+    return self;
+}
+
+- (void)dealloc {
+    void *value;
+
+    while (SIRingBufferPop(&ringBuffer, &value)) {
+        [(SINotification *)value release];
+    }
+
+    SIRingBufferDestroy(&ringBuffer);
+    [sink release];
+    [name release];
+    [condition release];
+    free(latency);
+
+    [super dealloc];
+}
+
+- (unsigned long long)enqueuedCount {
+    return atomic_load_explicit(&enqueuedCount, memory_order_relaxed);
+}
+
+- (unsigned long long)postedCount {
+    return atomic_load_explicit(&postedCount, memory_order_relaxed);
+}
+
+- (unsigned long long)droppedCount {
+    return atomic_load_explicit(&droppedCount, memory_order_relaxed);
+}
+
+- (const SILatencyHistogram *)latency {
+    return latency;
+}
+
+- (NSString *)statisticsSummary {
+    return [NSString stringWithFormat:@"%@: enqueued=%llu posted=%llu dropped=%llu p50=%.2fms p99=%.2fms max=%.2fms",
+        name,
+        [self enqueuedCount],
+        [self postedCount],
+        [self droppedCount],
+        SILatencyHistogramPercentile(latency, 50) / 1e6,
+        SILatencyHistogramPercentile(latency, 99) / 1e6,
+        SILatencyHistogramMaximum(latency) / 1e6];
+}
+
+- (void)run {
+    NSAutoreleasePool *threadPool = [[NSAutoreleasePool alloc] init];
+
+    for (;;) {
+        void *value;
+
+        while (SIRingBufferPop(&ringBuffer, &value)) {
+            NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+            SINotification *notification = value;
+
+            uint64_t stageStart = SIMetricsBegin();
+            [sink postNotification:notification];
+            SIMetricsEnd(SIMetricsStagePost, stageStart);
+            SIMetricsCount(SIMetricsCounterNotifications);
+            SILatencyHistogramRecord(latency, SIMonotonicNanoseconds() - [notification receivedAt]);
+            atomic_fetch_add_explicit(&postedCount, 1, memory_order_relaxed);
+            [notification release];
+
+            if (policy == SISinkQueuePolicyBlock) {
+                [condition lock];
+                [condition broadcast];
+                [condition unlock];
+            }
+
+            [pool drain];
+        }
+
+        [condition lock];
+
+        while (!pending && !stopping) {
+            [condition wait];
+        }
+
+        BOOL exiting = stopping && !pending;
+        pending = NO;
+        [condition unlock];
+
+        if (exiting && !SIRingBufferCount(&ringBuffer)) {
+            break;
+        }
+    }
+
+    [condition lock];
+    finished = YES;
+    [condition broadcast];
+    [condition unlock];
+
+    [threadPool drain];
+}
+
+- (BOOL)enqueueNotification:(SINotification *)notification {
+    BOOL dropped = NO;
+
+    [notification retain];
+    atomic_fetch_add_explicit(&enqueuedCount, 1, memory_order_relaxed);
+
+    if (!SIRingBufferPush(&ringBuffer, notification)) {
+        void *oldest;
+
+        switch (policy) {
+        case SISinkQueuePolicyDropOldest:
+            if (SIRingBufferPop(&ringBuffer, &oldest)) {
+                [(SINotification *)oldest release];
+                atomic_fetch_add_explicit(&droppedCount, 1, memory_order_relaxed);
+                SIMetricsCount(SIMetricsCounterDrops);
+                dropped = YES;
+            }
+            break;
+        case SISinkQueuePolicyBlock: {
+            NSDate *deadline = [NSDate dateWithTimeIntervalSinceNow:blockTimeout];
+
+            [condition lock];
+            while (SIRingBufferCount(&ringBuffer) >= SIRingBufferCapacity(&ringBuffer) && !stopping) {
+                if (![condition waitUntilDate:deadline]) {
+                    break;
+                }
+            }
+            [condition unlock];
+            break;
+        }
+        case SISinkQueuePolicyDropNewest:
+            break;
+        }
+
+        if (!SIRingBufferPush(&ringBuffer, notification)) {
+            [notification release];
+            atomic_fetch_add_explicit(&droppedCount, 1, memory_order_relaxed);
+            SIMetricsCount(SIMetricsCounterDrops);
+            return NO;
+        }
+    }
+
+    [condition lock];
+    pending = YES;
+    [condition signal];
+    [condition unlock];
+
+    return !dropped;
+}
+
+- (void)stop {
+    [condition lock];
+    stopping = YES;
+    [condition broadcast];
+
+    while (!finished) {
+        [condition wait];
+    }
+
+    [condition unlock];
+}
+
+@end
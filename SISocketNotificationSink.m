@@ -0,0 +1,67 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SISocketNotificationSink.h"
+
+@implementation SISocketNotificationSink
+
+- (id)init {
+    return [self initWithPath:nil error:NULL];
+}
+
+- (id)initWithPath:(NSString *)path error:(NSError **)error {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    server = [[SIUnixSocketServer alloc] initWithPath:path error:error];
+    if (!server) {
+        [self release];
+        return nil;
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [server release];
+
+    [super dealloc];
+}
+
+- (void)postNotification:(SINotification *)notification {
+    [server acceptPendingClients];
+
+    if (![server clientCount]) {
+        return;
+    }
+
+    NSMutableData *line = [NSMutableData dataWithData:[NSJSONSerialization dataWithJSONObject:[notification dictionaryRepresentation]
+                                                                                      options:0
+                                                                                        error:NULL]];
+    [line appendBytes:"\n" length:1];
+    [server broadcastData:line];
+}
+
+@end
@@ -0,0 +1,145 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "SIClock.h"
+#include "SIProcessMemory.h"
+#include "SIStartupProfile.h"
+
+typedef struct SIStartupMilestone {
+    const char *name;
+    uint64_t elapsed;
+    size_t residentBytes;
+} SIStartupMilestone;
+
+static SIStartupMilestone SIStartupMilestones[SIStartupProfileCapacity];
+static size_t SIStartupMilestoneCount = 0;
+static uint64_t SIProcessStartedAt = 0;
+
+#ifdef __APPLE__
+#include <sys/sysctl.h>
+#include <sys/time.h>
+
+uint64_t SIProcessAgeNanoseconds(void) {
+    int name[] = {CTL_KERN, KERN_PROC, KERN_PROC_PID, getpid()};
+    struct kinfo_proc info;
+    size_t length = sizeof(info);
+    struct timeval now;
+
+    if (sysctl(name, 4, &info, &length, NULL, 0) != 0 || gettimeofday(&now, NULL) != 0) {
+        return 0;
+    }
+
+    struct timeval started = info.kp_proc.p_starttime;
+    int64_t age = ((int64_t)now.tv_sec - started.tv_sec) * 1000000000LL
+                + ((int64_t)now.tv_usec - started.tv_usec) * 1000LL;
+
+    return age > 0 ? (uint64_t)age : 0;
+}
+#else
+#include <time.h>
+
+uint64_t SIProcessAgeNanoseconds(void) {
+    FILE *stat = fopen("/proc/self/stat", "r");
+    char line[1024];
+    unsigned long long startTicks = 0;
+    struct timespec uptime;
+
+    if (!stat) {
+        return 0;
+    }
+
+    size_t length = fread(line, 1, sizeof(line) - 1, stat);
+    fclose(stat);
+    line[length] = '\0';
+
+    // The command name in parentheses may hold spaces; starttime is the
+    // twentieth field after it.
+    char *field = strrchr(line, ')');
+    for (int i = 0; field && i < 20; i++) {
+        field = strchr(field + 1, ' ');
+    }
+
+    if (!field || sscanf(field + 1, "%llu", &startTicks) != 1 || clock_gettime(CLOCK_BOOTTIME, &uptime) != 0) {
+        return 0;
+    }
+
+    uint64_t now = (uint64_t)uptime.tv_sec * 1000000000ULL + (uint64_t)uptime.tv_nsec;
+    uint64_t started = startTicks * 1000000000ULL / (uint64_t)sysconf(_SC_CLK_TCK);
+
+    return now > started ? now - started : 0;
+}
+#endif
+
+void SIStartupProfileMark(const char *milestone) {
+    uint64_t now = SIMonotonicNanoseconds();
+
+    if (!SIProcessStartedAt) {
+        uint64_t age = SIProcessAgeNanoseconds();
+        SIProcessStartedAt = age < now ? now - age : now;
+    }
+
+    if (SIStartupMilestoneCount >= SIStartupProfileCapacity) {
+        return;
+    }
+
+    SIStartupMilestone *entry = &SIStartupMilestones[SIStartupMilestoneCount++];
+    entry->name = milestone;
+    entry->elapsed = now - SIProcessStartedAt;
+    entry->residentBytes = SIResidentMemoryBytes();
+}
+
+size_t SIStartupProfileCount(void) {
+    return SIStartupMilestoneCount;
+}
+
+const char *SIStartupProfileMilestone(size_t index) {
+    return index < SIStartupMilestoneCount ? SIStartupMilestones[index].name : NULL;
+}
+
+uint64_t SIStartupProfileElapsed(size_t index) {
+    return index < SIStartupMilestoneCount ? SIStartupMilestones[index].elapsed : 0;
+}
+
+size_t SIStartupProfileResidentBytes(size_t index) {
+    return index < SIStartupMilestoneCount ? SIStartupMilestones[index].residentBytes : 0;
+}
+
+int SIStartupProfileFormat(char *buffer, size_t size) {
+    int written = snprintf(buffer, size, "startup:");
+    int total = written;
+
+    for (size_t i = 0; i < SIStartupMilestoneCount && written >= 0; i++) {
+        written = snprintf(buffer + ((size_t)total < size ? (size_t)total : size),
+                           (size_t)total < size ? size - (size_t)total : 0,
+                           "%s %s %.1f ms %.1f MB",
+                           i ? ";" : "",
+                           SIStartupMilestones[i].name,
+                           SIStartupMilestones[i].elapsed / 1e6,
+                           SIStartupMilestones[i].residentBytes / (1024.0 * 1024.0));
+        total += written;
+    }
+
+    return total;
+}
@@ -0,0 +1,47 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#ifndef SISTARTUPPROFILE_H
+#define SISTARTUPPROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SIStartupProfileCapacity 16
+
+// Records a startup milestone with the time since the process was executed
+// and the resident memory at that point. Milestones are static strings;
+// marks beyond the capacity are ignored. Main thread only.
+void SIStartupProfileMark(const char *milestone);
+
+size_t SIStartupProfileCount(void);
+const char *SIStartupProfileMilestone(size_t index);
+uint64_t SIStartupProfileElapsed(size_t index);
+size_t SIStartupProfileResidentBytes(size_t index);
+
+// Returns how long ago the process was executed, or zero if unknown.
+uint64_t SIProcessAgeNanoseconds(void);
+
+// Writes a one-line summary of the milestones, like snprintf.
+int SIStartupProfileFormat(char *buffer, size_t size);
+
+#endif
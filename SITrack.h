@@ -0,0 +1,53 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// The now-playing state carried by a com.apple.iTunes.playerInfo event.
+@interface SITrack : NSObject {
+    NSDictionary *userInfo;
+    NSString *persistentID;
+    NSString *name;
+    NSString *artist;
+    NSString *album;
+    NSString *playerState;
+    NSString *streamTitle;
+}
+
+@property (nonatomic, readonly) NSDictionary *userInfo;
+@property (nonatomic, copy) NSString *persistentID;
+@property (nonatomic, copy) NSString *name;
+@property (nonatomic, copy) NSString *artist;
+@property (nonatomic, copy) NSString *album;
+@property (nonatomic, copy) NSString *playerState;
+// The song a stream is playing, as its server names it, or empty.
+@property (nonatomic, copy) NSString *streamTitle;
+
++ (id)trackWithUserInfo:(NSDictionary *)aUserInfo;
+
+- (id)initWithUserInfo:(NSDictionary *)aUserInfo;
+
+- (BOOL)isPlaying;
+
+// Whether the track is a stream, going by the Stream Title iTunes sends for
+// one once its server names a song.
+- (BOOL)isStream;
+
+@end
@@ -0,0 +1,88 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SITrack.h"
+#import "SIArtworkCache.h"
+
+static NSString *SIStringFromUserInfo(NSDictionary *userInfo, NSString *key) {
+    id value = [userInfo objectForKey:key];
+
+    if (![value isKindOfClass:[NSString class]]) {
+        return @"";
+    }
+
+    return value;
+}
+
+@implementation SITrack
+
+@synthesize userInfo;
+@synthesize persistentID;
+@synthesize name;
+@synthesize artist;
+@synthesize album;
+@synthesize playerState;
+@synthesize streamTitle;
+
++ (id)trackWithUserInfo:(NSDictionary *)aUserInfo {
+    return [[[self alloc] initWithUserInfo:aUserInfo] autorelease];
+}
+
+- (id)initWithUserInfo:(NSDictionary *)aUserInfo {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    userInfo = [aUserInfo retain];
+    persistentID = [SIPersistentIDFromUserInfo(userInfo) copy];
+    name = [SIStringFromUserInfo(userInfo, @"Name") copy];
+    artist = [SIStringFromUserInfo(userInfo, @"Artist") copy];
+    album = [SIStringFromUserInfo(userInfo, @"Album") copy];
+    playerState = [SIStringFromUserInfo(userInfo, @"Player State") copy];
+    streamTitle = [SIStringFromUserInfo(userInfo, @"Stream Title") copy];
+
+    return self;
+}
+
+- (void)dealloc {
+    [userInfo release];
+    [persistentID release];
+    [name release];
+    [artist release];
+    [album release];
+    [playerState release];
+    [streamTitle release];
+
+    [super dealloc];
+}
+
+- (BOOL)isPlaying {
+    return [playerState isEqual:@"Playing"];
+}
+
+- (BOOL)isStream {
+    return [streamTitle length] > 0;
+}
+
+@end
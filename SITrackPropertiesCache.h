@@ -0,0 +1,58 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// Keeps the properties of the tracks in play, each fetched from the player in
+// one request, keyed by database ID, the ID tracks sharing the same data have
+// in common, and reachable by persistent ID. Tracks are dropped once they
+// leave play if the prefetch says so, and otherwise oldest stored first past
+// SITrackPropertiesCacheCapacity, so the cache stays small whether or not
+// prefetching runs. Thread-safe.
+extern const NSUInteger SITrackPropertiesCacheCapacity;
+
+@interface SITrackPropertiesCache : NSObject {
+    NSMutableDictionary *propertiesByDatabaseID;
+    NSMutableDictionary *databaseIDsByPersistentID;
+    NSMutableArray *storedDatabaseIDs;
+    NSLock *lock;
+    NSUInteger hits;
+    NSUInteger misses;
+}
+
+@property (nonatomic, readonly) NSUInteger hits;
+@property (nonatomic, readonly) NSUInteger misses;
+
+// The number of tracks whose properties are kept.
+- (NSUInteger)count;
+
+- (NSDictionary *)propertiesForPersistentID:(NSString *)persistentID;
+
+// One property of a track, without counting a hit or a miss, for lookups
+// that never go on to fetch.
+- (id)property:(NSString *)key forPersistentID:(NSString *)persistentID;
+
+// Stores properties holding databaseID and persistentID keys.
+- (void)storeProperties:(NSDictionary *)properties;
+
+// Drops every track but these, once they are no longer current or next.
+- (void)retainPropertiesForPersistentIDs:(NSArray *)persistentIDs;
+
+@end
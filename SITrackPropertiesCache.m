@@ -0,0 +1,142 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SITrackPropertiesCache.h"
+
+// The current track and the upcoming ones with plenty to spare.
+const NSUInteger SITrackPropertiesCacheCapacity = 64;
+
+@implementation SITrackPropertiesCache
+
+@synthesize hits;
+@synthesize misses;
+
+- (id)init {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    propertiesByDatabaseID = [[NSMutableDictionary alloc] init];
+    databaseIDsByPersistentID = [[NSMutableDictionary alloc] init];
+    storedDatabaseIDs = [[NSMutableArray alloc] init];
+    lock = [[NSLock alloc] init];
+
+    return self;
+}
+
+- (void)dealloc {
+    [propertiesByDatabaseID release];
+    [databaseIDsByPersistentID release];
+    [storedDatabaseIDs release];
+    [lock release];
+
+    [super dealloc];
+}
+
+- (NSUInteger)count {
+    [lock lock];
+    NSUInteger count = [propertiesByDatabaseID count];
+    [lock unlock];
+
+    return count;
+}
+
+- (NSDictionary *)propertiesForPersistentID:(NSString *)persistentID {
+    [lock lock];
+
+    NSNumber *databaseID = persistentID ? [databaseIDsByPersistentID objectForKey:persistentID] : nil;
+    NSDictionary *properties = databaseID ? [[[propertiesByDatabaseID objectForKey:databaseID] retain] autorelease] : nil;
+
+    if (properties) {
+        hits++;
+    } else {
+        misses++;
+    }
+
+    [lock unlock];
+
+    return properties;
+}
+
+- (id)property:(NSString *)key forPersistentID:(NSString *)persistentID {
+    [lock lock];
+
+    NSNumber *databaseID = persistentID ? [databaseIDsByPersistentID objectForKey:persistentID] : nil;
+    id property = databaseID ? [[[[propertiesByDatabaseID objectForKey:databaseID] objectForKey:key] retain] autorelease] : nil;
+
+    [lock unlock];
+
+    return property;
+}
+
+- (void)storeProperties:(NSDictionary *)properties {
+    NSNumber *databaseID = [properties objectForKey:@"databaseID"];
+    NSString *persistentID = [properties objectForKey:@"persistentID"];
+
+    if (!databaseID || !persistentID) {
+        return;
+    }
+
+    [lock lock];
+
+    [propertiesByDatabaseID setObject:properties forKey:databaseID];
+    [databaseIDsByPersistentID setObject:databaseID forKey:persistentID];
+    [storedDatabaseIDs removeObject:databaseID];
+    [storedDatabaseIDs addObject:databaseID];
+
+    while ([storedDatabaseIDs count] > SITrackPropertiesCacheCapacity) {
+        NSNumber *oldestDatabaseID = [storedDatabaseIDs objectAtIndex:0];
+
+        [databaseIDsByPersistentID removeObjectsForKeys:[databaseIDsByPersistentID allKeysForObject:oldestDatabaseID]];
+        [propertiesByDatabaseID removeObjectForKey:oldestDatabaseID];
+        [storedDatabaseIDs removeObjectAtIndex:0];
+    }
+
+    [lock unlock];
+}
+
+- (void)retainPropertiesForPersistentIDs:(NSArray *)persistentIDs {
+    [lock lock];
+
+    NSMutableDictionary *retainedDatabaseIDs = [NSMutableDictionary dictionaryWithCapacity:[persistentIDs count]];
+    NSMutableDictionary *retainedProperties = [NSMutableDictionary dictionaryWithCapacity:[persistentIDs count]];
+
+    for (NSString *persistentID in persistentIDs) {
+        NSNumber *databaseID = [databaseIDsByPersistentID objectForKey:persistentID];
+        NSDictionary *properties = databaseID ? [propertiesByDatabaseID objectForKey:databaseID] : nil;
+
+        if (properties) {
+            [retainedDatabaseIDs setObject:databaseID forKey:persistentID];
+            [retainedProperties setObject:properties forKey:databaseID];
+        }
+    }
+
+    [databaseIDsByPersistentID setDictionary:retainedDatabaseIDs];
+    [propertiesByDatabaseID setDictionary:retainedProperties];
+    [storedDatabaseIDs filterUsingPredicate:[NSPredicate predicateWithFormat:@"SELF IN %@", [retainedProperties allKeys]]];
+
+    [lock unlock];
+}
+
+@end
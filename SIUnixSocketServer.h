@@ -0,0 +1,64 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+// A UNIX domain stream socket that local clients connect to. Sockets are
+// non-blocking: accepting never waits, and a client that cannot take a whole
+// message at once is disconnected rather than allowed to stall the server.
+// Thread-safe.
+@interface SIUnixSocketServer : NSObject {
+    NSString *path;
+    int listeningSocket;
+    NSMutableIndexSet *clientSockets;
+    NSLock *lock;
+}
+
+@property (nonatomic, readonly) NSString *path;
+
+// Replaces a stale socket file at path.
+- (id)initWithPath:(NSString *)aPath error:(NSError **)error;
+
+- (int)fileDescriptor;
+- (NSUInteger)clientCount;
+
+// Returns the sockets of the clients that were accepted.
+- (NSIndexSet *)acceptPendingClients;
+
+// Writes data to one client, disconnecting it on failure.
+- (BOOL)sendData:(NSData *)data toClient:(int)clientSocket;
+
+// Reads from one client up to a newline, which is not returned, or the end of
+// its data. Waits at most timeout seconds; returns nil if the line does not
+// arrive in time or is longer than maximumLength.
+- (NSData *)readLineFromClient:(int)clientSocket
+                 maximumLength:(NSUInteger)maximumLength
+                       timeout:(NSTimeInterval)timeout;
+
+- (void)disconnectClient:(int)clientSocket;
+
+// Writes data to every client and returns the number that received it.
+- (NSUInteger)broadcastData:(NSData *)data;
+
+- (void)close;
+
+@end
+
+extern NSError *SIPOSIXError(int code);
@@ -0,0 +1,280 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import <errno.h>
+#import <fcntl.h>
+#import <poll.h>
+#import <sys/socket.h>
+#import <sys/un.h>
+#import <unistd.h>
+#import "SIClock.h"
+#import "SIUnixSocketServer.h"
+
+#ifdef MSG_NOSIGNAL
+#define SISendFlags MSG_NOSIGNAL
+#else
+#define SISendFlags 0
+#endif
+
+NSError *SIPOSIXError(int code) {
+    return [NSError errorWithDomain:NSPOSIXErrorDomain code:code userInfo:nil];
+}
+
+static BOOL SISetNonBlocking(int fileDescriptor) {
+    int flags = fcntl(fileDescriptor, F_GETFL, 0);
+
+    if (flags < 0) {
+        return NO;
+    }
+
+    return fcntl(fileDescriptor, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static void SIDisableSIGPIPE(int fileDescriptor) {
+#ifdef SO_NOSIGPIPE
+    int value = 1;
+    setsockopt(fileDescriptor, SOL_SOCKET, SO_NOSIGPIPE, &value, sizeof(value));
+#endif
+}
+
+@implementation SIUnixSocketServer
+
+@synthesize path;
+
+- (id)init {
+    return [self initWithPath:nil error:NULL];
+}
+
+- (id)initWithPath:(NSString *)aPath error:(NSError **)error {
+    self = [super init];
+
+    if (!self) {
+        return nil;
+    }
+
+    path = [aPath copy];
+    listeningSocket = -1;
+    clientSockets = [[NSMutableIndexSet alloc] init];
+    lock = [[NSLock alloc] init];
+
+    struct sockaddr_un address;
+    const char *fileSystemPath = [path fileSystemRepresentation];
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (!fileSystemPath || strlen(fileSystemPath) >= sizeof(address.sun_path)) {
+        if (error) {
+            *error = SIPOSIXError(ENAMETOOLONG);
+        }
+
+        [self release];
+        return nil;
+    }
+
+    strncpy(address.sun_path, fileSystemPath, sizeof(address.sun_path) - 1);
+    [[NSFileManager defaultManager] createDirectoryAtPath:[path stringByDeletingLastPathComponent]
+                              withIntermediateDirectories:YES
+                                               attributes:nil
+                                                    error:NULL];
+    unlink(fileSystemPath);
+
+    listeningSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listeningSocket < 0
+        || bind(listeningSocket, (struct sockaddr *)&address, sizeof(address)) != 0
+        || listen(listeningSocket, 16) != 0
+        || !SISetNonBlocking(listeningSocket)) {
+        if (error) {
+            *error = SIPOSIXError(errno);
+        }
+
+        [self release];
+        return nil;
+    }
+
+    return self;
+}
+
+- (void)dealloc {
+    [self close];
+    [path release];
+    [clientSockets release];
+    [lock release];
+
+    [super dealloc];
+}
+
+- (int)fileDescriptor {
+    return listeningSocket;
+}
+
+- (NSUInteger)clientCount {
+    [lock lock];
+    NSUInteger count = [clientSockets count];
+    [lock unlock];
+
+    return count;
+}
+
+- (NSIndexSet *)acceptPendingClients {
+    NSMutableIndexSet *acceptedSockets = [NSMutableIndexSet indexSet];
+
+    if (listeningSocket < 0) {
+        return acceptedSockets;
+    }
+
+    int clientSocket;
+
+    while ((clientSocket = accept(listeningSocket, NULL, NULL)) >= 0) {
+        SISetNonBlocking(clientSocket);
+        SIDisableSIGPIPE(clientSocket);
+
+        [lock lock];
+        [clientSockets addIndex:(NSUInteger)clientSocket];
+        [lock unlock];
+
+        [acceptedSockets addIndex:(NSUInteger)clientSocket];
+    }
+
+    return acceptedSockets;
+}
+
+- (BOOL)sendData:(NSData *)data toClient:(int)clientSocket {
+    BOOL sent = NO;
+
+    [lock lock];
+
+    if ([clientSockets containsIndex:(NSUInteger)clientSocket]) {
+        sent = send(clientSocket, [data bytes], [data length], SISendFlags) == (ssize_t)[data length];
+
+        if (!sent) {
+            close(clientSocket);
+            [clientSockets removeIndex:(NSUInteger)clientSocket];
+        }
+    }
+
+    [lock unlock];
+
+    return sent;
+}
+
+- (NSData *)readLineFromClient:(int)clientSocket
+                 maximumLength:(NSUInteger)maximumLength
+                       timeout:(NSTimeInterval)timeout {
+    NSMutableData *line = [NSMutableData data];
+    uint64_t deadline = SIMonotonicNanoseconds() + (uint64_t)(timeout * 1e9);
+    char buffer[1024];
+
+    while ([line length] <= maximumLength) {
+        ssize_t received = recv(clientSocket, buffer, sizeof(buffer), 0);
+
+        if (received == 0) {
+            return line;
+        }
+
+        if (received > 0) {
+            char *newline = memchr(buffer, '\n', (size_t)received);
+
+            if (newline) {
+                [line appendBytes:buffer length:(NSUInteger)(newline - buffer)];
+                return [line length] <= maximumLength ? line : nil;
+            }
+
+            [line appendBytes:buffer length:(NSUInteger)received];
+            continue;
+        }
+
+        uint64_t now = SIMonotonicNanoseconds();
+        if ((errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) || now >= deadline) {
+            return nil;
+        }
+
+        struct pollfd pollDescriptor = {clientSocket, POLLIN, 0};
+        poll(&pollDescriptor, 1, (int)((deadline - now) / 1000000) + 1);
+    }
+
+    return nil;
+}
+
+- (void)disconnectClient:(int)clientSocket {
+    [lock lock];
+
+    if ([clientSockets containsIndex:(NSUInteger)clientSocket]) {
+        close(clientSocket);
+        [clientSockets removeIndex:(NSUInteger)clientSocket];
+    }
+
+    [lock unlock];
+}
+
+- (NSUInteger)broadcastData:(NSData *)data {
+    NSMutableIndexSet *disconnectedSockets = [NSMutableIndexSet indexSet];
+    NSUInteger deliveredCount = 0;
+
+    [lock lock];
+
+    NSUInteger clientSocket = [clientSockets firstIndex];
+    while (clientSocket != NSNotFound) {
+        ssize_t written = send((int)clientSocket, [data bytes], [data length], SISendFlags);
+
+        if (written == (ssize_t)[data length]) {
+            deliveredCount++;
+        } else {
+            [disconnectedSockets addIndex:clientSocket];
+        }
+
+        clientSocket = [clientSockets indexGreaterThanIndex:clientSocket];
+    }
+
+    clientSocket = [disconnectedSockets firstIndex];
+    while (clientSocket != NSNotFound) {
+        close((int)clientSocket);
+        clientSocket = [disconnectedSockets indexGreaterThanIndex:clientSocket];
+    }
+
+    [clientSockets removeIndexes:disconnectedSockets];
+    [lock unlock];
+
+    return deliveredCount;
+}
+
+- (void)close {
+    [lock lock];
+
+    NSUInteger clientSocket = [clientSockets firstIndex];
+    while (clientSocket != NSNotFound) {
+        close((int)clientSocket);
+        clientSocket = [clientSockets indexGreaterThanIndex:clientSocket];
+    }
+
+    [clientSockets removeAllIndexes];
+
+    if (listeningSocket >= 0) {
+        close(listeningSocket);
+        listeningSocket = -1;
+        unlink([path fileSystemRepresentation]);
+    }
+
+    [lock unlock];
+}
+
+@end
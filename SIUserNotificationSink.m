@@ -0,0 +1,52 @@
+// The MIT License
+//
+// Copyright (c) 2013 Sorin Ionescu.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+
+#import "SIUserNotificationSink.h"
+#import "SIFrameworkLoader.h"
+
+@implementation SIUserNotificationSink
+
+- (void)postNotification:(SINotification *)notification {
+    if (![NSThread isMainThread]) {
+        [self performSelectorOnMainThread:_cmd withObject:notification waitUntilDone:NO];
+        return;
+    }
+
+    NSUserNotificationCenter *center = [NSUserNotificationCenter defaultUserNotificationCenter];
+    NSUserNotification *userNotification = [[[NSUserNotification alloc] init] autorelease];
+
+    [userNotification setTitle:[notification title]];
+    [userNotification setInformativeText:[notification body]];
+
+    if ([userNotification respondsToSelector:@selector(setIdentifier:)]) {
+        [userNotification setIdentifier:[notification identifier]];
+    }
+
+    // Images need AppKit, which is only loaded for them.
+    if ([notification iconData] && [userNotification respondsToSelector:@selector(setContentImage:)] && SILoadFramework(@"AppKit")) {
+        [userNotification setContentImage:[[[NSClassFromString(@"NSImage") alloc] initWithData:[notification iconData]] autorelease]];
+    }
+
+    [center deliverNotification:userNotification];
+}
+
+@end
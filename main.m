@@ -20,16 +20,62 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
 // THE SOFTWARE.
 
-#import <Cocoa/Cocoa.h>
+#import "SISingleInstance.h"
+#import "SIStartupProfile.h"
+
+#ifdef __APPLE__
 #import "SIITunesNotifier.h"
+#else
+#import "SIHeadlessNotifier.h"
+#endif
+
+// Hands the arguments to the running instance and prints its reply.
+static int SIForwardArguments(SISingleInstance *singleInstance) {
+    NSArray *arguments = [[NSProcessInfo processInfo] arguments];
+    NSError *error = nil;
+    NSString *reply = [singleInstance sendArguments:[arguments subarrayWithRange:NSMakeRange(1, [arguments count] - 1)]
+                                              error:&error];
+
+    if (!reply) {
+        fprintf(stderr, "%s: already running as pid %d, but cannot reach it: %s\n",
+                [[[NSProcessInfo processInfo] processName] UTF8String],
+                (int)[singleInstance ownerProcessIdentifier],
+                [[error localizedDescription] UTF8String]);
+        return 1;
+    }
+
+    fputs([reply UTF8String], stdout);
+
+    return 0;
+}
 
+// A daemon without UI: a plain Foundation run loop, no NSApplication.
 int main(int argc, char *argv[]) {
+    SIStartupProfileMark("main");
     NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
-    SIITunesNotifier *iTunesNotifier = [[[SIITunesNotifier alloc] init] autorelease];
-    [NSApplication sharedApplication];
-    [NSApp setActivationPolicy:NSApplicationActivationPolicyProhibited];
-    [NSApp setDelegate:iTunesNotifier];
-    [NSApp run];
+    SISingleInstance *singleInstance = [[[SISingleInstance alloc] initWithName:@"itunesnotify"] autorelease];
+
+    if (![singleInstance acquire]) {
+        int status = SIForwardArguments(singleInstance);
+        [pool drain];
+        return status;
+    }
+
+    SIStartupProfileMark("locked");
+
+#ifdef __APPLE__
+    SIITunesNotifier *notifier = [[[SIITunesNotifier alloc] init] autorelease];
+#else
+    SIHeadlessNotifier *notifier = [[[SIHeadlessNotifier alloc] init] autorelease];
+#endif
+
+    if (!notifier) {
+        [pool drain];
+        return 1;
+    }
+
+    [singleInstance setDelegate:[notifier service]];
+    [[NSRunLoop currentRunLoop] run];
     [pool drain];
 
     return 0;